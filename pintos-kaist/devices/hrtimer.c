@@ -0,0 +1,215 @@
+#include "devices/hrtimer.h"
+#include <debug.h>
+#include "devices/lapic.h"
+#include "devices/timer.h"
+#include "threads/cpu.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* High-resolution timers.
+
+   Pending timers are kept in one queue, earliest deadline on top,
+   and the BSP's local APIC timer is programmed in one-shot mode
+   for the earliest of them.  The 8254 drives the BSP's tick, so
+   the BSP's APIC timer is otherwise unused.  A CPU other than the
+   BSP cannot program the BSP's APIC, so when it queues a new
+   earliest timer it sends the BSP an IPI on the same vector, and
+   the BSP reprograms the countdown from the interrupt handler.
+
+   Without a local APIC there is no device to drive the queue;
+   hrtimer_sleep() then waits by polling ktime_ns(), and
+   hrtimer_start() must not be used. */
+
+/* Sleeps shorter than this many nanoseconds spin instead of
+   blocking, because the two context switches cost more than the
+   wait itself. */
+#define HRTIMER_MIN_SLEEP_NS 10000
+
+/* Pending timers, earliest deadline on top. */
+static struct heap queue;
+static struct spinlock queue_lock;
+
+/* Has hrtimer_enable() set up the device? */
+static bool enabled;
+
+static intr_handler_func hrtimer_interrupt;
+static bool expires_later (const struct heap_elem *,
+		const struct heap_elem *, void *aux);
+static void program (void);
+static void wake_sleeper (struct hrtimer *, void *sema);
+
+/* Sets up the high-resolution timer queue on the BSP's local
+   APIC timer, if there is a local APIC.  Called once on the BSP,
+   after smp_init(). */
+void
+hrtimer_enable (void) {
+	ASSERT (this_cpu () == &cpus[0]);
+
+	heap_init (&queue, expires_later, NULL);
+	spinlock_init (&queue_lock);
+	if (!lapic_present ())
+		return;
+
+	intr_register_ext (LAPIC_HRTIMER_VEC, hrtimer_interrupt, "HR Timer");
+	enabled = true;
+}
+
+/* Returns true if timers can be queued with hrtimer_start(). */
+bool
+hrtimer_available (void) {
+	return enabled;
+}
+
+/* Initializes T to call FUNC with AUX when it expires. */
+void
+hrtimer_init (struct hrtimer *t, hrtimer_func *func, void *aux) {
+	ASSERT (t != NULL);
+	ASSERT (func != NULL);
+
+	heap_elem_init (&t->elem);
+	t->expires = 0;
+	t->pending = false;
+	t->func = func;
+	t->aux = aux;
+}
+
+/* Queues T, which must not be pending, to expire at ktime_ns()
+   time EXPIRES.  T's function will be called from an interrupt
+   handler on the BSP at or soon after that time, or right away if
+   EXPIRES has already passed. */
+void
+hrtimer_start (struct hrtimer *t, uint64_t expires) {
+	enum intr_level old_level;
+	bool first;
+
+	ASSERT (enabled);
+	ASSERT (!t->pending);
+
+	old_level = intr_disable ();
+	spinlock_acquire (&queue_lock);
+	t->expires = expires;
+	t->pending = true;
+	heap_push (&queue, &t->elem);
+	first = heap_top (&queue) == &t->elem;
+	spinlock_release (&queue_lock);
+
+	/* A new earliest deadline needs a new countdown. */
+	if (first) {
+		if (this_cpu () == &cpus[0])
+			program ();
+		else
+			lapic_send_ipi (cpus[0].lapic_id, LAPIC_HRTIMER_VEC);
+	}
+	intr_set_level (old_level);
+}
+
+/* Removes T from the queue if it is pending.  Returns true if it
+   was, false if it had already expired or was never started.
+   The countdown is left alone; if T was the earliest timer, the
+   interrupt comes early and finds nothing to do. */
+bool
+hrtimer_cancel (struct hrtimer *t) {
+	enum intr_level old_level;
+	bool was_pending;
+
+	old_level = intr_disable ();
+	spinlock_acquire (&queue_lock);
+	was_pending = t->pending;
+	if (was_pending) {
+		heap_remove (&queue, &t->elem);
+		t->pending = false;
+	}
+	spinlock_release (&queue_lock);
+	intr_set_level (old_level);
+
+	return was_pending;
+}
+
+/* Blocks the current thread for at least NS nanoseconds.  Very
+   short waits, and all waits if there is no timer device, spin
+   on ktime_ns() instead.  Interrupts must be on. */
+void
+hrtimer_sleep (uint64_t ns) {
+	struct semaphore done;
+	struct hrtimer t;
+
+	ASSERT (!intr_context ());
+	ASSERT (intr_get_level () == INTR_ON);
+
+	if (!enabled || ns < HRTIMER_MIN_SLEEP_NS) {
+		uint64_t end = ktime_ns () + ns;
+
+		while (ktime_ns () < end)
+			asm volatile ("pause");
+		return;
+	}
+
+	sema_init (&done, 0);
+	hrtimer_init (&t, wake_sleeper, &done);
+	hrtimer_start (&t, ktime_ns () + ns);
+	sema_down (&done);
+}
+
+/* hrtimer_func for hrtimer_sleep(). */
+static void
+wake_sleeper (struct hrtimer *t UNUSED, void *sema) {
+	sema_up (sema);
+}
+
+/* Local APIC timer interrupt on the BSP, or an IPI from another
+   CPU that queued a new earliest timer.  Runs the expired timers
+   and programs the countdown for the next one. */
+static void
+hrtimer_interrupt (struct intr_frame *args UNUSED) {
+	uint64_t now = ktime_ns ();
+
+	spinlock_acquire (&queue_lock);
+	while (!heap_empty (&queue)) {
+		struct hrtimer *t = heap_entry (heap_top (&queue), struct hrtimer, elem);
+
+		if (t->expires > now)
+			break;
+		heap_pop (&queue);
+		t->pending = false;
+
+		/* T's function may start timers of its own. */
+		spinlock_release (&queue_lock);
+		t->func (t, t->aux);
+		spinlock_acquire (&queue_lock);
+	}
+	spinlock_release (&queue_lock);
+
+	program ();
+}
+
+/* Programs the BSP's local APIC timer for the earliest pending
+   deadline, or stops it if no timer is pending.  Must be called
+   on the BSP with interrupts off. */
+static void
+program (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (this_cpu () == &cpus[0]);
+
+	spinlock_acquire (&queue_lock);
+	if (heap_empty (&queue))
+		lapic_timer_oneshot (LAPIC_HRTIMER_VEC, 0);
+	else {
+		struct hrtimer *t = heap_entry (heap_top (&queue), struct hrtimer, elem);
+		uint64_t now = ktime_ns ();
+
+		lapic_timer_oneshot (LAPIC_HRTIMER_VEC,
+				t->expires > now ? t->expires - now : 1);
+	}
+	spinlock_release (&queue_lock);
+}
+
+/* Orders the queue so that the earliest deadline is on top. */
+static bool
+expires_later (const struct heap_elem *a_, const struct heap_elem *b_,
+		void *aux UNUSED) {
+	const struct hrtimer *a = heap_entry (a_, struct hrtimer, elem);
+	const struct hrtimer *b = heap_entry (b_, struct hrtimer, elem);
+
+	return a->expires > b->expires;
+}
@@ -3,14 +3,14 @@
 #include "threads/thread.h"
 
 static int next (int pos);
-static void wait (struct intq *q, struct thread **waiter);
-static void signal (struct intq *q, struct thread **waiter);
+static void wait (struct intq *q, struct waitq *waiter);
+static void signal (struct intq *q, struct waitq *waiter);
 
 /* Initializes interrupt queue Q. */
 void
 intq_init (struct intq *q) {
-	lock_init (&q->lock);
-	q->not_full = q->not_empty = NULL;
+	waitq_init (&q->not_full);
+	waitq_init (&q->not_empty);
 	q->head = q->tail = 0;
 }
 
@@ -39,9 +39,7 @@ intq_getc (struct intq *q) {
 	ASSERT (intr_get_level () == INTR_OFF);
 	while (intq_empty (q)) {
 		ASSERT (!intr_context ());
-		lock_acquire (&q->lock);
 		wait (q, &q->not_empty);
-		lock_release (&q->lock);
 	}
 
 	byte = q->buf[q->tail];
@@ -59,9 +57,7 @@ intq_putc (struct intq *q, uint8_t byte) {
 	ASSERT (intr_get_level () == INTR_OFF);
 	while (intq_full (q)) {
 		ASSERT (!intr_context ());
-		lock_acquire (&q->lock);
 		wait (q, &q->not_full);
-		lock_release (&q->lock);
 	}
 
 	q->buf[q->head] = byte;
@@ -76,30 +72,42 @@ next (int pos) {
 }
 
 /* WAITER must be the address of Q's not_empty or not_full
-   member.  Waits until the given condition is true. */
+   member.  Waits until the given condition is true.
+
+   The condition is checked again under WAITER's lock, which
+   signal() also takes, so a byte moved by another CPU between
+   the caller's check and ours cannot slip by unnoticed.  Any
+   number of threads may wait; signal() wakes one of them. */
 static void
-wait (struct intq *q UNUSED, struct thread **waiter) {
+wait (struct intq *q, struct waitq *waiter) {
 	ASSERT (!intr_context ());
 	ASSERT (intr_get_level () == INTR_OFF);
-	ASSERT ((waiter == &q->not_empty && intq_empty (q))
-			|| (waiter == &q->not_full && intq_full (q)));
+	ASSERT (waiter == &q->not_empty || waiter == &q->not_full);
 
-	*waiter = thread_current ();
-	thread_block ();
+	spinlock_acquire (&waiter->lock);
+	if (waiter == &q->not_empty ? intq_empty (q) : intq_full (q)) {
+		waitq_add (waiter, true);
+		waitq_block (waiter, 0);
+	}
+	spinlock_release (&waiter->lock);
 }
 
 /* WAITER must be the address of Q's not_empty or not_full
-   member, and the associated condition must be true.  If a
-   thread is waiting for the condition, wakes it up and resets
-   the waiting thread. */
+   member, and the associated condition must be true.  If any
+   threads are waiting for the condition, wakes up the one with
+   the highest priority.  Like thread_unblock(), does not
+   preempt the running thread. */
 static void
-signal (struct intq *q UNUSED, struct thread **waiter) {
+signal (struct intq *q UNUSED, struct waitq *waiter) {
+	struct list woken;
+
 	ASSERT (intr_get_level () == INTR_OFF);
 	ASSERT ((waiter == &q->not_empty && !intq_empty (q))
 			|| (waiter == &q->not_full && !intq_full (q)));
 
-	if (*waiter != NULL) {
-		thread_unblock (*waiter);
-		*waiter = NULL;
-	}
+	list_init (&woken);
+	spinlock_acquire (&waiter->lock);
+	waitq_wake (waiter, 1, &woken);
+	spinlock_release (&waiter->lock);
+	thread_unblock_list (&woken);
 }
@@ -0,0 +1,286 @@
+#include "devices/lapic.h"
+#include <debug.h>
+#include <stdio.h>
+#include "devices/timer.h"
+#include "threads/cpu.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/mmu.h"
+#include "threads/pte.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
+
+/* See [IA32-v3a] chapter 10 "Advanced Programmable Interrupt
+   Controller (APIC)" for hardware details of the local APIC. */
+
+/* IA32_APIC_BASE model-specific register. */
+#define APIC_BASE_MSR 0x1b
+#define APIC_BASE_ADDR_MASK 0xfffff000ULL
+
+/* Register offsets within the local APIC's MMIO page. */
+#define LAPIC_ID 0x020                  /* Local APIC ID. */
+#define LAPIC_TPR 0x080                 /* Task priority. */
+#define LAPIC_EOI 0x0b0                 /* End of interrupt. */
+#define LAPIC_SVR 0x0f0                 /* Spurious interrupt vector. */
+#define LAPIC_ESR 0x280                 /* Error status. */
+#define LAPIC_ICR_LO 0x300              /* Interrupt command, low half. */
+#define LAPIC_ICR_HI 0x310              /* Interrupt command, high half. */
+#define LAPIC_LVT_TIMER 0x320           /* Timer local vector. */
+#define LAPIC_LVT_LINT0 0x350           /* LINT0 local vector. */
+#define LAPIC_LVT_LINT1 0x360           /* LINT1 local vector. */
+#define LAPIC_LVT_ERROR 0x370           /* Error local vector. */
+#define LAPIC_TIMER_INIT 0x380          /* Timer initial count. */
+#define LAPIC_TIMER_CUR 0x390           /* Timer current count. */
+#define LAPIC_TIMER_DIV 0x3e0           /* Timer divide configuration. */
+
+/* Register bits. */
+#define SVR_ENABLE 0x100                /* APIC software enable. */
+#define LVT_MASKED 0x10000              /* Interrupt masked. */
+#define LVT_PERIODIC 0x20000            /* Timer periodic mode. */
+#define TIMER_DIV_16 0x3                /* Divide bus clock by 16. */
+#define ICR_INIT 0x500                  /* INIT delivery mode. */
+#define ICR_STARTUP 0x600               /* Start-up delivery mode. */
+#define ICR_PENDING 0x1000              /* Delivery status: send pending. */
+#define ICR_ASSERT 0x4000               /* Level assert. */
+#define ICR_LEVEL 0x8000                /* Level triggered. */
+
+/* CPUID.01H:EDX bit that reports an on-chip APIC. */
+#define CPUID_APIC (1 << 9)
+
+/* Kernel virtual address of the local APIC registers.  Every CPU
+   sees its own APIC at the same address. */
+static volatile uint32_t *lapic;
+
+/* Local APIC timer counts in one timer tick, measured against the
+   8254 by lapic_init(). */
+static uint32_t lapic_timer_counts;
+
+static intr_handler_func lapic_timer_interrupt;
+static intr_handler_func lapic_resched_interrupt;
+static intr_handler_func lapic_tlb_interrupt;
+static intr_handler_func lapic_spurious_interrupt;
+static void lapic_calibrate (void);
+
+static inline uint32_t
+lapic_read (int reg) {
+	return lapic[reg / 4];
+}
+
+static inline void
+lapic_write (int reg, uint32_t value) {
+	lapic[reg / 4] = value;
+	(void) lapic[LAPIC_ID / 4];         /* Wait for the write to finish. */
+}
+
+/* Maps and enables the bootstrap processor's local APIC,
+   registers the local APIC interrupts, and calibrates the APIC
+   timer against the 8254.  Returns false if the CPU has no local
+   APIC.
+
+   Only the BSP calls this, with interrupts on and the timer
+   calibrated.  The 8259A PIC stays wired to the BSP through
+   LINT0, so LINT0 is left as the firmware set it up. */
+bool
+lapic_init (void) {
+	uint32_t eax, ebx, ecx, edx;
+	uint64_t base, *pte;
+
+	asm volatile ("cpuid"
+			: "=a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx) : "a" (1));
+	if (!(edx & CPUID_APIC))
+		return false;
+
+	/* Map the register page uncached into the kernel address
+	   space.  The new page table hangs off base_pml4's kernel
+	   half, which every process's page table shares. */
+	base = read_msr (APIC_BASE_MSR) & APIC_BASE_ADDR_MASK;
+	lapic = ptov (base);
+	pte = pml4e_walk (base_pml4, (uint64_t) lapic, 1);
+	ASSERT (pte != NULL);
+	*pte = base | PTE_P | PTE_W | PTE_PCD | PTE_PWT;
+
+	lapic_write (LAPIC_SVR, SVR_ENABLE | LAPIC_SPURIOUS_VEC);
+	lapic_write (LAPIC_TPR, 0);
+
+	intr_register_ext (LAPIC_TIMER_VEC, lapic_timer_interrupt, "LAPIC Timer");
+	intr_register_ext (LAPIC_RESCHED_VEC, lapic_resched_interrupt,
+			"Reschedule IPI");
+	intr_register_ext (LAPIC_TLB_VEC, lapic_tlb_interrupt,
+			"TLB shootdown IPI");
+	intr_register_int (LAPIC_SPURIOUS_VEC, 0, INTR_OFF,
+			lapic_spurious_interrupt, "LAPIC Spurious");
+
+	lapic_calibrate ();
+	return true;
+}
+
+/* Enables the calling application processor's local APIC and
+   starts its periodic timer.  Called with interrupts off on each
+   AP as it comes up. */
+void
+lapic_init_ap (void) {
+	lapic_write (LAPIC_SVR, SVR_ENABLE | LAPIC_SPURIOUS_VEC);
+	lapic_write (LAPIC_LVT_LINT0, LVT_MASKED);
+	lapic_write (LAPIC_LVT_LINT1, LVT_MASKED);
+	lapic_write (LAPIC_LVT_ERROR, LVT_MASKED);
+	lapic_write (LAPIC_ESR, 0);
+	lapic_write (LAPIC_TPR, 0);
+
+	lapic_write (LAPIC_TIMER_DIV, TIMER_DIV_16);
+	lapic_write (LAPIC_LVT_TIMER, LAPIC_TIMER_VEC | LVT_PERIODIC);
+	lapic_write (LAPIC_TIMER_INIT, lapic_timer_counts);
+
+	lapic_eoi ();
+}
+
+/* Returns true if lapic_init() found and enabled a local APIC. */
+bool
+lapic_present (void) {
+	return lapic != NULL;
+}
+
+/* Returns the calling CPU's local APIC ID. */
+uint8_t
+lapic_id (void) {
+	return lapic_read (LAPIC_ID) >> 24;
+}
+
+/* Acknowledges the interrupt being serviced on this CPU. */
+void
+lapic_eoi (void) {
+	lapic_write (LAPIC_EOI, 0);
+}
+
+/* Sends interrupt VEC to the CPU whose local APIC ID is APIC_ID. */
+void
+lapic_send_ipi (uint8_t apic_id, uint8_t vec) {
+	enum intr_level old_level = intr_disable ();
+
+	while (lapic_read (LAPIC_ICR_LO) & ICR_PENDING)
+		asm volatile ("pause");
+	lapic_write (LAPIC_ICR_HI, (uint32_t) apic_id << 24);
+	lapic_write (LAPIC_ICR_LO, vec);
+	intr_set_level (old_level);
+}
+
+/* Starts the application processor whose local APIC ID is
+   APIC_ID executing real-mode code at physical address ENTRY,
+   which must be page aligned and below 1 MB.  Follows the
+   universal INIT-SIPI-SIPI start-up algorithm from the
+   MultiProcessor Specification, appendix B.4. */
+void
+lapic_start_ap (uint8_t apic_id, uint64_t entry) {
+	int i;
+
+	ASSERT (entry % PGSIZE == 0 && entry < 0x100000);
+
+	lapic_write (LAPIC_ICR_HI, (uint32_t) apic_id << 24);
+	lapic_write (LAPIC_ICR_LO, ICR_INIT | ICR_LEVEL | ICR_ASSERT);
+	timer_usleep (200);
+	lapic_write (LAPIC_ICR_LO, ICR_INIT | ICR_LEVEL);
+	timer_msleep (10);
+
+	for (i = 0; i < 2; i++) {
+		lapic_write (LAPIC_ICR_HI, (uint32_t) apic_id << 24);
+		lapic_write (LAPIC_ICR_LO, ICR_STARTUP | (entry >> 12));
+		timer_usleep (200);
+	}
+}
+
+/* Sends INIT to the application processor whose local APIC ID
+   is APIC_ID, which stops whatever it is running and leaves it
+   waiting for a start-up IPI that will not come. */
+void
+lapic_park_ap (uint8_t apic_id) {
+	lapic_write (LAPIC_ICR_HI, (uint32_t) apic_id << 24);
+	lapic_write (LAPIC_ICR_LO, ICR_INIT | ICR_LEVEL | ICR_ASSERT);
+	timer_usleep (200);
+	lapic_write (LAPIC_ICR_LO, ICR_INIT | ICR_LEVEL);
+	while (lapic_read (LAPIC_ICR_LO) & ICR_PENDING)
+		asm volatile ("pause");
+	timer_msleep (10);
+}
+
+/* Makes the calling CPU's local APIC timer raise interrupt VEC
+   once, NS nanoseconds from now, replacing any countdown in
+   progress.  NS of 0 stops the timer.  Deadlines beyond the
+   32-bit counter's reach fire early, at the longest countdown
+   possible.  Only for a CPU whose APIC timer does not provide
+   the tick, that is, the BSP. */
+void
+lapic_timer_oneshot (uint8_t vec, uint64_t ns) {
+	const uint64_t tick_ns = 1000000000 / TIMER_FREQ;
+	uint64_t counts;
+
+	ASSERT (lapic != NULL);
+
+	if (ns == 0) {
+		lapic_write (LAPIC_TIMER_INIT, 0);
+		return;
+	}
+
+	/* Cap NS at one second, which keeps the product in range. */
+	if (ns > 1000000000)
+		ns = 1000000000;
+	counts = ns * lapic_timer_counts / tick_ns;
+	if (counts == 0)
+		counts = 1;
+	else if (counts > UINT32_MAX)
+		counts = UINT32_MAX;
+
+	lapic_write (LAPIC_LVT_TIMER, vec);
+	lapic_write (LAPIC_TIMER_INIT, counts);
+}
+
+/* Measures how many local APIC timer counts make up one 8254
+   timer tick. */
+static void
+lapic_calibrate (void) {
+	int64_t start;
+
+	ASSERT (intr_get_level () == INTR_ON);
+
+	lapic_write (LAPIC_TIMER_DIV, TIMER_DIV_16);
+	lapic_write (LAPIC_LVT_TIMER, LVT_MASKED);
+
+	/* Wait for a tick boundary, then count through one tick. */
+	start = timer_ticks ();
+	while (timer_ticks () == start)
+		barrier ();
+	lapic_write (LAPIC_TIMER_INIT, UINT32_MAX);
+	start = timer_ticks ();
+	while (timer_ticks () == start)
+		barrier ();
+	lapic_timer_counts = UINT32_MAX - lapic_read (LAPIC_TIMER_CUR);
+	lapic_write (LAPIC_TIMER_INIT, 0);
+}
+
+/* Local APIC timer interrupt handler.  The 8254 drives the BSP's
+   tick, so this only ever runs on APs, where it provides the time
+   slice. */
+static void
+lapic_timer_interrupt (struct intr_frame *args UNUSED) {
+	thread_tick ();
+}
+
+/* Reschedule IPI handler.  Another CPU made a thread ready that
+   should run here, or has work for an idle CPU to steal. */
+static void
+lapic_resched_interrupt (struct intr_frame *args UNUSED) {
+	intr_yield_on_return ();
+}
+
+/* TLB shootdown IPI handler.  Another CPU changed kernel
+   mappings and waits for us to drop stale translations. */
+static void
+lapic_tlb_interrupt (struct intr_frame *args UNUSED) {
+	cpu_tlb_interrupt ();
+}
+
+/* Spurious interrupt handler.  Spurious interrupts are not
+   acknowledged with an EOI. */
+static void
+lapic_spurious_interrupt (struct intr_frame *args UNUSED) {
+}
@@ -3,10 +3,14 @@
 #include <inttypes.h>
 #include <round.h>
 #include <stdio.h>
+#include "devices/hrtimer.h"
+#include "threads/cpu.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#include "threads/workqueue.h"
+#include "intrinsic.h"
 /* See [8254] for hardware details of the 8254 timer chip. */
 #if TIMER_FREQ < 19
 #error 8254 timer requires TIMER_FREQ >= 19
@@ -14,47 +18,97 @@
 #if TIMER_FREQ > 1000
 #error TIMER_FREQ <= 1000 recommended
 #endif
+/* 8254 input frequency and the number of its input clocks in one
+   timer tick, rounded to nearest. */
+#define PIT_HZ 1193180
+#define PIT_TICK_COUNTS ((PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ)
+/* Nanoseconds in one timer tick. */
+#define TICK_NS (1000000000 / TIMER_FREQ)
+/* Most ticks a single one-shot countdown can cover, since the
+   8254 counter is only 16 bits wide. */
+#define ONESHOT_MAX_TICKS (0xffff / PIT_TICK_COUNTS)
 /* Number of timer ticks since OS booted. */
 static int64_t ticks;
-/* Number of loops per timer tick.
-   Initialized by timer_calibrate(). */
-static unsigned loops_per_tick;
+/* -tickless: stop the periodic tick while only the idle thread
+   can run.  Set from the kernel command line. */
+bool timer_tickless;
+/* -slack=N: how many ticks late timer_sleep() may wake up a
+   thread whose priority is below PRI_DEFAULT.  Set from the
+   kernel command line. */
+int64_t timer_slack;
+/* PIT counts of the one-shot countdown in progress, or 0 while
+   the timer runs periodically. */
+static uint32_t oneshot_counts;
+/* PIT counts that had passed since the last counted tick when the
+   one-shot countdown was started. */
+static uint32_t oneshot_lag;
+/* PIT counts of idle time that did not add up to a whole tick the
+   last time tickless idle ended.  Carried into the next idle
+   period so that `ticks' does not drift. */
+static uint32_t idle_residual;
+/* ktime_ns() when tickless idle on the local APIC timer began, or
+   0 while it is not in progress. */
+static uint64_t lapic_idle_start;
+/* PIT counts that had passed since the last tick when it began. */
+static uint32_t lapic_idle_lag;
+/* Wakes the BSP at the end of tickless idle on the local APIC. */
+static struct hrtimer idle_timer;
+/* TSC clocksource, set up by timer_calibrate():
+   ktime_ns() = (rdtsc () - tsc_base) * tsc_mult / 2**32. */
+static uint64_t tsc_hz;
+static uint64_t tsc_base;
+static uint64_t tsc_mult;
 static intr_handler_func timer_interrupt;
-static bool too_many_loops (unsigned loops);
-static void busy_wait (int64_t loops);
+static uint64_t tsc_hz_from_cpuid (void);
+static uint64_t tsc_hz_from_pit (void);
 static void real_time_sleep (int64_t num, int32_t denom);
+static void pit_set_periodic (void);
+static void pit_set_oneshot (uint16_t count);
+static uint16_t pit_read_count (void);
+static bool pit_irq_pending (void);
+static void pit_mask (bool);
+static int64_t oneshot_stop (uint32_t elapsed);
+static bool other_cpus_idle (void);
+static void lapic_idle_enter (int64_t delta, uint32_t elapsed);
+static int64_t lapic_idle_stop (void);
+static hrtimer_func idle_timer_expired;
 /* Sets up the 8254 Programmable Interval Timer (PIT) to
    interrupt PIT_FREQ times per second, and registers the
    corresponding interrupt. */
 void
 timer_init (void) {
-    /* 8254 input frequency divided by TIMER_FREQ, rounded to
-       nearest. */
-    uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
-    outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
-    outb (0x40, count & 0xff);
-    outb (0x40, count >> 8);
+    pit_set_periodic ();
     intr_register_ext (0x20, timer_interrupt, "8254 Timer");
 }
-/* Calibrates loops_per_tick, used to implement brief delays. */
+/* Finds the TSC frequency, which ktime_ns() and sub-tick sleeps
+   are based on.  The CPU reports it through CPUID on recent
+   processors; otherwise it is measured against the 8254 over one
+   timer tick. */
 void
 timer_calibrate (void) {
-    unsigned high_bit, test_bit;
+    const char *source = "CPUID";
     ASSERT (intr_get_level () == INTR_ON);
     printf ("Calibrating timer...  ");
-    /* Approximate loops_per_tick as the largest power-of-two
-       still less than one timer tick. */
-    loops_per_tick = 1u << 10;
-    while (!too_many_loops (loops_per_tick << 1)) {
-        loops_per_tick <<= 1;
-        ASSERT (loops_per_tick != 0);
+    tsc_hz = tsc_hz_from_cpuid ();
+    if (tsc_hz == 0) {
+        tsc_hz = tsc_hz_from_pit ();
+        source = "8254";
     }
-    /* Refine the next 8 bits of loops_per_tick. */
-    high_bit = loops_per_tick;
-    for (test_bit = high_bit >> 1; test_bit != high_bit >> 10; test_bit >>= 1)
-        if (!too_many_loops (high_bit | test_bit))
-            loops_per_tick |= test_bit;
-    printf ("%'"PRIu64" loops/s.\n", (uint64_t) loops_per_tick * TIMER_FREQ);
+    ASSERT (tsc_hz != 0);
+    tsc_mult = (1000000000ULL << 32) / tsc_hz;
+    tsc_base = rdtsc ();
+    printf ("%'"PRIu64" TSC Hz (%s).\n", tsc_hz, source);
+}
+/* Returns the number of nanoseconds since timer_calibrate(), read
+   from the TSC, or 0 before it.  Unlike timer_ticks(), this is
+   cheap and does not disable interrupts.  The TSC is assumed to
+   run at a constant rate and to be in step on all CPUs. */
+uint64_t
+ktime_ns (void) {
+    uint64_t now = rdtsc ();
+    if (now <= tsc_base)
+        return 0;
+    return ((unsigned __int128) (now - tsc_base) * tsc_mult) >> 32;
 }
 /* Returns the number of timer ticks since the OS booted. */
 int64_t
@@ -71,13 +125,22 @@ int64_t
 timer_elapsed (int64_t then) {
     return timer_ticks () - then;
 }
-/* Suspends execution for approximately TICKS timer ticks. */
+/* Suspends execution for approximately TICKS timer ticks.
+   Threads below PRI_DEFAULT get the kernel-wide timer_slack. */
 void
 timer_sleep(int64_t ticks) {
+  timer_sleep_slack (ticks,
+                     thread_get_priority () < PRI_DEFAULT ? timer_slack : 0);
+}
+/* Suspends execution for at least TICKS timer ticks, but allows
+   the wakeup to be up to SLACK ticks late so that it can share a
+   timer interrupt with other sleepers. */
+void
+timer_sleep_slack (int64_t ticks, int64_t slack) {
   if (ticks <= 0) return;
   int64_t wakeup_tick = timer_ticks() + ticks;  // 지금시간 + 자야할 시간 = 깨어야 할 시간 //
   ASSERT (intr_get_level () == INTR_ON);
-  thread_sleep(wakeup_tick);
+  thread_sleep_slack(wakeup_tick, slack);
 }
 /* Suspends execution for approximately MS milliseconds. */
 void
@@ -94,6 +157,89 @@ void
 timer_nsleep (int64_t ns) {
     real_time_sleep (ns, 1000 * 1000 * 1000);
 }
+/* Called by the idle thread, with interrupts off, right before
+   it halts the CPU.  In tickless mode, stops the periodic tick
+   until the earliest sleeper's deadline, so that the CPU is not
+   woken up just to halt again.
+
+   With a local APIC, the 8254's interrupt is masked and an
+   hrtimer on the APIC timer wakes the CPU at the deadline, however
+   far off.  Otherwise the 8254 itself counts down in one-shot
+   mode, but it can count at most ONESHOT_MAX_TICKS ticks at once,
+   so longer idle periods take several countdowns.
+
+   MLFQS needs to see every tick to keep its statistics, so the
+   tick is never stopped under it.  The 8254 only interrupts the
+   BSP, so only the BSP's idle thread stops it, and only while the
+   other CPUs are idle too, since they read `ticks' as well. */
+void
+timer_idle_enter (void) {
+    int64_t delta;
+    uint32_t elapsed;
+
+    ASSERT (intr_get_level () == INTR_OFF);
+    if (!timer_tickless || thread_mlfqs || oneshot_counts != 0
+        || lapic_idle_start != 0 || this_cpu () != &cpus[0]
+        || !other_cpus_idle ())
+        return;
+
+    delta = (MIN_alarm_time < work_next_deadline
+             ? MIN_alarm_time : work_next_deadline) - ticks;
+    if (delta < 2 || pit_irq_pending ())
+        return;
+
+    /* Part of the current tick has already gone by; count it
+       towards the countdown so that it ends on a tick boundary. */
+    elapsed = PIT_TICK_COUNTS - pit_read_count ();
+    if (hrtimer_available ()) {
+        lapic_idle_enter (delta, elapsed);
+        return;
+    }
+
+    if (delta > ONESHOT_MAX_TICKS)
+        delta = ONESHOT_MAX_TICKS;
+    oneshot_lag = elapsed + idle_residual;
+    idle_residual = 0;
+    oneshot_counts = delta * PIT_TICK_COUNTS - oneshot_lag;
+    pit_set_oneshot (oneshot_counts);
+}
+
+/* Ends tickless idle, if it is in progress, because an interrupt
+   other than the 8254's woke up the CPU; on the local APIC path
+   that includes the hrtimer that ends it on time.  Catches `ticks'
+   up with the time spent idle and restarts the periodic tick.
+   Called on entry to every external interrupt handler except the
+   8254's, so that handlers never observe a stale tick count. */
+void
+timer_idle_exit (void) {
+    uint16_t remaining;
+    uint32_t elapsed;
+    int64_t idle;
+
+    ASSERT (intr_get_level () == INTR_OFF);
+    if (this_cpu () != &cpus[0])
+        return;
+
+    if (lapic_idle_start != 0)
+        idle = lapic_idle_stop ();
+    else if (oneshot_counts != 0) {
+        /* After reaching zero the counter wraps around and keeps
+           counting down, so a count above the programmed one means
+           the countdown is already over. */
+        remaining = pit_read_count ();
+        elapsed = remaining <= oneshot_counts ? oneshot_counts - remaining
+                                              : oneshot_counts;
+        idle = oneshot_stop (elapsed);
+    } else
+        return;
+    ticks += idle;
+    thread_account_idle (idle);
+    if (ticks >= MIN_alarm_time)
+        thread_awake (ticks);
+    if (ticks >= work_next_deadline)
+        workqueue_timer (ticks);
+}
+
 /* Prints timer statistics. */
 void
 timer_print_stats (void) {
@@ -103,35 +249,202 @@ timer_print_stats (void) {
 /* Timer interrupt handler. */
 static void
 timer_interrupt(struct intr_frame *args UNUSED) {
-  ticks++;
+  if (oneshot_counts != 0) {
+    /* A tickless idle countdown ran out: the whole countdown went
+       by, all of it idle but the tick thread_tick() counts below. */
+    int64_t idle = oneshot_stop (oneshot_counts);
+    ticks += idle;
+    thread_account_idle (idle - 1);
+  } else
+    ticks++;
   thread_tick();
-  thread_awake(ticks); // 🔹 sleep_list 검사 및 깨우기
+  if (ticks >= MIN_alarm_time)   // 🔹 깨울 스레드가 없는 틱은 바로 리턴
+    thread_awake(ticks);
+  if (ticks >= work_next_deadline)
+    workqueue_timer (ticks);
+}
+/* Programs PIT counter 0 to interrupt TIMER_FREQ times per
+   second. */
+static void
+pit_set_periodic (void) {
+    outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
+    outb (0x40, PIT_TICK_COUNTS & 0xff);
+    outb (0x40, PIT_TICK_COUNTS >> 8);
+}
+
+/* Programs PIT counter 0 to interrupt once, COUNT input clocks
+   from now. */
+static void
+pit_set_oneshot (uint16_t count) {
+    outb (0x43, 0x30);    /* CW: counter 0, LSB then MSB, mode 0, binary. */
+    outb (0x40, count & 0xff);
+    outb (0x40, count >> 8);
 }
-/* Returns true if LOOPS iterations waits for more than one timer
-   tick, otherwise false. */
+
+/* Returns the current value of PIT counter 0. */
+static uint16_t
+pit_read_count (void) {
+    uint8_t lo, hi;
+
+    outb (0x43, 0x00);    /* CW: counter 0, latch count. */
+    lo = inb (0x40);
+    hi = inb (0x40);
+    return lo | (hi << 8);
+}
+
+/* Returns true if a timer interrupt has been raised but not yet
+   delivered, because interrupts are off.  It belongs to the
+   periodic tick, so tickless idle must not start until it has
+   been handled. */
 static bool
-too_many_loops (unsigned loops) {
-    /* Wait for a timer tick. */
-    int64_t start = ticks;
-    while (ticks == start)
+pit_irq_pending (void) {
+    outb (0x20, 0x0a);    /* OCW3: read master PIC's IRR. */
+    return inb (0x20) & 0x01;
+}
+
+/* Masks the 8254's interrupt at the master PIC if MASKED is true,
+   unmasks it otherwise.  A tick that comes while it is masked
+   stays pending in the PIC. */
+static void
+pit_mask (bool masked) {
+    uint8_t imr = inb (0x21);
+
+    outb (0x21, masked ? imr | 0x01 : imr & ~0x01);
+}
+
+/* Stops the one-shot countdown in progress, of which ELAPSED PIT
+   counts went by, and restarts the periodic tick.  Returns the
+   number of whole ticks the idle period amounted to; the
+   remainder is kept in idle_residual for next time. */
+static int64_t
+oneshot_stop (uint32_t elapsed) {
+    uint32_t total = oneshot_lag + elapsed;
+
+    oneshot_counts = 0;
+    idle_residual = total % PIT_TICK_COUNTS;
+    pit_set_periodic ();
+    return total / PIT_TICK_COUNTS;
+}
+
+/* Returns true if every CPU but the BSP is idle with nothing
+   queued to run. */
+static bool
+other_cpus_idle (void) {
+    int i;
+
+    for (i = 1; i < cpu_cnt; i++) {
+        struct cpu *c = &cpus[i];
+
+        if (c->online && (c->curr != c->idle_thread || c->rq.nr_ready != 0))
+            return false;
+    }
+    return true;
+}
+
+/* Starts tickless idle on the local APIC timer, to end DELTA ticks
+   from the last tick, ELAPSED PIT counts ago.  The 8254 keeps
+   running periodically with its interrupt masked, so the tick
+   boundaries stay where they were. */
+static void
+lapic_idle_enter (int64_t delta, uint32_t elapsed) {
+    uint64_t now = ktime_ns ();
+
+    ASSERT (now != 0);
+
+    lapic_idle_start = now;
+    lapic_idle_lag = elapsed;
+    pit_mask (true);
+
+    /* Without a deadline, the next interrupt of any kind ends the
+       idle period. */
+    if (delta < INT64_MAX / TICK_NS) {
+        uint64_t lag_ns = (uint64_t) elapsed * 1000000000 / PIT_HZ;
+
+        hrtimer_init (&idle_timer, idle_timer_expired, NULL);
+        hrtimer_start (&idle_timer, now + delta * TICK_NS - lag_ns);
+    }
+}
+
+/* Ends tickless idle on the local APIC timer and unmasks the 8254.
+   Returns the number of tick boundaries that went by, leaving out
+   one whose interrupt is still pending in the PIC: it is counted
+   as usual once it is delivered.
+
+   The TSC measures how long the CPU was idle, and the 8254's
+   current count tells where in a tick we are now, so the number
+   of boundaries crossed comes out as a whole number up to
+   rounding. */
+static int64_t
+lapic_idle_stop (void) {
+    uint64_t idle_ns = ktime_ns () - lapic_idle_start;
+    int64_t counts, idle;
+
+    hrtimer_cancel (&idle_timer);
+    lapic_idle_start = 0;
+
+    counts = lapic_idle_lag
+             + (int64_t) (idle_ns / 1000 * PIT_HZ / 1000000)
+             - (PIT_TICK_COUNTS - pit_read_count ());
+    idle = (counts + PIT_TICK_COUNTS / 2) / PIT_TICK_COUNTS;
+    if (idle < 0)
+        idle = 0;
+    if (idle > 0 && pit_irq_pending ())
+        idle--;
+    pit_mask (false);
+    return idle;
+}
+
+/* hrtimer_func for the end of tickless idle.  timer_idle_exit()
+   has already caught up on entry to the interrupt, so there is
+   nothing left to do. */
+static void
+idle_timer_expired (struct hrtimer *t UNUSED, void *aux UNUSED) {
+}
+
+/* Executes CPUID leaf LEAF and stores its outputs. */
+static void
+cpuid (uint32_t leaf, uint32_t *eax, uint32_t *ebx, uint32_t *ecx,
+       uint32_t *edx) {
+    asm volatile ("cpuid"
+                  : "=a" (*eax), "=b" (*ebx), "=c" (*ecx), "=d" (*edx)
+                  : "a" (leaf), "c" (0));
+}
+/* Returns the TSC frequency in Hz as reported by CPUID, or 0 if
+   the CPU does not report it.  Leaf 0x15 gives the ratio of the
+   TSC to the core crystal clock and, usually, the crystal's
+   frequency.  When the crystal frequency is missing, leaf 0x16's
+   base frequency is the TSC frequency.  See [IA32-v2a] "CPUID". */
+static uint64_t
+tsc_hz_from_cpuid (void) {
+    uint32_t max, denom, numer, crystal, edx, base_mhz, ebx, ecx;
+    cpuid (0, &max, &ebx, &ecx, &edx);
+    if (max < 0x15)
+        return 0;
+    cpuid (0x15, &denom, &numer, &crystal, &edx);
+    if (denom == 0 || numer == 0)
+        return 0;
+    if (crystal != 0)
+        return (uint64_t) crystal * numer / denom;
+    if (max < 0x16)
+        return 0;
+    cpuid (0x16, &base_mhz, &ebx, &ecx, &edx);
+    return (uint64_t) (base_mhz & 0xffff) * 1000000;
+}
+/* Measures the TSC frequency in Hz by counting TSC cycles over
+   one timer tick. */
+static uint64_t
+tsc_hz_from_pit (void) {
+    int64_t start;
+    uint64_t tsc;
+    /* Wait for a tick boundary, then count through one tick. */
+    start = timer_ticks ();
+    while (timer_ticks () == start)
         barrier ();
-    /* Run LOOPS loops. */
-    start = ticks;
-    busy_wait (loops);
-    /* If the tick count changed, we iterated too long. */
-    barrier ();
-    return start != ticks;
-}
-/* Iterates through a simple loop LOOPS times, for implementing
-   brief delays.
-   Marked NO_INLINE because code alignment can significantly
-   affect timings, so that if this function was inlined
-   differently in different places the results would be difficult
-   to predict. */
-static void NO_INLINE
-busy_wait (int64_t loops) {
-    while (loops-- > 0)
+    tsc = rdtsc ();
+    start = timer_ticks ();
+    while (timer_ticks () == start)
         barrier ();
+    return (rdtsc () - tsc) * TIMER_FREQ;
 }
 /* Sleep for approximately NUM/DENOM seconds. */
 static void
@@ -148,11 +461,11 @@ real_time_sleep (int64_t num, int32_t denom) {
            timer_sleep() because it will yield the CPU to other
            processes. */
         timer_sleep (ticks);
-    } else {
-        /* Otherwise, use a busy-wait loop for more accurate
-           sub-tick timing.  We scale the numerator and denominator
-           down by 1000 to avoid the possibility of overflow. */
-        ASSERT (denom % 1000 == 0);
-        busy_wait (loops_per_tick * num / 1000 * TIMER_FREQ / (denom / 1000));
+    } else if (num > 0) {
+        /* Otherwise, use a high-resolution timer for more accurate
+           sub-tick timing.  NUM is less than DENOM here, so this
+           does not overflow. */
+        ASSERT (1000000000 % denom == 0);
+        hrtimer_sleep (num * (1000000000 / denom));
     }
 }
\ No newline at end of file
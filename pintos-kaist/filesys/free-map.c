@@ -4,10 +4,16 @@
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
+#include "threads/workqueue.h"
 
 static struct file *free_map_file;   /* Free map file. */
 static struct bitmap *free_map;      /* Free map, one bit per disk sector. */
 
+/* Writes the free map to disk after sectors are released.  A
+   burst of releases is written out once, off the caller's path. */
+static struct work free_map_work;
+static void free_map_write (void *aux);
+
 /* Initializes the free map. */
 void
 free_map_init (void) {
@@ -16,6 +22,7 @@ free_map_init (void) {
 		PANIC ("bitmap creation failed--disk is too large");
 	bitmap_mark (free_map, FREE_MAP_SECTOR);
 	bitmap_mark (free_map, ROOT_DIR_SECTOR);
+	work_init (&free_map_work, free_map_write, NULL);
 }
 
 /* Allocates CNT consecutive sectors from the free map and stores
@@ -41,6 +48,12 @@ void
 free_map_release (disk_sector_t sector, size_t cnt) {
 	ASSERT (bitmap_all (free_map, sector, cnt));
 	bitmap_set_multiple (free_map, sector, cnt, false);
+	work_queue (system_wq, &free_map_work);
+}
+
+/* Work function that writes the free map to disk. */
+static void
+free_map_write (void *aux UNUSED) {
 	bitmap_write (free_map, free_map_file);
 }
 
@@ -57,6 +70,7 @@ free_map_open (void) {
 /* Writes the free map to disk and closes the free map file. */
 void
 free_map_close (void) {
+	work_flush (&free_map_work);
 	file_close (free_map_file);
 }
 
@@ -0,0 +1,33 @@
+#ifndef DEVICES_HRTIMER_H
+#define DEVICES_HRTIMER_H
+
+#include <heap.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+struct hrtimer;
+
+/* Called from an interrupt handler when hrtimer T expires, with
+   the AUX given to hrtimer_init(). */
+typedef void hrtimer_func (struct hrtimer *t, void *aux);
+
+/* A high-resolution timer, which runs a function at a deadline
+   given in ktime_ns() nanoseconds rather than in timer ticks. */
+struct hrtimer {
+	struct heap_elem elem;      /* Queue element. */
+	uint64_t expires;           /* Deadline, in ktime_ns() time. */
+	bool pending;               /* Queued and not yet expired? */
+	hrtimer_func *func;         /* Function to call on expiry. */
+	void *aux;                  /* Its auxiliary data. */
+};
+
+void hrtimer_enable (void);
+bool hrtimer_available (void);
+
+void hrtimer_init (struct hrtimer *, hrtimer_func *, void *aux);
+void hrtimer_start (struct hrtimer *, uint64_t expires);
+bool hrtimer_cancel (struct hrtimer *);
+
+void hrtimer_sleep (uint64_t ns);
+
+#endif /* devices/hrtimer.h */
@@ -15,7 +15,8 @@
    and condition variables from threads/synch.h cannot be used in
    this case, as they normally would, because they can only
    protect kernel threads from one another, not from interrupt
-   handlers. */
+   handlers.  The waiting threads sit on wait queues instead,
+   which interrupt handlers may wake. */
 
 /* Queue buffer size, in bytes. */
 #define INTQ_BUFSIZE 64
@@ -23,9 +24,8 @@
 /* A circular queue of bytes. */
 struct intq {
 	/* Waiting threads. */
-	struct lock lock;           /* Only one thread may wait at once. */
-	struct thread *not_full;    /* Thread waiting for not-full condition. */
-	struct thread *not_empty;   /* Thread waiting for not-empty condition. */
+	struct waitq not_full;      /* Threads waiting for not-full condition. */
+	struct waitq not_empty;     /* Threads waiting for not-empty condition. */
 
 	/* Queue. */
 	uint8_t buf[INTQ_BUFSIZE];  /* Buffer. */
@@ -0,0 +1,26 @@
+#ifndef DEVICES_LAPIC_H
+#define DEVICES_LAPIC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Interrupt vectors delivered by the local APIC.  They sit above
+   the 8259A PIC's 0x20...0x2f and are treated as external
+   interrupts. */
+#define LAPIC_TIMER_VEC 0xf0            /* Per-CPU timer tick (APs only). */
+#define LAPIC_RESCHED_VEC 0xf1          /* Reschedule IPI. */
+#define LAPIC_HRTIMER_VEC 0xf2          /* High-resolution timer (BSP only). */
+#define LAPIC_TLB_VEC 0xf3              /* TLB shootdown IPI. */
+#define LAPIC_SPURIOUS_VEC 0xff         /* Spurious interrupt. */
+
+bool lapic_init (void);
+void lapic_init_ap (void);
+bool lapic_present (void);
+uint8_t lapic_id (void);
+void lapic_eoi (void);
+void lapic_send_ipi (uint8_t apic_id, uint8_t vec);
+void lapic_start_ap (uint8_t apic_id, uint64_t entry);
+void lapic_park_ap (uint8_t apic_id);
+void lapic_timer_oneshot (uint8_t vec, uint64_t ns);
+
+#endif /* devices/lapic.h */
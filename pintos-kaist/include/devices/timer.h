@@ -2,22 +2,34 @@
 #define DEVICES_TIMER_H
 
 #include <round.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Number of timer interrupts per second. */
 #define TIMER_FREQ 100
 
+/* -tickless: stop the periodic tick while the CPU is idle. */
+extern bool timer_tickless;
+
+/* -slack=N: wakeup slack for low-priority sleepers, in ticks. */
+extern int64_t timer_slack;
+
 void timer_init (void);
 void timer_calibrate (void);
 
 int64_t timer_ticks (void);
 int64_t timer_elapsed (int64_t);
+uint64_t ktime_ns (void);
 
 void timer_sleep (int64_t ticks);
+void timer_sleep_slack (int64_t ticks, int64_t slack);
 void timer_msleep (int64_t milliseconds);
 void timer_usleep (int64_t microseconds);
 void timer_nsleep (int64_t nanoseconds);
 
+void timer_idle_enter (void);
+void timer_idle_exit (void);
+
 void timer_print_stats (void);
 
 #endif /* devices/timer.h */
@@ -0,0 +1,79 @@
+#ifndef __LIB_KERNEL_HEAP_H
+#define __LIB_KERNEL_HEAP_H
+
+/* Pairing heap.
+ *
+ * A heap keeps a set of elements so that the greatest one, as
+ * defined by a caller-supplied "less than" function, can be found
+ * in constant time.  Inserting an element, melding two heaps and
+ * moving an element up after its key has grown take constant
+ * time; removing the top or any other element takes O(log n)
+ * amortized time.
+ *
+ * The heap is stable: elements that compare equal come out in
+ * the order they were inserted, as with list_insert_ordered().
+ * Each insertion stamps the element with a sequence number, and
+ * heap_update() keeps that stamp, so re-keying an element does
+ * not send it to the back of its priority class.
+ *
+ * Like lists, the heap does not allocate memory.  Each structure
+ * that can be put on a heap embeds a struct heap_elem member, and
+ * heap_entry() converts a pointer to that member back into a
+ * pointer to the outer structure.
+ *
+ * The heap does no locking of its own; the owner must provide
+ * mutual exclusion. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Heap element.
+
+   Children of a node are kept in a doubly linked list of
+   siblings.  PREV points to the left sibling, or to the parent
+   for the leftmost child, and is NULL for the root and for an
+   element that is not on a heap. */
+struct heap_elem {
+	struct heap_elem *child;            /* Leftmost child. */
+	struct heap_elem *next;             /* Right sibling. */
+	struct heap_elem *prev;             /* Left sibling or parent. */
+	unsigned long seq;                  /* Insertion stamp, for stability. */
+};
+
+/* Converts pointer to heap element HEAP_ELEM into a pointer to
+ * the structure that HEAP_ELEM is embedded inside.  Supply the
+ * name of the outer structure STRUCT and the member name MEMBER
+ * of the heap element. */
+#define heap_entry(HEAP_ELEM, STRUCT, MEMBER)                   \
+	((STRUCT *) ((uint8_t *) &(HEAP_ELEM)->child            \
+		- offsetof (STRUCT, MEMBER.child)))
+
+/* Compares the value of two heap elements A and B, given
+ * auxiliary data AUX.  Returns true if A is less than B, or
+ * false if A is greater than or equal to B. */
+typedef bool heap_less_func (const struct heap_elem *a,
+		const struct heap_elem *b, void *aux);
+
+/* Pairing heap, ordered so that the greatest element is on top. */
+struct heap {
+	struct heap_elem *root;             /* Greatest element, or NULL. */
+	size_t elem_cnt;                    /* Number of elements. */
+	unsigned long next_seq;             /* Stamp for the next insertion. */
+	heap_less_func *less;               /* Comparison function. */
+	void *aux;                          /* Auxiliary data for `less'. */
+};
+
+void heap_init (struct heap *, heap_less_func *, void *aux);
+void heap_elem_init (struct heap_elem *);
+
+void heap_push (struct heap *, struct heap_elem *);
+struct heap_elem *heap_top (const struct heap *);
+struct heap_elem *heap_pop (struct heap *);
+void heap_remove (struct heap *, struct heap_elem *);
+void heap_update (struct heap *, struct heap_elem *);
+
+size_t heap_size (const struct heap *);
+bool heap_empty (const struct heap *);
+
+#endif /* lib/kernel/heap.h */
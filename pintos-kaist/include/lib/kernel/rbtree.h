@@ -0,0 +1,71 @@
+#ifndef __LIB_KERNEL_RBTREE_H
+#define __LIB_KERNEL_RBTREE_H
+
+/* Red-black tree.
+ *
+ * A red-black tree keeps a set of elements sorted by a
+ * caller-supplied "less than" function.  Inserting and removing
+ * an element take O(log n) time in the worst case, and the
+ * smallest element is cached so that finding it takes constant
+ * time.  Walking the tree in order with rb_next() visits each
+ * element in amortized constant time.
+ *
+ * Elements that compare equal are kept in the order they were
+ * inserted: a new element goes after all of its equals.
+ *
+ * Like lists, the tree does not allocate memory.  Each structure
+ * that can be put in a tree embeds a struct rb_node member, and
+ * rb_entry() converts a pointer to that member back into a
+ * pointer to the outer structure.
+ *
+ * The tree does no locking of its own; the owner must provide
+ * mutual exclusion. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Red-black tree node.  Leaves are null pointers, which count
+   as black. */
+struct rb_node {
+	struct rb_node *parent;             /* Parent, or NULL for the root. */
+	struct rb_node *left;               /* Smaller elements. */
+	struct rb_node *right;              /* Greater or equal elements. */
+	bool red;                           /* Red or black? */
+};
+
+/* Converts pointer to tree node RB_NODE into a pointer to the
+ * structure that RB_NODE is embedded inside.  Supply the name
+ * of the outer structure STRUCT and the member name MEMBER of
+ * the tree node. */
+#define rb_entry(RB_NODE, STRUCT, MEMBER)                       \
+	((STRUCT *) ((uint8_t *) &(RB_NODE)->parent             \
+		- offsetof (STRUCT, MEMBER.parent)))
+
+/* Compares the value of two tree nodes A and B, given auxiliary
+ * data AUX.  Returns true if A is less than B, or false if A is
+ * greater than or equal to B. */
+typedef bool rb_less_func (const struct rb_node *a,
+		const struct rb_node *b, void *aux);
+
+/* Red-black tree. */
+struct rb_tree {
+	struct rb_node *root;               /* Root, or NULL if empty. */
+	struct rb_node *first;              /* Smallest element, or NULL. */
+	size_t node_cnt;                    /* Number of elements. */
+	rb_less_func *less;                 /* Comparison function. */
+	void *aux;                          /* Auxiliary data for `less'. */
+};
+
+void rb_init (struct rb_tree *, rb_less_func *, void *aux);
+
+void rb_insert (struct rb_tree *, struct rb_node *);
+void rb_remove (struct rb_tree *, struct rb_node *);
+
+struct rb_node *rb_first (const struct rb_tree *);
+struct rb_node *rb_next (const struct rb_node *);
+
+size_t rb_size (const struct rb_tree *);
+bool rb_empty (const struct rb_tree *);
+
+#endif /* lib/kernel/rbtree.h */
@@ -0,0 +1,83 @@
+#ifndef __LIB_KERNEL_WHEEL_H
+#define __LIB_KERNEL_WHEEL_H
+
+/* Hierarchical timer wheel.
+ *
+ * A timer wheel keeps a set of elements keyed on an expiration
+ * tick and hands them back once that tick has been reached.
+ * Inserting and removing an element take constant time, and
+ * advancing the wheel costs time proportional to the number of
+ * elements that expire, plus an occasional "cascade" that moves
+ * far-away elements one level closer.
+ *
+ * Level 0 has one slot per tick for the next WHEEL_L0_SIZE
+ * ticks.  Each higher level has WHEEL_LN_SIZE slots, each of
+ * which covers a whole revolution of the level below it.  When
+ * the lower level wraps around, the matching slot of the level
+ * above is emptied and its elements are reinserted, landing in
+ * finer slots now that they are closer to expiring.  This is the
+ * same scheme as the classic BSD/Linux callout wheel.
+ *
+ * Like lists and hash tables, the wheel does not allocate
+ * memory.  Each structure that can be put on a wheel embeds a
+ * struct wheel_elem member, and wheel_entry() converts a pointer
+ * to that member back into a pointer to the outer structure.
+ *
+ * The wheel does no locking of its own; the owner must provide
+ * mutual exclusion, typically by disabling interrupts. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "list.h"
+
+#define WHEEL_L0_BITS 8                 /* log2 of level-0 slot count. */
+#define WHEEL_LN_BITS 6                 /* log2 of upper level slot count. */
+#define WHEEL_LEVELS 5                  /* Number of levels, including level 0. */
+#define WHEEL_L0_SIZE (1 << WHEEL_L0_BITS)
+#define WHEEL_LN_SIZE (1 << WHEEL_LN_BITS)
+#define WHEEL_SLOTS (WHEEL_L0_SIZE + (WHEEL_LEVELS - 1) * WHEEL_LN_SIZE)
+
+/* Wheel element. */
+struct wheel_elem {
+	struct list_elem list_elem;         /* Slot list element. */
+	int64_t expires;                    /* Expiration tick. */
+	int slot;                           /* Slot index, or -1 if not on a wheel. */
+};
+
+/* Converts pointer to wheel element WHEEL_ELEM into a pointer to
+ * the structure that WHEEL_ELEM is embedded inside.  Supply the
+ * name of the outer structure STRUCT and the member name MEMBER
+ * of the wheel element. */
+#define wheel_entry(WHEEL_ELEM, STRUCT, MEMBER)                 \
+	((STRUCT *) ((uint8_t *) &(WHEEL_ELEM)->list_elem       \
+		- offsetof (STRUCT, MEMBER.list_elem)))
+
+/* Performs some operation on expired wheel element E, given
+ * auxiliary data AUX. */
+typedef void wheel_action_func (struct wheel_elem *e, void *aux);
+
+/* Timer wheel. */
+struct wheel {
+	int64_t base;                       /* First tick not yet processed. */
+	size_t elem_cnt;                    /* Number of elements on the wheel. */
+	uint64_t l0_used[WHEEL_L0_SIZE / 64]; /* Non-empty level-0 slots. */
+	uint64_t ln_used[WHEEL_LEVELS - 1]; /* Non-empty upper slots, per level. */
+	struct list slots[WHEEL_SLOTS];     /* Level 0 first, then upper levels. */
+};
+
+void wheel_init (struct wheel *, int64_t base);
+void wheel_elem_init (struct wheel_elem *);
+
+void wheel_insert (struct wheel *, struct wheel_elem *, int64_t expires);
+void wheel_remove (struct wheel *, struct wheel_elem *);
+bool wheel_elem_pending (const struct wheel_elem *);
+
+void wheel_advance (struct wheel *, int64_t now,
+		wheel_action_func *, void *aux);
+int64_t wheel_next_deadline (const struct wheel *);
+
+size_t wheel_size (const struct wheel *);
+bool wheel_empty (const struct wheel *);
+
+#endif /* lib/kernel/wheel.h */
@@ -0,0 +1,107 @@
+#ifndef THREADS_CPU_H
+#define THREADS_CPU_H
+
+#include <debug.h>
+#include <heap.h>
+#include <list.h>
+#include <rbtree.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* 지원하는 CPU의 최대 개수. */
+#define CPU_MAX 16
+
+/* 한 CPU의 실행 큐.
+ *
+ * 스케줄링 클래스(sched.h)마다 자기 부분이 있습니다.  EDF 클래스는
+ * 절대 마감 순서의 힙을 쓰고, 이 CPU에 묶인 EDF 스레드들의 대역폭
+ * 합을 dl_bw에 둡니다.  우선순위
+ * 클래스는 우선순위마다 FIFO 큐가 하나씩 있고, 비어 있지 않은 큐는
+ * mask의 해당 비트가 켜져 있으므로 가장 높은 우선순위를 O(1)에 찾을
+ * 수 있습니다.  공정 클래스는 vruntime 순서의 레드-블랙 트리를 씁니다.
+ * lock은 다른 CPU가 스레드를 넣거나 훔쳐 갈 때도 잡습니다. */
+struct runqueue {
+	struct spinlock lock;               /* 아래 필드들을 보호. */
+	unsigned nr_ready;                  /* 큐에 든 스레드 수. */
+
+	/* EDF 클래스. */
+	struct heap dl_heap;                /* 마감이 이른 순서의 준비 스레드. */
+	uint64_t dl_bw;                     /* 이 CPU에 묶인 EDF 대역폭 (dl_bw_lock). */
+
+	/* 우선순위 클래스. */
+	struct list queues[PRI_MAX - PRI_MIN + 1]; /* 우선순위별 준비 큐. */
+	uint64_t mask;                      /* 비어 있지 않은 큐들. */
+
+	/* 공정 클래스. */
+	struct rb_tree fair_tree;           /* vruntime 순서의 준비 스레드. */
+	uint64_t min_vruntime;              /* 단조 증가하는 vruntime 기준점. */
+	unsigned long fair_load;            /* 트리에 든 스레드의 가중치 합. */
+};
+
+/* struct cpu의 ap_state.  smp_init()과 켜지는 AP가 각자
+   AP_BOOTING에서 바꾸려 하고, 먼저 바꾼 쪽이 이깁니다. */
+enum ap_state {
+	AP_BOOTING,                         /* BSP가 깨우고 기다리는 중. */
+	AP_STARTED,                         /* AP가 켜지기로 함. */
+	AP_ABANDONED                        /* BSP가 기다리다 포기함. */
+};
+
+/* CPU마다 하나씩 있는 상태.
+ *
+ * 각 CPU는 자기 struct cpu만 고치는 것이 원칙입니다.  예외는 실행
+ * 큐로, rq.lock을 잡으면 어느 CPU든 넣고 뺄 수 있습니다. */
+struct cpu {
+	int id;                             /* 0이 BSP. cpus[]의 인덱스. */
+	uint8_t lapic_id;                   /* 로컬 APIC ID. */
+	volatile bool online;               /* 스케줄링에 참여 중인가? */
+	int ap_state;                       /* enum ap_state, AP만. */
+
+	struct thread *idle_thread;         /* 이 CPU의 idle 스레드. */
+	struct thread *curr;                /* 지금 실행 중인 스레드. */
+	struct thread *prev;                /* 방금 전환해 나온 스레드. */
+	struct runqueue rq;                 /* 실행 큐. */
+	struct list destruction_req;        /* 해제를 기다리는 스레드 페이지. */
+	unsigned thread_ticks;              /* 마지막 양보 이후 지난 틱 수. */
+
+	bool in_external_intr;              /* 외부 인터럽트 처리 중인가? */
+	bool yield_on_return;               /* 인터럽트 복귀 시 양보할까? */
+
+	/* 통계. */
+	long long idle_ticks;               /* idle 상태로 보낸 틱 수. */
+	long long kernel_ticks;             /* 커널 스레드가 쓴 틱 수. */
+	long long user_ticks;               /* 사용자 프로그램이 쓴 틱 수. */
+	long long mlfqs_ticks;              /* MLFQS 부기를 한 틱 수. */
+	long long mlfqs_tick_cycles;        /* 그 부기에 든 사이클 합. */
+	long long dl_misses;                /* EDF 스레드가 마감을 놓친 횟수. */
+	uint64_t hist[THREAD_HIST_CNT][THREAD_HIST_BUCKETS]; /* 지연 히스토그램. */
+
+#ifdef INTR_TRACE
+	/* 인터럽트가 꺼져 있던 구간 (interrupt.c). */
+	uint64_t intr_off_stamp;            /* 꺼진 시각, 추적 중이 아니면 0. */
+	void *intr_off_caller;              /* 끈 곳. */
+	struct intr_off_window intr_off_top[INTR_TRACE_TOP]; /* 가장 긴 구간들. */
+	uint64_t intr_off_hist[INTR_TRACE_BUCKETS]; /* 길이 히스토그램. */
+#endif
+
+#ifdef USERPROG
+	struct task_state *tss;             /* 이 CPU의 TSS, 없으면 NULL. */
+#endif
+};
+
+extern struct cpu cpus[CPU_MAX];
+extern int cpu_cnt;                     /* 켜진 CPU 수. */
+extern int smp_cpu_request;             /* -smp=N 으로 요청한 CPU 수. */
+
+void cpu_init (struct cpu *, int id);
+struct cpu *this_cpu (void);
+void cpu_kick (struct cpu *);
+void cpu_kick_idle (void);
+void cpu_flush_tlb (void);
+void cpu_tlb_interrupt (void);
+
+void smp_init (void);
+void cpu_ap_main (void) NO_RETURN;
+
+#endif /* threads/cpu.h */
@@ -0,0 +1,77 @@
+#ifndef THREADS_FIXED_POINT_H
+#define THREADS_FIXED_POINT_H
+
+#include <stdint.h>
+
+/* 17.14 고정소수점 수 (fixed-point number).
+ *
+ * 커널은 부동소수점을 쓸 수 없으므로, MLFQS의 recent_cpu와 load_avg는
+ * 하위 14비트를 소수부로 쓰는 int로 나타냅니다.  부호 비트 1개, 정수부
+ * 17비트, 소수부 14비트이므로 대략 -131072 ~ 131071 범위를 표현합니다.
+ *
+ * 고정소수점끼리의 곱셈과 나눗셈은 중간값이 int를 넘칠 수 있으므로
+ * 64비트로 계산합니다. */
+typedef int fixed_t;
+
+#define FP_SHIFT 14                     /* 소수부 비트 수. */
+#define FP_ONE (1 << FP_SHIFT)          /* 1.0 */
+
+/* 정수 N을 고정소수점으로 바꿉니다. */
+static inline fixed_t
+fp_from_int (int n) {
+	return n * FP_ONE;
+}
+
+/* X의 정수부를 반환합니다 (0 쪽으로 버림). */
+static inline int
+fp_to_int (fixed_t x) {
+	return x / FP_ONE;
+}
+
+/* X를 가장 가까운 정수로 반올림해 반환합니다. */
+static inline int
+fp_round (fixed_t x) {
+	return x >= 0 ? (x + FP_ONE / 2) / FP_ONE : (x - FP_ONE / 2) / FP_ONE;
+}
+
+static inline fixed_t
+fp_add (fixed_t x, fixed_t y) {
+	return x + y;
+}
+
+static inline fixed_t
+fp_sub (fixed_t x, fixed_t y) {
+	return x - y;
+}
+
+static inline fixed_t
+fp_add_int (fixed_t x, int n) {
+	return x + n * FP_ONE;
+}
+
+static inline fixed_t
+fp_sub_int (fixed_t x, int n) {
+	return x - n * FP_ONE;
+}
+
+static inline fixed_t
+fp_mul (fixed_t x, fixed_t y) {
+	return ((int64_t) x) * y / FP_ONE;
+}
+
+static inline fixed_t
+fp_mul_int (fixed_t x, int n) {
+	return x * n;
+}
+
+static inline fixed_t
+fp_div (fixed_t x, fixed_t y) {
+	return ((int64_t) x) * FP_ONE / y;
+}
+
+static inline fixed_t
+fp_div_int (fixed_t x, int n) {
+	return x / n;
+}
+
+#endif /* threads/fixed-point.h */
@@ -15,6 +15,21 @@ enum intr_level intr_set_level (enum intr_level);
 enum intr_level intr_enable (void);
 enum intr_level intr_disable (void);
 
+#ifdef INTR_TRACE
+/* Number of longest interrupts-off windows kept per CPU. */
+#define INTR_TRACE_TOP 8
+
+/* Number of buckets in the interrupts-off histogram.  Bucket K
+   counts windows of [2**(K-1), 2**K) cycles. */
+#define INTR_TRACE_BUCKETS 64
+
+/* One interrupts-off window. */
+struct intr_off_window {
+	uint64_t cycles;        /* Length in TSC cycles. */
+	void *caller;           /* Where interrupts were turned off. */
+};
+#endif
+
 /* Interrupt stack frame. */
 struct gp_registers {
 	uint64_t r15;
@@ -66,6 +81,7 @@ struct intr_frame {
 typedef void intr_handler_func (struct intr_frame *);
 
 void intr_init (void);
+void intr_init_ap (void);
 void intr_register_ext (uint8_t vec, intr_handler_func *, const char *name);
 void intr_register_int (uint8_t vec, int dpl, enum intr_level,
                         intr_handler_func *, const char *name);
@@ -74,5 +90,6 @@ void intr_yield_on_return (void);
 
 void intr_dump_frame (const struct intr_frame *);
 const char *intr_name (uint8_t vec);
+void intr_print_stats (void);
 
 #endif /* threads/interrupt.h */
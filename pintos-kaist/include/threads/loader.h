@@ -11,6 +11,11 @@
 /* Kernel virtual address at which all physical memory is mapped. */
 #define LOADER_PHYS_BASE 0x200000
 
+/* Physical address to which the application processor startup
+   code is copied.  Must be page aligned and below 1 MB, since an
+   AP starts in real mode at the page named by its SIPI vector. */
+#define LOADER_AP_BASE 0x8000
+
 /* Multiboot infos */
 #define MULTIBOOT_INFO       0x7000
 #define MULTIBOOT_FLAG       MULTIBOOT_INFO
@@ -0,0 +1,71 @@
+#ifndef THREADS_SCHED_H
+#define THREADS_SCHED_H
+
+#include <stdbool.h>
+#include "threads/thread.h"
+
+struct cpu;
+struct runqueue;
+
+/* 다른 CPU가 훔쳐 갈 수 있는 스레드면 true를 반환하는 함수. */
+typedef bool sched_filter_func (struct thread *t, void *aux);
+
+/* 스케줄링 클래스.
+ *
+ * 실행 큐는 클래스마다 자기 자료구조를 따로 두고, 스케줄러는 순위
+ * (rank)가 높은 클래스부터 차례로 물어 봅니다.  높은 클래스에 준비된
+ * 스레드가 있으면 낮은 클래스의 스레드는 실행되지 않으며, 같은
+ * 클래스 안의 순서는 클래스가 정합니다.
+ *
+ * tick을 뺀 모든 함수는 RQ의 락을 잡은 상태에서, 인터럽트가 꺼진
+ * 채로 호출됩니다. */
+struct sched_class {
+	const char *name;                   /* 이름 (디버깅 목적). */
+	int rank;                           /* 작을수록 먼저 실행됨. */
+
+	/* T를 RQ에 넣습니다 / RQ에서 꺼냅니다. */
+	void (*enqueue) (struct runqueue *rq, struct thread *t);
+	void (*dequeue) (struct runqueue *rq, struct thread *t);
+
+	/* RQ에서 다음에 실행할 스레드를 꺼내지 않고 반환합니다.
+	   없으면 NULL. */
+	struct thread *(*pick_next) (struct runqueue *rq);
+
+	/* RQ에서 FILTER (T, AUX)가 true인 스레드 중 가장 먼저 실행할
+	   것을 꺼내지 않고 반환합니다.  다른 CPU가 훔쳐 갈 때 씁니다. */
+	struct thread *(*pick_steal) (struct runqueue *rq,
+			sched_filter_func *filter, void *aux);
+
+	/* 실행 중인 CURR이 틱 하나를 썼습니다.  이제 양보해야 하면
+	   true.  타이머 인터럽트에서 RQ의 락 없이 호출됩니다. */
+	bool (*tick) (struct runqueue *rq, struct thread *curr);
+
+	/* RQ에 있는 T가 같은 클래스에서 실행 중인 CURR을 선점해야 하면
+	   true. */
+	bool (*check_preempt) (struct runqueue *rq, struct thread *curr,
+			struct thread *t);
+};
+
+extern const struct sched_class sched_dl_class;
+extern const struct sched_class sched_prio_class;
+extern const struct sched_class sched_fair_class;
+
+void sched_init (void);
+void sched_rq_init (struct runqueue *);
+const struct sched_class *sched_class_of (const struct thread *);
+
+void sched_enqueue (struct runqueue *, struct thread *);
+void sched_dequeue (struct runqueue *, struct thread *);
+struct thread *sched_pick_next (struct runqueue *);
+struct thread *sched_pick_steal (struct runqueue *,
+		sched_filter_func *, void *aux);
+bool sched_tick (struct runqueue *, struct thread *curr);
+bool sched_preempts (struct runqueue *, struct thread *curr,
+		struct thread *t);
+
+bool sched_dl_admit (struct thread *, int64_t runtime, int64_t deadline,
+		int64_t period, struct cpu *only);
+void sched_dl_release (struct thread *);
+void sched_print_stats (void);
+
+#endif /* threads/sched.h */
@@ -0,0 +1,61 @@
+#ifndef THREADS_SLAB_H
+#define THREADS_SLAB_H
+
+#include <list.h>
+#include <stddef.h>
+#include "threads/synch.h"
+
+/* 슬랩 할당자 (Slab allocator).
+ *
+ * 크기가 정해진 객체를 자주 만들고 없애는 타입마다 캐시
+ * (struct kmem_cache)를 하나씩 둡니다.  캐시는 페이지 하나짜리
+ * 슬랩들에서 객체를 잘라 주고, malloc()처럼 2의 거듭제곱으로
+ * 올림하지 않으며 락도 다른 타입과 나눠 쓰지 않습니다.
+ *
+ * 생성자를 주면 객체가 슬랩에서 처음 잘려 나올 때 한 번만
+ * 부릅니다.  kmem_cache_free()에는 생성된 상태로 돌려주어야 하고,
+ * 다음 kmem_cache_alloc()은 그 상태 그대로 돌려받습니다.
+ *
+ * KMEM_MAGAZINE을 주면 CPU마다 최근에 해제한 객체를 몇 개씩 들고
+ * 있다가 락 없이 바로 내줍니다. */
+
+/* kmem_cache_init()의 FLAGS. */
+#define KMEM_MAGAZINE 001           /* CPU별 매거진을 씀. */
+
+/* CPU별 매거진 하나가 들 수 있는 객체 수. */
+#define KMEM_MAG_SIZE 16
+
+/* 객체 생성자. */
+typedef void kmem_ctor (void *obj);
+
+/* CPU별 매거진. */
+struct kmem_magazine {
+	size_t cnt;                     /* 든 객체 수. */
+	void *objs[KMEM_MAG_SIZE];      /* 해제된 객체들. */
+};
+
+/* 객체 캐시. */
+struct kmem_cache {
+	const char *name;               /* 이름 (락 이름에도 씀). */
+	size_t size;                    /* 요청한 객체 크기. */
+	size_t obj_size;                /* 슬랩 안에서 객체 하나가 차지하는 크기. */
+	size_t link_ofs;                /* 해제된 객체 안 다음 포인터의 위치. */
+	size_t objs_per_slab;           /* 슬랩 하나의 객체 수. */
+	kmem_ctor *ctor;                /* 생성자, 없으면 NULL. */
+
+	struct lock lock;               /* 아래 필드들을 보호. */
+	struct list partial;            /* 일부만 쓰는 슬랩. */
+	struct list full;               /* 다 쓴 슬랩. */
+	struct list empty;              /* 비어 있는 슬랩. */
+	size_t empty_cnt;               /* empty의 슬랩 수. */
+
+	struct kmem_magazine *mags;     /* CPU별 매거진, 안 쓰면 NULL. */
+};
+
+void kmem_cache_init (struct kmem_cache *, const char *name, size_t size,
+		kmem_ctor *ctor, unsigned flags);
+void *kmem_cache_alloc (struct kmem_cache *);
+void kmem_cache_free (struct kmem_cache *, void *obj);
+void kmem_cache_shrink (struct kmem_cache *);
+
+#endif /* threads/slab.h */
@@ -0,0 +1,35 @@
+#ifndef THREADS_SWITCH_H
+#define THREADS_SWITCH_H
+
+#ifndef __ASSEMBLER__
+#include <stdint.h>
+
+/* switch_threads()'s stack frame: the callee-saved registers
+   that it pushes, in the order they sit on the stack, followed
+   by its return address. */
+struct switch_threads_frame {
+	uint64_t r15;
+	uint64_t r14;
+	uint64_t r13;
+	uint64_t r12;
+	uint64_t rbp;
+	uint64_t rbx;
+	void (*rip) (void);                 /* Return address. */
+};
+
+/* Switches from CUR, which must be the running thread, to NEXT,
+   which must also be running switch_threads(), returning CUR in
+   NEXT's context. */
+struct thread *switch_threads (struct thread *cur, struct thread *next);
+
+/* A new thread's first switch_threads() returns here.  It calls
+   the function in the frame's rbx with the arguments in r12 and
+   r13. */
+void switch_entry (void);
+
+/* Offset of `stack' within `struct thread'.  Used by
+   switch_threads(), which can't figure it out on its own. */
+extern const uint64_t thread_stack_ofs;
+#endif
+
+#endif /* threads/switch.h */
@@ -1,47 +1,174 @@
 #ifndef THREADS_SYNCH_H
 #define THREADS_SYNCH_H
 
+#include <heap.h>
 #include <list.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct cpu;
+
+/* 스핀락 (Spinlock).
+ *
+ * 여러 CPU가 함께 쓰는 짧은 임계 구역을 보호합니다.  인터럽트를 끈
+ * 상태에서만 잡아야 하며, 잡은 채로 잠들어서는 안 됩니다.  단일 CPU
+ * 에서는 인터럽트를 끄는 것만으로 충분하므로 경쟁이 생기지 않습니다. */
+struct spinlock {
+	volatile int locked;        /* 잠겨 있으면 1. */
+	struct cpu *cpu;            /* 락을 잡고 있는 CPU (디버깅용). */
+};
+
+void spinlock_init (struct spinlock *); // 스핀락을 풀린 상태로 초기화합니다.
+void spinlock_acquire (struct spinlock *); // 스핀락을 잡을 때까지 돌면서 기다립니다.
+bool spinlock_try_acquire (struct spinlock *); // 기다리지 않고 스핀락을 잡아 봅니다. 성공 시 true 반환.
+void spinlock_release (struct spinlock *); // 스핀락을 풉니다.
+bool spinlock_held (const struct spinlock *); // 현재 CPU가 스핀락을 잡고 있는지 확인합니다.
+
+/* 우선순위 기부(donation) 상태(wait_on_lock, donors, donee, priority)와
+   우선순위 순으로 정렬된 대기 힙(대기 큐의 힙)을 보호하는 스핀락.
+   기부 사슬을 따라 올라가며 여러 대기 힙의 위치를 고쳐야 하므로
+   하나의 락으로 묶었습니다.  락 순서는 대기 큐의 lock ->
+   donation_lock -> 실행 큐 순입니다. */
+extern struct spinlock donation_lock;
+
+/* 대기 큐 (Wait Queue).
+ *
+ * 세마포어, 락, 조건 변수와 장치 드라이버가 잠든 스레드를 두는
+ * 곳입니다.  스레드는 배타적으로(exclusive) 또는 함께(shared)
+ * 기다립니다.  waitq_wake()는 함께 기다리는 스레드는 모두 깨우고,
+ * 배타적으로 기다리는 스레드는 우선순위 순으로 요청한 수만큼만
+ * 깨웁니다.  하나만 진행할 수 있는 자원에서 모두 깨웠다가 다시
+ * 재우는 일(thundering herd)이 없습니다.
+ *
+ * 깨운 스레드는 리스트에 모았다가 thread_unblock_list()로 한꺼번에
+ * 실행 큐에 넣고, 선점 여부는 호출한 쪽이 thread_preemption()으로
+ * 한 번만 판단합니다.  힙에는 스레드의 wait_elem이 들어가므로
+ * 기다리는 동안 기부로 우선순위가 바뀌면 자리도 고쳐집니다. */
+struct waitq {
+	struct heap exclusive;      /* 배타적으로 기다리는 스레드들, 우선순위 순. */
+	struct heap shared;         /* 함께 기다리는 스레드들, 우선순위 순. */
+	struct spinlock lock;       /* 두 힙과 큐를 쓰는 쪽의 상태를 보호. */
+};
+
+/* waitq_wake()에 넘기면 배타적으로 기다리는 스레드도 모두 깨웁니다. */
+#define WAITQ_ALL SIZE_MAX
+
+void waitq_init (struct waitq *); // 빈 대기 큐로 초기화합니다.
+bool waitq_empty (const struct waitq *); // 기다리는 스레드가 없으면 true. lock을 잡고 불러야 합니다.
+void waitq_add (struct waitq *, bool exclusive); // 현재 스레드를 큐에 넣습니다. 잠들지는 않습니다.
+bool waitq_block (struct waitq *, int64_t deadline); // 깨울 때까지 잠듭니다. DEADLINE 틱이 먼저 오면 큐에서 빠지고 false 반환.
+size_t waitq_wake (struct waitq *, size_t nr_exclusive, struct list *woken); // 깨울 스레드를 WOKEN에 모으고 그 수를 반환합니다.
 
 /* 카운팅 세마포어 (Counting Semaphore). */
 struct semaphore {
 	unsigned value;             /* 현재 값. */
-	struct list waiters;        /* 대기 중인 스레드들의 리스트. */
+	struct waitq waiters;       /* 대기 중인 스레드들.  그 lock이 value도 보호. */
 };
 
 void sema_init (struct semaphore *, unsigned value); // 세마포어를 주어진 값(value)으로 초기화합니다.
 void sema_down (struct semaphore *); // 세마포어 값을 감소시킵니다 (P 연산). 값이 0이면 대기합니다.
+bool sema_down_timeout (struct semaphore *, int64_t ticks); // sema_down과 같되 TICKS 틱까지만 기다립니다. 성공 시 true 반환.
 bool sema_try_down (struct semaphore *); // 세마포어 down을 시도하지만, 기다리지 않습니다. 성공 시 true 반환.
 void sema_up (struct semaphore *); // 세마포어 값을 증가시킵니다 (V 연산). 대기 중인 스레드가 있으면 깨웁니다.
 void sema_self_test (void); // 세마포어 자체 테스트 함수.
 
-/* 락 (Lock). */
+/* 락 경합 통계 (단위는 rdtsc 사이클).  LOCKSTAT으로 빌드했을 때
+   lock_init_named()로 이름을 붙인 락만 셉니다.  획득 횟수와 보유
+   시간은 락을 가진 스레드가, 경합과 대기 시간은 waiters.lock 아래에서,
+   기부는 donation_lock 아래에서 고칩니다. */
+struct lock_stat {
+	const char *name;           /* 보고서에 쓸 이름. */
+	struct lock_stat *next;     /* 이름 붙은 다음 락의 통계. */
+	unsigned long acquired;     /* 획득 횟수. */
+	unsigned long contended;    /* 기다려야 했던 횟수. */
+	uint64_t wait_cycles;       /* 기다린 시간의 합. */
+	uint64_t max_wait_cycles;   /* 가장 오래 기다린 시간. */
+	uint64_t hold_cycles;       /* 보유한 시간의 합. */
+	uint64_t max_hold_cycles;   /* 가장 오래 보유한 시간. */
+	unsigned long donations;    /* 대기자가 우선순위를 기부한 횟수. */
+	int max_chain;              /* 한 번의 기부가 바꾼 가장 긴 사슬. */
+};
+
+/* 락 (Lock).
+ *
+ * holder가 곧 소유자 워드입니다.  풀린 락은 NULL에서 자기 자신으로
+ * CAS 한 번에 잡고, 기다리는 스레드가 없으면 놓을 때도 원자적 쓰기
+ * 한 번이면 끝납니다.  대기와 우선순위 기부는 경쟁이 생겼을 때만
+ * waiters.lock 아래에서 처리합니다. */
 struct lock {
-	struct thread *holder;      /* 락을 보유하고 있는 스레드 (디버깅용). */
-	struct semaphore semaphore; /* 접근을 제어하는 이진(binary) 세마포어. */
-	                            /* (내부적으로 세마포어를 사용하여 락을 구현) */
+	struct thread *holder;      /* 락을 보유하고 있는 스레드, 없으면 NULL. */
+	unsigned contenders;        /* 느린 경로에 들어온 스레드 수. */
+	struct waitq waiters;       /* 잠들어 기다리는 스레드들, 모두 배타적.
+	                               그 lock이 contenders 변경도 보호. */
+
+	/* 우선순위 기부 (donation_lock이 보호). */
+	struct thread *donee;       /* donors 힙에 이 락을 둔 스레드. */
+	struct heap_elem donor_elem; /* 그 스레드의 donors 힙 요소. */
+
+#ifdef LOCKSTAT
+	uint64_t acquired_at;       /* 지금 소유자가 얻은 TSC. */
+	struct lock_stat stat;      /* 경합 통계, 이름이 없으면 세지 않음. */
+#endif
 };
 
 void lock_init (struct lock *); // 락을 초기화합니다.
+void lock_init_named (struct lock *, const char *name); // 이름을 붙여 초기화합니다. LOCKSTAT이면 통계를 셉니다.
 void lock_acquire (struct lock *); // 락을 획득합니다. 이미 사용 중이면 대기합니다.
+bool lock_acquire_timeout (struct lock *, int64_t ticks); // lock_acquire와 같되 TICKS 틱까지만 기다립니다. 성공 시 true 반환.
 bool lock_try_acquire (struct lock *); // 락 획득을 시도하지만, 기다리지 않습니다. 성공 시 true 반환.
 void lock_release (struct lock *); // 락을 해제합니다.
 bool lock_held_by_current_thread (const struct lock *); // 현재 스레드가 해당 락을 보유하고 있는지 확인합니다.
+void lock_print_stats (void); // 이름 붙은 락의 경합 통계를 경합이 많은 순으로 출력합니다.
 
 /* 조건 변수 (Condition Variable). */
 struct condition {
-	struct list waiters;        /* 특정 조건을 기다리는 스레드들의 리스트. */
+	struct waitq waiters;       /* 특정 조건을 기다리는 스레드들. */
 };
 
 void cond_init (struct condition *); // 조건 변수를 초기화합니다.
 void cond_wait (struct condition *, struct lock *); // 연관된 락(lock)을 해제하고 조건(condition)을 기다립니다. 신호(signal)를 받으면 락을 다시 획득합니다.
+bool cond_wait_timeout (struct condition *, struct lock *, int64_t ticks); // cond_wait와 같되 TICKS 틱까지만 기다립니다. 신호를 받았으면 true 반환.
 void cond_signal (struct condition *, struct lock *); // 조건(condition)을 기다리는 스레드 중 하나를 깨웁니다. 락(lock)을 보유한 상태에서 호출해야 합니다.
 void cond_broadcast (struct condition *, struct lock *); // 조건(condition)을 기다리는 모든 스레드를 깨웁니다. 락(lock)을 보유한 상태에서 호출해야 합니다.
 
-bool compare_sema_list_priority(const struct list_elem *a, const struct list_elem *b, void *aux);
+/* 읽기-쓰기 락 (Reader-Writer Lock).
+ *
+ * 여러 스레드가 함께 읽거나, 한 스레드만 쓸 수 있습니다.  쓰는
+ * 스레드가 없으면 읽기는 state에 CAS 한 번으로 들어가므로 읽는
+ * 스레드끼리는 막지 않습니다.  쓰기는 writer 락을 잡고 RW_WRITER를
+ * 켠 뒤, 이미 들어와 있던 읽는 스레드가 모두 나가기를 기다립니다.
+ * RW_WRITER가 켜지면 새로 오는 읽는 스레드도 writer 락에서 기다리므로
+ * 쓰기가 우선합니다 (writer preference).
+ *
+ * writer 락에서 기다리는 스레드는 우선순위 순으로 깨어나고, 쓰는
+ * 스레드에게 우선순위를 기부합니다.
+ *
+ * 읽는 스레드가 나가기를 기다리는 쓰는 스레드는 drained 락의 대기
+ * 큐에서 잠들고, 그동안 reader에 기록된 읽는 스레드에게 기부합니다.
+ * drained는 누구도 잡지 않고 대기 큐와 기부 상태만 쓰는 락입니다.
+ * 읽기 경로를 CAS 하나로 유지하려고 마지막으로 들어온 읽는 스레드
+ * 하나만 기록하므로, 기부받던 읽는 스레드가 나가면 그때 기록된 다른
+ * 읽는 스레드로 기부가 옮겨 가고, 기록된 스레드가 없으면 남은 읽는
+ * 스레드는 기부를 받지 못합니다.  읽기 구역은 짧게 두어야 합니다. */
+#define RW_WRITER 1u                /* 쓰기 쪽이 락을 가짐. */
+#define RW_READER 2u                /* 읽는 스레드 하나의 몫. */
+
+struct rwlock {
+	unsigned state;             /* 읽는 스레드 수 * RW_READER | RW_WRITER. */
+	struct lock writer;         /* 쓰는 스레드와 늦게 온 읽는 스레드가 잡음. */
+	struct lock drained;        /* 마지막 읽는 스레드가 쓰기를 깨움. */
+	struct thread *reader;      /* 마지막으로 들어온 읽는 스레드, 없으면 NULL. */
+};
 
-bool compare_semaphore_priority(const struct list_elem *a, const struct list_elem *b, void *aux);
+void rwlock_init (struct rwlock *); // 읽기-쓰기 락을 초기화합니다.
+void rwlock_read_acquire (struct rwlock *); // 읽기로 락을 잡습니다. 쓰는 스레드가 있으면 대기합니다.
+bool rwlock_read_try_acquire (struct rwlock *); // 기다리지 않고 읽기로 잡아 봅니다. 성공 시 true 반환.
+void rwlock_read_release (struct rwlock *); // 읽기로 잡은 락을 놓습니다.
+void rwlock_write_acquire (struct rwlock *); // 쓰기로 락을 잡습니다. 다른 스레드가 모두 나갈 때까지 대기합니다.
+bool rwlock_write_try_acquire (struct rwlock *); // 기다리지 않고 쓰기로 잡아 봅니다. 성공 시 true 반환.
+void rwlock_write_release (struct rwlock *); // 쓰기로 잡은 락을 놓습니다.
+bool rwlock_write_held_by_current_thread (const struct rwlock *); // 현재 스레드가 쓰기로 잡고 있는지 확인합니다.
 
 /* 최적화 장벽 (Optimization Barrier).
  *
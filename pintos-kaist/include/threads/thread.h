@@ -2,8 +2,12 @@
 #define THREADS_THREAD_H
 
 #include <debug.h>
+#include <heap.h>
 #include <list.h>
+#include <rbtree.h>
 #include <stdint.h>
+#include <wheel.h>
+#include "threads/fixed-point.h"
 #include "threads/interrupt.h"
 #ifdef VM
 #include "vm/vm.h"
@@ -18,6 +22,18 @@ enum thread_status {
 	THREAD_DYING        /* 파괴될 예정인 스레드. */
 };
 
+/* 스레드마다 고르는 스케줄링 정책. */
+enum sched_policy {
+	SCHED_PRIO,         /* 우선순위 라운드 로빈 (기본값). */
+	SCHED_FAIR,         /* vruntime 순서의 공정 분배, nice로 가중치. */
+	SCHED_DEADLINE      /* 마감이 가장 이른 것 먼저 (EDF), 다른 정책을 선점. */
+};
+
+struct cpu;
+struct runqueue;
+struct sched_class;
+struct spinlock;
+
 /* 스레드 식별자 타입.
    원하는 어떤 타입으로든 재정의할 수 있습니다. */
 typedef int tid_t;
@@ -26,9 +42,44 @@ typedef int tid_t;
 /* 스레드 우선순위. */
 #define PRI_MIN 0                       /* 가장 낮은 우선순위. */
 #define PRI_DEFAULT 31                  /* 기본 우선순위. */
-#define PRI_MAX 63       
-               /* 가장 높은 우선순위. */
-extern int64_t MIN_alarm_time; 
+#define PRI_MAX 63                      /* 가장 높은 우선순위. */
+
+/* MLFQS의 nice 값. */
+#define NICE_MIN -20                    /* 가장 덜 양보함. */
+#define NICE_DEFAULT 0                  /* 기본 nice 값. */
+#define NICE_MAX 20                     /* 가장 많이 양보함. */
+
+/* 타임아웃이 걸린 대기를 누가 끝냈는가.  깨우는 쪽과 타이머 휠 중
+   WAIT_PENDING을 먼저 바꾼 쪽만 스레드를 깨웁니다. */
+enum wait_result {
+	WAIT_NONE,          /* 타임아웃 없이 기다리거나, 기다리지 않음. */
+	WAIT_PENDING,       /* 아직 아무도 깨우지 않음. */
+	WAIT_SIGNALED,      /* 세마포어나 락이 먼저 깨움. */
+	WAIT_TIMEDOUT       /* 타임아웃이 먼저 지남. */
+};
+
+/* 스레드 하나의 CPU 사용량과 지연 (단위는 rdtsc 사이클). */
+struct thread_stats {
+	uint64_t user_cycles;               /* 사용자 모드로 보낸 시간. */
+	uint64_t kernel_cycles;             /* 커널 모드로 보낸 시간. */
+	uint64_t ready_cycles;              /* 실행 큐에서 기다린 시간. */
+	uint64_t lock_cycles;               /* 락을 기다리며 블록된 시간. */
+	unsigned long voluntary_switches;   /* 블록하며 CPU를 내준 횟수. */
+	unsigned long involuntary_switches; /* 준비 상태로 CPU를 뺏긴 횟수. */
+};
+
+/* 지연 히스토그램의 종류.  버킷 K (K > 0)에는 [2^(K-1), 2^K) 사이클이,
+   버킷 0에는 0 사이클이 들어갑니다.  CPU마다 따로 세고 읽을 때 더합니다. */
+enum thread_hist {
+	THREAD_HIST_READY,  /* 준비 상태가 된 뒤 스케줄될 때까지 (실행 큐 지연). */
+	THREAD_HIST_LOCK,   /* 락을 얻으려고 블록된 시간. */
+	THREAD_HIST_CNT
+};
+#define THREAD_HIST_BUCKETS 64
+
+/* 잠든 스레드 중 가장 먼저 처리할 일이 생기는 틱.
+   timer_interrupt()는 이 틱 전에는 thread_awake()를 부르지 않습니다. */
+extern int64_t MIN_alarm_time;
 
 /* 커널 스레드 또는 사용자 프로세스.
  *
@@ -79,11 +130,10 @@ extern int64_t MIN_alarm_time;
  * 스레드의 `struct thread`의 `magic` 멤버가 THREAD_MAGIC으로
  * 설정되어 있는지 확인합니다. 스택 오버플로우는 보통 이 값을
  * 변경하여 어설션을 트리거합니다. */
-/* `elem` 멤버는 두 가지 목적을 가집니다. 실행 큐(thread.c)의
- * 요소일 수도 있고, 세마포어 대기 목록(synch.c)의 요소일 수도 있습니다.
- * 이 두 가지 방식으로 사용될 수 있는 이유는 상호 배타적이기 때문입니다:
- * 준비(ready) 상태의 스레드만 실행 큐에 있고, 블록(blocked) 상태의
- * 스레드만 세마포어 대기 목록에 있습니다. */
+/* `elem` 멤버는 실행 큐(thread.c)의 요소입니다.  세마포어와 락의
+ * 대기 목록은 우선순위 힙이라서 따로 `wait_elem`을 씁니다.  준비
+ * (ready) 상태의 스레드만 실행 큐에 있고, 블록(blocked) 상태의
+ * 스레드만 대기 힙에 있으므로 둘이 동시에 쓰이지는 않습니다. */
 struct thread {
 	/* thread.c가 소유함. */
 	tid_t tid;                          /* 스레드 식별자. */
@@ -91,15 +141,47 @@ struct thread {
 	char name[16];                      /* 이름 (디버깅 목적). */
 	int priority;                       /* 우선순위. */
 	/* alarm clock */
-	int64_t time_to_wakeup;
+	struct wheel_elem sleep_elem;       /* 타이머 휠 요소 (깨어날 틱을 담음). */
+	int wait_result;                    /* enum wait_result, 원자적으로 바꿈. */
 	/* thread.c와 synch.c 간에 공유됨. */
 	struct list_elem elem;              /* 리스트 요소. */
 
 	
-	int init_priority;
-	struct lock *wait_on_lock;
-	struct list donations;
-	struct list_elem donations_elem;
+	/* 우선순위 기부 (synch.c와 공유, donation_lock이 보호). */
+	int init_priority;                  /* 기부받기 전의 원래 우선순위. */
+	struct lock *wait_on_lock;          /* 기다리는 락, 없으면 NULL. */
+	struct heap donors;                 /* 대기자가 있는 보유 락들, 기부 순. */
+	struct heap_elem wait_elem;         /* 세마포어나 락의 대기 힙 요소. */
+	struct heap *wait_heap;             /* wait_elem이 든 힙, 없으면 NULL. */
+	bool wait_woken;                    /* waitq_wake()가 깨웠는가? (대기 큐의 lock이 보호) */
+	bool wait_asleep;                   /* waitq_block()에서 잠들어 있는가? (같은 lock) */
+
+	/* MLFQS (thread.c가 소유함). */
+	int nice;                           /* 다른 스레드에게 얼마나 양보하는가. */
+	fixed_t recent_cpu;                 /* 최근에 쓴 CPU 시간의 추정치. */
+	struct list_elem all_elem;          /* 모든 스레드 목록의 요소. */
+
+	/* thread.c와 sched.c가 소유함 (SMP). */
+	struct cpu *cpu;                    /* 실행 중이거나 마지막으로 실행된 CPU. */
+	struct runqueue *rq;                /* 들어 있는 실행 큐, 없으면 NULL. */
+	const struct sched_class *rq_class; /* 실행 큐 안에서 속한 클래스. */
+	int rq_priority;                    /* 실행 큐 안에서 속한 우선순위 큐. */
+	enum sched_policy policy;           /* 스케줄링 정책. */
+	uint64_t vruntime;                  /* 공정 클래스: 가중치로 나눈 실행 시간. */
+	struct runqueue *vruntime_rq;       /* vruntime의 기준이 되는 실행 큐. */
+	struct rb_node fair_node;           /* 공정 클래스 트리의 요소. */
+
+	/* EDF 클래스 (sched.c가 소유함, 단위는 타이머 틱). */
+	int64_t dl_runtime;                 /* 주기마다 쓸 수 있는 실행 시간. */
+	int64_t dl_deadline;                /* 주기 시작부터 마감까지의 시간. */
+	int64_t dl_period;                  /* 주기. */
+	int64_t dl_abs_deadline;            /* 지금 인스턴스의 절대 마감. */
+	int64_t dl_remaining;               /* 지금 인스턴스에 남은 실행 시간. */
+	int64_t dl_wakeup;                  /* 예산을 다 써 잠들었다 깨어날 틱, 아니면 0. */
+	bool dl_missed;                     /* 지금 인스턴스가 마감을 놓쳤는가? */
+	struct heap_elem dl_elem;           /* EDF 힙 요소. */
+	struct cpu *dl_cpu;                 /* 승인받아 묶인 CPU, EDF가 아니면 NULL. */
+	volatile bool on_cpu;               /* 어떤 CPU가 아직 이 스레드의 스택 위에 있는가? */
 
 #ifdef USERPROG
 	/* userprog/process.c가 소유함. */
@@ -110,8 +192,15 @@ struct thread {
 	struct supplemental_page_table spt; // 보조 페이지 테이블
 #endif
 
+	/* CPU 사용량 통계 (thread.c가 소유함). */
+	struct thread_stats stats;          /* 누적 통계. */
+	uint64_t acct_stamp;                /* 마지막으로 사용 시간을 센 TSC. */
+	uint64_t ready_stamp;               /* 준비 상태가 된 TSC, 아니면 0. */
+	bool in_user;                       /* 사용자 모드에서 실행 중인가? */
+
 	/* thread.c가 소유함. */
-	struct intr_frame tf;               /* 컨텍스트 스위칭을 위한 정보 (레지스터 저장) */
+	uint8_t *stack;                     /* switch_threads()가 저장한 스택 포인터. */
+	struct intr_frame tf;               /* 사용자 모드로 돌아갈 때 쓸 레지스터 (do_iret) */
 	unsigned magic;                     /* 스택 오버플로우 감지용. */
 };
 
@@ -124,14 +213,27 @@ void thread_init (void);                // 스레딩 시스템 초기화
 void thread_start (void);               // 스레딩 시스템 시작 (스케줄러 시작)
 
 void thread_tick (void);                // 매 타이머 틱마다 호출됨 (스케줄링 관련 처리)
+void thread_account_idle (int64_t ticks); // 틱 없이 지나간 유휴 틱을 통계에 더함
 void thread_print_stats (void);         // 스레드 통계 출력
+void thread_get_stats (struct thread_stats *); // 현재 스레드의 통계를 복사
+void thread_get_hist (enum thread_hist, uint64_t counts[THREAD_HIST_BUCKETS]); // 모든 CPU의 지연 히스토그램 합을 복사
+void thread_enter_kernel (void);        // 사용자 모드에서 커널로 들어옴 (사용 시간 계산)
+void thread_enter_user (void);          // 커널에서 사용자 모드로 돌아감 (사용 시간 계산)
+void thread_account_lock_wait (uint64_t cycles); // 락을 기다리며 블록된 시간을 더함
 
 typedef void thread_func (void *aux);   // 스레드 함수의 타입 정의 (void* 인자 하나를 받음)
 tid_t thread_create (const char *name, int priority, thread_func *, void *); // 새 커널 스레드 생성
 
 void thread_block (void);               // 현재 실행 중인 스레드를 블록 상태로 전환
+void thread_block_locked (struct spinlock *); // 스핀락을 놓으면서 블록하고, 깨어나면 다시 잡음
 void thread_unblock (struct thread *);  // 지정된 스레드를 준비(ready) 상태로 전환
+void thread_unblock_list (struct list *); // elem으로 연결된 블록된 스레드들을 한꺼번에 준비 상태로 전환
+bool thread_claim_wakeup (struct thread *); // 블록된 스레드를 깨울 권리를 가져옴, 타임아웃이 먼저 가져갔으면 false
+bool thread_block_timeout (struct spinlock *, int64_t deadline); // thread_block_locked()와 같되 DEADLINE 틱에 깨어남, 타임아웃이면 true
 
+void thread_sleep (int64_t ticks);      // 현재 스레드를 TICKS 틱이 될 때까지 재움
+void thread_sleep_slack (int64_t ticks, int64_t slack); // TICKS부터 TICKS + SLACK 틱 사이에 깨어나도록 재움
+void thread_awake (int64_t ticks);      // TICKS 틱까지 깨어날 시간이 된 스레드를 모두 깨움
 
 
 
@@ -151,20 +253,26 @@ void thread_set_nice (int);             // 현재 스레드의 nice 값 설정
 int thread_get_recent_cpu (void);       // 현재 스레드의 recent_cpu 값 반환 (최근 CPU 사용량 추정치)
 int thread_get_load_avg (void);         // 시스템 전체의 load average 반환 (시스템 부하 평균)
 
+enum sched_policy thread_get_policy (void); // 현재 스레드의 스케줄링 정책 반환
+void thread_set_policy (enum sched_policy); // 현재 스레드의 스케줄링 정책 설정
+bool thread_set_deadline (int64_t runtime, int64_t deadline, int64_t period); // 현재 스레드를 EDF 스레드로 승인 요청
+
+struct thread *thread_create_ap_idle (struct cpu *); // AP가 처음 올라탈 idle 스레드를 만듦
+void thread_destroy_ap_idle (struct cpu *); // 켜지지 못한 AP의 idle 스레드를 없앰
+void thread_start_ap (void) NO_RETURN;  // AP에서 스케줄링을 시작함
+void thread_move_to_bsp (void);         // 사용자 모드로 돌아가기 전에 BSP로 옮겨 감
+
 void do_iret (struct intr_frame *tf);   // 인터럽트 프레임(tf)을 이용해 사용자 프로세스로 복귀 (iret 명령어 실행)
 
-bool compare_thread_priority(const struct list_elem *a_, const struct list_elem *b_, void *aux UNUSED);
+bool thread_priority_less (const struct heap_elem *, const struct heap_elem *, void *aux); // 대기 힙(wait_elem)의 우선순위 비교
 
 void thread_preemption(void);
 
-void donate_priority(void);
+int donate_priority (struct lock *lock, struct thread *holder); // LOCK의 대기자들이 HOLDER에게 기부하게 함, 우선순위가 바뀐 스레드 수 반환
 
 void remove_with_lock(struct lock *lock);
 
 void refresh_priority (void);
 
 
-void donate_priority_thread(struct thread *t);
-
-
 #endif /* threads/thread.h */
\ No newline at end of file
@@ -34,6 +34,17 @@
 /* Kernel virtual address start */
 #define KERN_BASE LOADER_KERN_BASE
 
+/* Kernel virtual range for vmalloc().  It lies in the same
+ * PML4 slot as KERN_BASE, whose page directory pointer table
+ * every page table made by pml4_create() shares, far above the
+ * mapping of physical memory. */
+#define VMALLOC_START 0xc000000000
+#define VMALLOC_END   0xc040000000
+
+/* Returns true if VADDR is in the vmalloc() range. */
+#define is_vmalloc_vaddr(vaddr) \
+	((uint64_t) (vaddr) >= VMALLOC_START && (uint64_t) (vaddr) < VMALLOC_END)
+
 /* User stack start */
 #define USER_STACK 0x47480000
 
@@ -0,0 +1,18 @@
+#ifndef THREADS_VMALLOC_H
+#define THREADS_VMALLOC_H
+
+#include <stddef.h>
+
+/* 가상으로만 연속인 큰 할당 (vmalloc).
+ *
+ * 커널 풀에서 페이지를 하나씩 받아 VMALLOC_START부터의 커널 가상
+ * 주소에 이어 붙여 매핑합니다.  물리적으로 연속인 페이지가 필요
+ * 없으므로 풀이 조각나 있어도 성공하고, 연속인 메모리는 정말
+ * 필요한 곳에 남겨 둡니다.  영역마다 뒤에 매핑하지 않은 보호
+ * 페이지를 하나 두어 넘쳐 쓰면 바로 페이지 폴트가 납니다. */
+
+void vmalloc_init (void);
+void *vmalloc (size_t size);
+void vfree (void *);
+
+#endif /* threads/vmalloc.h */
@@ -0,0 +1,73 @@
+#ifndef THREADS_WORKQUEUE_H
+#define THREADS_WORKQUEUE_H
+
+#include <list.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <wheel.h>
+
+/* 작업 큐 (Work queue).
+ *
+ * 급하지 않은 일을 지연 시간에 민감한 경로에서 떼어 내 작업자
+ * 스레드들에게 맡깁니다.  작업 항목(struct work)은 함수와 인자를
+ * 담고, 작업 큐에 넣으면 큐의 작업자 스레드 중 하나가 인터럽트를 켠
+ * 채로 그 함수를 호출합니다.  지연 작업은 타이머 틱으로 정한 시간이
+ * 지난 뒤에 큐에 들어갑니다.
+ *
+ * 작업 항목은 메모리를 할당하지 않으므로 호출자가 자리를 마련해야
+ * 하고, 큐에 들어 있거나 실행 중인 동안에는 그대로 두어야 합니다.
+ * 작업 함수는 자기 항목을 해제해도 됩니다. */
+
+/* 작업 함수. */
+typedef void work_func (void *aux);
+
+/* 작업 항목의 상태. */
+enum work_state {
+	WORK_IDLE,                  /* 큐에도 타이머에도 없음. */
+	WORK_DELAYED,               /* 타이머가 끝나기를 기다리는 중. */
+	WORK_QUEUED                 /* 작업자를 기다리는 중. */
+};
+
+/* 작업 항목. */
+struct work {
+	work_func *func;            /* 실행할 함수. */
+	void *aux;                  /* 그 인자. */
+	enum work_state state;      /* 상태. */
+	struct workqueue *wq;       /* 들어간 (또는 들어갈) 큐. */
+	struct list_elem elem;      /* 큐의 pending 리스트 원소. */
+	struct wheel_elem timer;    /* 지연 작업의 타이머 휠 원소. */
+};
+
+/* 작업 큐와 그 작업자 스레드들. */
+struct workqueue {
+	const char *name;           /* 이름 (작업자 스레드 이름에도 씀). */
+	int priority;               /* 작업자 스레드의 우선순위. */
+	int nr_workers;             /* 작업자 스레드 수. */
+	struct list pending;        /* 실행을 기다리는 작업들. */
+	struct list idle;           /* 일감을 기다리며 잠든 작업자들. */
+	struct list busy;           /* 작업을 실행 중인 작업자들. */
+	struct list waiters;        /* flush 중에 잠든 스레드들. */
+};
+
+/* 시스템 전체가 함께 쓰는 작업 큐.  CPU마다 작업자가 하나씩
+   있습니다. */
+extern struct workqueue *system_wq;
+
+/* 지연 작업 중 가장 먼저 큐에 들어갈 틱.  timer_interrupt()는 이
+   틱 전에는 workqueue_timer()를 부르지 않습니다. */
+extern int64_t work_next_deadline;
+
+void workqueue_init (void);
+struct workqueue *workqueue_create (const char *name, int priority,
+		int nr_workers);
+void workqueue_flush (struct workqueue *);
+
+void work_init (struct work *, work_func *, void *aux);
+bool work_queue (struct workqueue *, struct work *);
+bool work_queue_delayed (struct workqueue *, struct work *, int64_t ticks);
+bool work_cancel (struct work *);
+bool work_flush (struct work *);
+
+void workqueue_timer (int64_t ticks);
+
+#endif /* threads/workqueue.h */
@@ -62,7 +62,7 @@ static int64_t write_cnt;
 /* Enable console locking. */
 void
 console_init (void) {
-	lock_init (&console_lock);
+	lock_init_named (&console_lock, "console");
 	use_console_lock = true;
 }
 
@@ -0,0 +1,228 @@
+/* Pairing heap.
+
+   See heap.h for basic information.  The heap is a single tree
+   whose root is the greatest element.  Inserting an element
+   "melds" it with the root, making the smaller of the two the
+   leftmost child of the greater.  Removing the root melds its
+   children back together in two passes, first in pairs from left
+   to right and then the pairs from right to left, which is what
+   gives the O(log n) amortized bound.  See Fredman, Sedgewick,
+   Sleator and Tarjan, "The pairing heap: a new form of
+   self-adjusting heap", Algorithmica 1 (1986). */
+
+#include "heap.h"
+#include "../debug.h"
+
+static bool above (const struct heap *, const struct heap_elem *,
+		const struct heap_elem *);
+static struct heap_elem *meld (const struct heap *,
+		struct heap_elem *, struct heap_elem *);
+static struct heap_elem *merge_pairs (const struct heap *,
+		struct heap_elem *);
+static void cut (struct heap_elem *);
+static void detach (struct heap *, struct heap_elem *);
+
+/* Initializes H as an empty heap ordered by LESS, given
+   auxiliary data AUX. */
+void
+heap_init (struct heap *h, heap_less_func *less, void *aux) {
+	ASSERT (h != NULL);
+	ASSERT (less != NULL);
+
+	h->root = NULL;
+	h->elem_cnt = 0;
+	h->next_seq = 0;
+	h->less = less;
+	h->aux = aux;
+}
+
+/* Initializes E as an element that is not on any heap. */
+void
+heap_elem_init (struct heap_elem *e) {
+	ASSERT (e != NULL);
+
+	e->child = e->next = e->prev = NULL;
+	e->seq = 0;
+}
+
+/* Inserts E into H.  E must not already be on a heap. */
+void
+heap_push (struct heap *h, struct heap_elem *e) {
+	ASSERT (h != NULL);
+	ASSERT (e != NULL);
+	ASSERT (e != h->root);
+
+	e->child = e->next = e->prev = NULL;
+	e->seq = h->next_seq++;
+	h->root = meld (h, h->root, e);
+	h->elem_cnt++;
+}
+
+/* Returns the greatest element in H, or a null pointer if H is
+   empty.  If more than one element is greatest, returns the one
+   that was inserted first. */
+struct heap_elem *
+heap_top (const struct heap *h) {
+	ASSERT (h != NULL);
+
+	return h->root;
+}
+
+/* Removes and returns the greatest element in H, or returns a
+   null pointer if H is empty. */
+struct heap_elem *
+heap_pop (struct heap *h) {
+	struct heap_elem *top;
+
+	ASSERT (h != NULL);
+
+	top = h->root;
+	if (top != NULL)
+		heap_remove (h, top);
+	return top;
+}
+
+/* Removes E, which must be on H, from H. */
+void
+heap_remove (struct heap *h, struct heap_elem *e) {
+	ASSERT (h != NULL);
+	ASSERT (e != NULL);
+	ASSERT (h->elem_cnt > 0);
+
+	detach (h, e);
+	e->child = e->next = e->prev = NULL;
+	h->elem_cnt--;
+}
+
+/* Restores the order of H after the value of E, which must be
+   on H, has changed in either direction.  E keeps its place
+   among elements that compare equal to it. */
+void
+heap_update (struct heap *h, struct heap_elem *e) {
+	ASSERT (h != NULL);
+	ASSERT (e != NULL);
+
+	detach (h, e);
+	e->child = e->next = e->prev = NULL;
+	h->root = meld (h, h->root, e);
+}
+
+/* Returns the number of elements in H. */
+size_t
+heap_size (const struct heap *h) {
+	ASSERT (h != NULL);
+
+	return h->elem_cnt;
+}
+
+/* Returns true if H is empty, false otherwise.  Unlike H's
+   root, the answer does not change while heap_update() is
+   re-linking an element. */
+bool
+heap_empty (const struct heap *h) {
+	ASSERT (h != NULL);
+
+	return h->elem_cnt == 0;
+}
+
+/* Returns true if A belongs above B in H: A is greater, or equal
+   and inserted earlier. */
+static bool
+above (const struct heap *h, const struct heap_elem *a,
+		const struct heap_elem *b) {
+	if (h->less (b, a, h->aux))
+		return true;
+	if (h->less (a, b, h->aux))
+		return false;
+	return (long) (a->seq - b->seq) < 0;
+}
+
+/* Melds the trees rooted at A and B, either of which may be
+   null, and returns the root of the result.  A and B must be
+   roots, that is, have no siblings. */
+static struct heap_elem *
+meld (const struct heap *h, struct heap_elem *a, struct heap_elem *b) {
+	if (a == NULL)
+		return b;
+	if (b == NULL)
+		return a;
+	if (above (h, b, a)) {
+		struct heap_elem *t = a;
+		a = b;
+		b = t;
+	}
+
+	b->prev = a;
+	b->next = a->child;
+	if (a->child != NULL)
+		a->child->prev = b;
+	a->child = b;
+	return a;
+}
+
+/* Melds the list of sibling trees that starts at FIRST into one
+   tree and returns its root, or a null pointer if FIRST is
+   null. */
+static struct heap_elem *
+merge_pairs (const struct heap *h, struct heap_elem *first) {
+	struct heap_elem *pairs = NULL;
+	struct heap_elem *root;
+
+	/* Left to right: meld adjacent pairs, stacking the results
+	   through their `next' members, last pair on top. */
+	while (first != NULL) {
+		struct heap_elem *a = first;
+		struct heap_elem *b = a->next;
+		struct heap_elem *m;
+
+		first = b != NULL ? b->next : NULL;
+		a->next = a->prev = NULL;
+		if (b != NULL)
+			b->next = b->prev = NULL;
+		m = meld (h, a, b);
+		m->next = pairs;
+		pairs = m;
+	}
+
+	/* Right to left: meld the pairs into one tree. */
+	root = NULL;
+	while (pairs != NULL) {
+		struct heap_elem *next = pairs->next;
+
+		pairs->next = NULL;
+		root = meld (h, root, pairs);
+		pairs = next;
+	}
+	return root;
+}
+
+/* Unlinks E, which must not be a root, from its parent and
+   siblings.  E keeps its own children. */
+static void
+cut (struct heap_elem *e) {
+	ASSERT (e->prev != NULL);
+
+	if (e->prev->child == e)
+		e->prev->child = e->next;
+	else
+		e->prev->next = e->next;
+	if (e->next != NULL)
+		e->next->prev = e->prev;
+	e->next = e->prev = NULL;
+}
+
+/* Takes E out of H's tree, melding E's children back in.  Does
+   not change H's element count. */
+static void
+detach (struct heap *h, struct heap_elem *e) {
+	struct heap_elem *children;
+
+	if (e != h->root)
+		cut (e);
+	children = merge_pairs (h, e->child);
+	e->child = NULL;
+	if (e == h->root)
+		h->root = children;
+	else
+		h->root = meld (h, h->root, children);
+}
@@ -0,0 +1,326 @@
+/* Red-black tree.
+
+   See rbtree.h for basic information.  The tree follows the
+   usual rules: every node is red or black, the root is black, a
+   red node has no red child, and every path from a node down to
+   a leaf passes through the same number of black nodes.
+   Together they keep the longest path at most twice as long as
+   the shortest.  The fix-up code after insertion and removal is
+   the one from Cormen, Leiserson, Rivest and Stein,
+   "Introduction to Algorithms", chapter 13, adapted to null
+   leaves. */
+
+#include "rbtree.h"
+#include "../debug.h"
+
+static bool is_red (const struct rb_node *);
+static struct rb_node *leftmost (struct rb_node *);
+static void rotate_left (struct rb_tree *, struct rb_node *);
+static void rotate_right (struct rb_tree *, struct rb_node *);
+static void replace (struct rb_tree *, struct rb_node *,
+		struct rb_node *);
+static void insert_fixup (struct rb_tree *, struct rb_node *);
+static void remove_fixup (struct rb_tree *, struct rb_node *,
+		struct rb_node *);
+
+/* Initializes T as an empty tree ordered by LESS, given
+   auxiliary data AUX. */
+void
+rb_init (struct rb_tree *t, rb_less_func *less, void *aux) {
+	ASSERT (t != NULL);
+	ASSERT (less != NULL);
+
+	t->root = t->first = NULL;
+	t->node_cnt = 0;
+	t->less = less;
+	t->aux = aux;
+}
+
+/* Inserts N into T, after any elements equal to it.  N must not
+   already be in a tree. */
+void
+rb_insert (struct rb_tree *t, struct rb_node *n) {
+	struct rb_node *parent = NULL;
+	struct rb_node **link = &t->root;
+	bool is_first = true;
+
+	ASSERT (t != NULL);
+	ASSERT (n != NULL);
+
+	while (*link != NULL) {
+		parent = *link;
+		if (t->less (n, parent, t->aux))
+			link = &parent->left;
+		else {
+			link = &parent->right;
+			is_first = false;
+		}
+	}
+
+	n->parent = parent;
+	n->left = n->right = NULL;
+	n->red = true;
+	*link = n;
+	if (is_first)
+		t->first = n;
+	t->node_cnt++;
+
+	insert_fixup (t, n);
+}
+
+/* Removes N, which must be in T, from T. */
+void
+rb_remove (struct rb_tree *t, struct rb_node *n) {
+	struct rb_node *child, *parent;
+	bool removed_red;
+
+	ASSERT (t != NULL);
+	ASSERT (n != NULL);
+	ASSERT (t->node_cnt > 0);
+
+	if (t->first == n)
+		t->first = rb_next (n);
+
+	if (n->left == NULL || n->right == NULL) {
+		/* N has at most one child, which takes its place. */
+		child = n->left != NULL ? n->left : n->right;
+		parent = n->parent;
+		removed_red = n->red;
+		replace (t, n, child);
+	} else {
+		/* N's successor Y has no left child.  Y leaves its own spot
+		   to its right child and takes N's place and color. */
+		struct rb_node *y = leftmost (n->right);
+
+		child = y->right;
+		removed_red = y->red;
+		if (y->parent == n)
+			parent = y;
+		else {
+			parent = y->parent;
+			replace (t, y, y->right);
+			y->right = n->right;
+			y->right->parent = y;
+		}
+		replace (t, n, y);
+		y->left = n->left;
+		y->left->parent = y;
+		y->red = n->red;
+	}
+
+	n->parent = n->left = n->right = NULL;
+	t->node_cnt--;
+
+	if (!removed_red)
+		remove_fixup (t, child, parent);
+}
+
+/* Returns the smallest element in T, or a null pointer if T is
+   empty.  If more than one element is smallest, returns the one
+   that was inserted first. */
+struct rb_node *
+rb_first (const struct rb_tree *t) {
+	ASSERT (t != NULL);
+
+	return t->first;
+}
+
+/* Returns the element that follows N in its tree, or a null
+   pointer if N is the greatest element. */
+struct rb_node *
+rb_next (const struct rb_node *n) {
+	struct rb_node *parent;
+
+	ASSERT (n != NULL);
+
+	if (n->right != NULL)
+		return leftmost (n->right);
+	while ((parent = n->parent) != NULL && n == parent->right)
+		n = parent;
+	return parent;
+}
+
+/* Returns the number of elements in T. */
+size_t
+rb_size (const struct rb_tree *t) {
+	ASSERT (t != NULL);
+
+	return t->node_cnt;
+}
+
+/* Returns true if T is empty, false otherwise. */
+bool
+rb_empty (const struct rb_tree *t) {
+	ASSERT (t != NULL);
+
+	return t->root == NULL;
+}
+
+/* Returns true if N is red.  Null leaves are black. */
+static bool
+is_red (const struct rb_node *n) {
+	return n != NULL && n->red;
+}
+
+/* Returns the smallest element in the subtree rooted at N. */
+static struct rb_node *
+leftmost (struct rb_node *n) {
+	while (n->left != NULL)
+		n = n->left;
+	return n;
+}
+
+/* Rotates the subtree rooted at X to the left, so that X's right
+   child takes X's place and X becomes its left child. */
+static void
+rotate_left (struct rb_tree *t, struct rb_node *x) {
+	struct rb_node *y = x->right;
+
+	x->right = y->left;
+	if (y->left != NULL)
+		y->left->parent = x;
+	replace (t, x, y);
+	y->left = x;
+	x->parent = y;
+}
+
+/* Rotates the subtree rooted at X to the right, so that X's left
+   child takes X's place and X becomes its right child. */
+static void
+rotate_right (struct rb_tree *t, struct rb_node *x) {
+	struct rb_node *y = x->left;
+
+	x->left = y->right;
+	if (y->right != NULL)
+		y->right->parent = x;
+	replace (t, x, y);
+	y->right = x;
+	x->parent = y;
+}
+
+/* Puts N, which may be null, where OLD is in T's tree by linking
+   it to OLD's parent.  OLD's children are left alone. */
+static void
+replace (struct rb_tree *t, struct rb_node *old, struct rb_node *n) {
+	struct rb_node *parent = old->parent;
+
+	if (parent == NULL)
+		t->root = n;
+	else if (parent->left == old)
+		parent->left = n;
+	else
+		parent->right = n;
+	if (n != NULL)
+		n->parent = parent;
+}
+
+/* Restores the red-black rules after inserting red node N. */
+static void
+insert_fixup (struct rb_tree *t, struct rb_node *n) {
+	struct rb_node *parent;
+
+	while ((parent = n->parent) != NULL && parent->red) {
+		/* PARENT is red, so it is not the root. */
+		struct rb_node *grand = parent->parent;
+
+		if (parent == grand->left) {
+			struct rb_node *uncle = grand->right;
+
+			if (is_red (uncle)) {
+				parent->red = uncle->red = false;
+				grand->red = true;
+				n = grand;
+				continue;
+			}
+			if (n == parent->right) {
+				rotate_left (t, parent);
+				n = parent;
+				parent = n->parent;
+			}
+			parent->red = false;
+			grand->red = true;
+			rotate_right (t, grand);
+		} else {
+			struct rb_node *uncle = grand->left;
+
+			if (is_red (uncle)) {
+				parent->red = uncle->red = false;
+				grand->red = true;
+				n = grand;
+				continue;
+			}
+			if (n == parent->left) {
+				rotate_right (t, parent);
+				n = parent;
+				parent = n->parent;
+			}
+			parent->red = false;
+			grand->red = true;
+			rotate_left (t, grand);
+		}
+	}
+	t->root->red = false;
+}
+
+/* Restores the red-black rules after removing a black node.  N,
+   which may be a null leaf, took the removed node's place below
+   PARENT and is short one black node on every path. */
+static void
+remove_fixup (struct rb_tree *t, struct rb_node *n, struct rb_node *parent) {
+	while (n != t->root && !is_red (n)) {
+		if (n == parent->left) {
+			struct rb_node *sibling = parent->right;
+
+			if (sibling->red) {
+				sibling->red = false;
+				parent->red = true;
+				rotate_left (t, parent);
+				sibling = parent->right;
+			}
+			if (!is_red (sibling->left) && !is_red (sibling->right)) {
+				sibling->red = true;
+				n = parent;
+				parent = n->parent;
+				continue;
+			}
+			if (!is_red (sibling->right)) {
+				sibling->left->red = false;
+				sibling->red = true;
+				rotate_right (t, sibling);
+				sibling = parent->right;
+			}
+			sibling->red = parent->red;
+			parent->red = false;
+			sibling->right->red = false;
+			rotate_left (t, parent);
+		} else {
+			struct rb_node *sibling = parent->left;
+
+			if (sibling->red) {
+				sibling->red = false;
+				parent->red = true;
+				rotate_right (t, parent);
+				sibling = parent->left;
+			}
+			if (!is_red (sibling->left) && !is_red (sibling->right)) {
+				sibling->red = true;
+				n = parent;
+				parent = n->parent;
+				continue;
+			}
+			if (!is_red (sibling->left)) {
+				sibling->right->red = false;
+				sibling->red = true;
+				rotate_left (t, sibling);
+				sibling = parent->left;
+			}
+			sibling->red = parent->red;
+			parent->red = false;
+			sibling->left->red = false;
+			rotate_right (t, parent);
+		}
+		n = t->root;
+	}
+	if (n != NULL)
+		n->red = false;
+}
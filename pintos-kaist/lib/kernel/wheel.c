@@ -0,0 +1,303 @@
+/* Hierarchical timer wheel.
+
+   See wheel.h for basic information. */
+
+#include "wheel.h"
+#include "../debug.h"
+
+#define L0_MASK (WHEEL_L0_SIZE - 1)
+#define LN_MASK (WHEEL_LN_SIZE - 1)
+
+/* Largest distance from the wheel base that the top level can
+   represent.  Elements further out are parked in the top level's
+   last reachable slot and re-sorted each time it cascades. */
+#define MAX_DELTA (((int64_t) 1 << level_shift (WHEEL_LEVELS)) - 1)
+
+#define list_elem_to_wheel_elem(LIST_ELEM)                      \
+	list_entry(LIST_ELEM, struct wheel_elem, list_elem)
+
+static int level_shift (int level);
+static int slot_index (int level, int idx);
+static void mark_slot (struct wheel *, int slot);
+static void unmark_slot_if_empty (struct wheel *, int slot);
+static int find_next_bit (uint64_t bits, int start);
+static void cascade (struct wheel *, int level, int idx);
+static void run_tick (struct wheel *, wheel_action_func *, void *aux);
+
+/* Initializes W as an empty wheel whose first unprocessed tick
+   is BASE. */
+void
+wheel_init (struct wheel *w, int64_t base) {
+	size_t i;
+
+	w->base = base;
+	w->elem_cnt = 0;
+	for (i = 0; i < sizeof w->l0_used / sizeof *w->l0_used; i++)
+		w->l0_used[i] = 0;
+	for (i = 0; i < sizeof w->ln_used / sizeof *w->ln_used; i++)
+		w->ln_used[i] = 0;
+	for (i = 0; i < WHEEL_SLOTS; i++)
+		list_init (&w->slots[i]);
+}
+
+/* Initializes E as an element that is not on any wheel. */
+void
+wheel_elem_init (struct wheel_elem *e) {
+	e->expires = 0;
+	e->slot = -1;
+}
+
+/* Returns true if E is currently on a wheel. */
+bool
+wheel_elem_pending (const struct wheel_elem *e) {
+	return e->slot >= 0;
+}
+
+/* Inserts E into W so that it expires at tick EXPIRES.  E must
+   not already be on a wheel.  An EXPIRES that has already passed
+   makes E expire on the next call to wheel_advance(). */
+void
+wheel_insert (struct wheel *w, struct wheel_elem *e, int64_t expires) {
+	int64_t delta = expires - w->base;
+	int slot;
+
+	ASSERT (w != NULL);
+	ASSERT (e != NULL);
+	ASSERT (!wheel_elem_pending (e));
+
+	e->expires = expires;
+	if (delta < 0)
+		slot = slot_index (0, w->base & L0_MASK);
+	else if (delta < WHEEL_L0_SIZE)
+		slot = slot_index (0, expires & L0_MASK);
+	else {
+		int64_t key = expires;
+		int level;
+
+		if (delta > MAX_DELTA)
+			key = w->base + MAX_DELTA;
+		for (level = 1; level < WHEEL_LEVELS - 1; level++)
+			if (delta < ((int64_t) 1 << level_shift (level + 1)))
+				break;
+		slot = slot_index (level, (key >> level_shift (level)) & LN_MASK);
+	}
+
+	list_push_back (&w->slots[slot], &e->list_elem);
+	e->slot = slot;
+	mark_slot (w, slot);
+	w->elem_cnt++;
+}
+
+/* Removes E, which must be pending, from W. */
+void
+wheel_remove (struct wheel *w, struct wheel_elem *e) {
+	ASSERT (w != NULL);
+	ASSERT (wheel_elem_pending (e));
+
+	list_remove (&e->list_elem);
+	unmark_slot_if_empty (w, e->slot);
+	e->slot = -1;
+	w->elem_cnt--;
+}
+
+/* Processes every tick of W up to and including NOW.  Each
+   element whose expiration tick has been reached is removed from
+   W and then passed to ACTION along with AUX.  ACTION may insert
+   elements into W, including the one it was passed.
+
+   Ticks on which nothing expires and nothing cascades are
+   skipped without being visited, so the cost is proportional to
+   the work actually done rather than to the number of ticks. */
+void
+wheel_advance (struct wheel *w, int64_t now,
+		wheel_action_func *action, void *aux) {
+	ASSERT (w != NULL);
+	ASSERT (action != NULL);
+
+	while (w->base <= now) {
+		int64_t next = wheel_next_deadline (w);
+
+		if (next > now) {
+			w->base = now + 1;
+			break;
+		}
+		w->base = next;
+		run_tick (w, action, aux);
+	}
+}
+
+/* Returns the earliest tick at which W has work to do: an
+   element expires or a non-empty upper slot cascades.  No
+   element expires before the returned tick, so a caller may skip
+   wheel_advance() until it is reached.  Returns INT64_MAX if W is
+   empty. */
+int64_t
+wheel_next_deadline (const struct wheel *w) {
+	int64_t deadline = INT64_MAX;
+	int start, bit, level;
+	size_t i, words;
+
+	if (w->elem_cnt == 0)
+		return INT64_MAX;
+
+	/* Level 0: nearest non-empty slot, searching circularly
+	   from the base. */
+	start = w->base & L0_MASK;
+	words = sizeof w->l0_used / sizeof *w->l0_used;
+	for (i = 0; i <= words; i++) {
+		size_t word = ((start >> 6) + i) % words;
+		uint64_t bits = w->l0_used[word];
+
+		if (i == 0)
+			bits &= ~0ULL << (start & 63);
+		else if (i == words)
+			bits &= (1ULL << (start & 63)) - 1;
+		if (bits != 0) {
+			bit = word * 64 + __builtin_ctzll (bits);
+			deadline = w->base + ((bit - start) & L0_MASK);
+			break;
+		}
+	}
+
+	/* Upper levels: the first tick at which a non-empty slot is
+	   cascaded.  Slot IDX of LEVEL cascades on ticks that are a
+	   multiple of the level's granularity and whose index at that
+	   level is IDX. */
+	for (level = 1; level < WHEEL_LEVELS; level++) {
+		uint64_t used = w->ln_used[level - 1];
+		int shift = level_shift (level);
+		int64_t first;
+
+		if (used == 0)
+			continue;
+		first = (w->base + ((int64_t) 1 << shift) - 1) >> shift;
+		bit = find_next_bit (used, first & LN_MASK);
+		first += (bit - first) & LN_MASK;
+		if ((first << shift) < deadline)
+			deadline = first << shift;
+	}
+	return deadline;
+}
+
+/* Returns the number of elements on W. */
+size_t
+wheel_size (const struct wheel *w) {
+	return w->elem_cnt;
+}
+
+/* Returns true if W is empty, false otherwise. */
+bool
+wheel_empty (const struct wheel *w) {
+	return w->elem_cnt == 0;
+}
+
+/* Returns the number of low tick bits consumed below LEVEL. */
+static int
+level_shift (int level) {
+	return level == 0 ? 0 : WHEEL_L0_BITS + (level - 1) * WHEEL_LN_BITS;
+}
+
+/* Returns the index into the slots array of slot IDX of LEVEL. */
+static int
+slot_index (int level, int idx) {
+	if (level == 0)
+		return idx;
+	return WHEEL_L0_SIZE + (level - 1) * WHEEL_LN_SIZE + idx;
+}
+
+/* Records that SLOT of W is not empty. */
+static void
+mark_slot (struct wheel *w, int slot) {
+	if (slot < WHEEL_L0_SIZE)
+		w->l0_used[slot / 64] |= 1ULL << (slot % 64);
+	else {
+		slot -= WHEEL_L0_SIZE;
+		w->ln_used[slot / WHEEL_LN_SIZE] |= 1ULL << (slot % WHEEL_LN_SIZE);
+	}
+}
+
+/* Clears SLOT's bit in W if SLOT has become empty. */
+static void
+unmark_slot_if_empty (struct wheel *w, int slot) {
+	if (!list_empty (&w->slots[slot]))
+		return;
+	if (slot < WHEEL_L0_SIZE)
+		w->l0_used[slot / 64] &= ~(1ULL << (slot % 64));
+	else {
+		slot -= WHEEL_L0_SIZE;
+		w->ln_used[slot / WHEEL_LN_SIZE] &= ~(1ULL << (slot % WHEEL_LN_SIZE));
+	}
+}
+
+/* Returns the first set bit of BITS at or after START, wrapping
+   around to bit 0.  BITS must not be zero. */
+static int
+find_next_bit (uint64_t bits, int start) {
+	uint64_t high = bits & (~0ULL << start);
+
+	ASSERT (bits != 0);
+	return __builtin_ctzll (high != 0 ? high : bits);
+}
+
+/* Empties slot IDX of LEVEL in W and reinserts its elements
+   relative to the current base, which moves them to finer
+   slots. */
+static void
+cascade (struct wheel *w, int level, int idx) {
+	int slot = slot_index (level, idx);
+	struct list pending;
+
+	if (list_empty (&w->slots[slot]))
+		return;
+
+	list_init (&pending);
+	while (!list_empty (&w->slots[slot]))
+		list_push_back (&pending, list_pop_front (&w->slots[slot]));
+	unmark_slot_if_empty (w, slot);
+
+	while (!list_empty (&pending)) {
+		struct wheel_elem *e = list_elem_to_wheel_elem (list_pop_front (&pending));
+
+		e->slot = -1;
+		w->elem_cnt--;
+		wheel_insert (w, e, e->expires);
+	}
+}
+
+/* Processes tick W->base: cascades upper levels that wrap on
+   this tick, then expires the level-0 slot for the tick and
+   advances the base past it. */
+static void
+run_tick (struct wheel *w, wheel_action_func *action, void *aux) {
+	int64_t tick = w->base;
+	int slot = slot_index (0, tick & L0_MASK);
+	struct list expired;
+	int level;
+
+	if ((tick & L0_MASK) == 0)
+		for (level = 1; level < WHEEL_LEVELS; level++) {
+			int idx = (tick >> level_shift (level)) & LN_MASK;
+
+			cascade (w, level, idx);
+			if (idx != 0)
+				break;
+		}
+
+	/* Detach the expired elements before running any action, so
+	   that actions which re-arm an element see a consistent
+	   wheel. */
+	list_init (&expired);
+	while (!list_empty (&w->slots[slot])) {
+		struct wheel_elem *e =
+			list_elem_to_wheel_elem (list_pop_front (&w->slots[slot]));
+
+		e->slot = -1;
+		w->elem_cnt--;
+		list_push_back (&expired, &e->list_elem);
+	}
+	unmark_slot_if_empty (w, slot);
+	w->base = tick + 1;
+
+	while (!list_empty (&expired))
+		action (list_elem_to_wheel_elem (list_pop_front (&expired)), aux);
+}
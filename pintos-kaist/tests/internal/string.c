@@ -0,0 +1,149 @@
+/* Test program for the block functions in lib/string.c.
+
+   memcpy(), memmove(), memset(), memcmp() and strlen() take
+   different paths depending on block size and alignment, so this
+   checks each of them against a plain byte-at-a-time version for
+   every size up to a few hundred bytes at every alignment of the
+   source and destination within a word.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <debug.h>
+#include <random.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/test.h"
+
+/* Largest block size that we will test.  Well past the point
+   where the string instructions take over. */
+#define MAX_SIZE 600
+
+/* Alignments tried for each block, 0 through 8. */
+#define MAX_OFS 8
+
+#define BUF_SIZE (2 * MAX_SIZE + 4 * MAX_OFS)
+
+static unsigned char src[BUF_SIZE], dst[BUF_SIZE], ref[BUF_SIZE];
+
+static void randomize (unsigned char *, size_t);
+static void test_memcpy (size_t size, int src_ofs, int dst_ofs);
+static void test_memmove (size_t size, int src_ofs, int dst_ofs);
+static void test_memset (size_t size, int dst_ofs);
+static void test_memcmp (size_t size, int ofs);
+static void test_strlen (size_t size, int ofs);
+
+/* Test the block functions. */
+void
+test (void) 
+{
+  size_t size;
+  int src_ofs, dst_ofs;
+
+  printf ("testing block sizes 0...%d at all alignments...", MAX_SIZE);
+  for (size = 0; size <= MAX_SIZE; size++)
+    for (src_ofs = 0; src_ofs <= MAX_OFS; src_ofs++)
+      {
+        for (dst_ofs = 0; dst_ofs <= MAX_OFS; dst_ofs++)
+          {
+            test_memcpy (size, src_ofs, dst_ofs);
+            test_memmove (size, src_ofs, dst_ofs);
+          }
+        test_memset (size, src_ofs);
+        test_memcmp (size, src_ofs);
+        test_strlen (size, src_ofs);
+      }
+  printf (" done\n");
+}
+
+/* Fills the CNT bytes at P with random values. */
+static void
+randomize (unsigned char *p, size_t cnt) 
+{
+  random_bytes (p, cnt);
+}
+
+static void
+test_memcpy (size_t size, int src_ofs, int dst_ofs) 
+{
+  size_t i;
+
+  randomize (src, sizeof src);
+  randomize (dst, sizeof dst);
+  memcpy (ref, dst, sizeof ref);
+  for (i = 0; i < size; i++)
+    ref[dst_ofs + i] = src[src_ofs + i];
+
+  ASSERT (memcpy (dst + dst_ofs, src + src_ofs, size) == dst + dst_ofs);
+  for (i = 0; i < sizeof dst; i++)
+    ASSERT (dst[i] == ref[i]);
+}
+
+/* Moves within one buffer, both downward and upward, by
+   distances shorter and longer than a word. */
+static void
+test_memmove (size_t size, int src_ofs, int dst_ofs) 
+{
+  size_t from = MAX_SIZE / 2 + src_ofs;
+  size_t to = MAX_SIZE / 2 + dst_ofs * 3;
+  size_t i;
+
+  randomize (dst, sizeof dst);
+  memcpy (ref, dst, sizeof ref);
+  if (to < from)
+    for (i = 0; i < size; i++)
+      ref[to + i] = ref[from + i];
+  else
+    for (i = size; i-- > 0; )
+      ref[to + i] = ref[from + i];
+
+  ASSERT (memmove (dst + to, dst + from, size) == dst + to);
+  for (i = 0; i < sizeof dst; i++)
+    ASSERT (dst[i] == ref[i]);
+}
+
+static void
+test_memset (size_t size, int dst_ofs) 
+{
+  int value = random_ulong () & 0xff;
+  size_t i;
+
+  randomize (dst, sizeof dst);
+  memcpy (ref, dst, sizeof ref);
+  for (i = 0; i < size; i++)
+    ref[dst_ofs + i] = value;
+
+  ASSERT (memset (dst + dst_ofs, value, size) == dst + dst_ofs);
+  for (i = 0; i < sizeof dst; i++)
+    ASSERT (dst[i] == ref[i]);
+}
+
+/* Compares equal blocks, then blocks that differ in one byte,
+   first in each direction. */
+static void
+test_memcmp (size_t size, int ofs) 
+{
+  size_t pos;
+
+  randomize (src, sizeof src);
+  memcpy (dst, src, sizeof dst);
+  ASSERT (memcmp (src + ofs, dst + ofs, size) == 0);
+  if (size == 0)
+    return;
+
+  pos = ofs + random_ulong () % size;
+  src[pos] = 0x80;
+  dst[pos] = 0x7f;
+  ASSERT (memcmp (src + ofs, dst + ofs, size) > 0);
+  ASSERT (memcmp (dst + ofs, src + ofs, size) < 0);
+}
+
+static void
+test_strlen (size_t size, int ofs) 
+{
+  memset (src, 'x', sizeof src);
+  src[ofs + size] = '\0';
+  ASSERT (strlen ((char *) src + ofs) == size);
+}
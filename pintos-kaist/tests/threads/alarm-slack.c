@@ -0,0 +1,89 @@
+/* Checks timer_sleep_slack().  Five threads go to sleep on the
+   same tick for 10, 11, ..., 14 ticks, each allowing its wakeup
+   to be up to 10 ticks late.  Every thread must wake up within
+   its window, and since the windows overlap, the wakeups must be
+   coalesced onto fewer ticks than there are threads. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 5
+#define SLACK 10
+
+struct sleeper
+  {
+    int64_t duration;           /* Ticks to sleep. */
+    int64_t start;              /* Tick at which it went to sleep. */
+    int64_t woke;               /* Tick at which it woke up. */
+  };
+
+static thread_func sleeper_thread;
+static struct semaphore done;
+
+void
+test_alarm_slack (void)
+{
+  struct sleeper sleepers[THREAD_CNT];
+  int64_t start_time;
+  int wakeup_ticks;
+  int i, j;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&done, 0);
+
+  /* Start at the beginning of a tick, so that all the sleepers
+     go to sleep on the same tick. */
+  start_time = timer_ticks ();
+  while (timer_elapsed (start_time) == 0)
+    continue;
+
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      sleepers[i].duration = 10 + i;
+      thread_create ("sleeper", PRI_DEFAULT + 1, sleeper_thread, &sleepers[i]);
+    }
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&done);
+
+  wakeup_ticks = 0;
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      struct sleeper *s = &sleepers[i];
+
+      if (s->woke < s->start + s->duration)
+        fail ("thread %d woke up %lld ticks early", i,
+              s->start + s->duration - s->woke);
+      if (s->woke > s->start + s->duration + SLACK)
+        fail ("thread %d woke up %lld ticks late", i,
+              s->woke - (s->start + s->duration));
+
+      for (j = 0; j < i; j++)
+        if (sleepers[j].woke == s->woke)
+          break;
+      if (j == i)
+        wakeup_ticks++;
+    }
+  msg ("All threads woke up within their windows.");
+
+  if (wakeup_ticks >= THREAD_CNT)
+    fail ("%d threads woke up on %d different ticks",
+          THREAD_CNT, wakeup_ticks);
+  msg ("Wakeups were coalesced.");
+}
+
+static void
+sleeper_thread (void *s_)
+{
+  struct sleeper *s = s_;
+
+  s->start = timer_ticks ();
+  timer_sleep_slack (s->duration, SLACK);
+  s->woke = timer_ticks ();
+  sema_up (&done);
+}
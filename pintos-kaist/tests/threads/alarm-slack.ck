@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(alarm-slack) begin
+(alarm-slack) All threads woke up within their windows.
+(alarm-slack) Wakeups were coalesced.
+(alarm-slack) end
+EOF
+pass;
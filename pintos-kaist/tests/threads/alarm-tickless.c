@@ -0,0 +1,65 @@
+/* Sleeps for periods from one tick to well over a second, which
+   with -tickless go by with the periodic tick stopped, and checks
+   that timer_ticks() never runs backward, agrees with ktime_ns()
+   when the sleep ends, and that the ticks slept through were
+   charged to the idle thread. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/cpu.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+/* Returns the idle ticks of all CPUs. */
+static long long
+idle_ticks (void)
+{
+  long long sum = 0;
+  int i;
+
+  for (i = 0; i < cpu_cnt; i++)
+    sum += cpus[i].idle_ticks;
+  return sum;
+}
+
+void
+test_alarm_tickless (void)
+{
+  static const int64_t durations[] = {1, 3, 7, 30, 150};
+  const int64_t tick_ns = 1000000000 / TIMER_FREQ;
+  int64_t last = timer_ticks ();
+  size_t i;
+
+  for (i = 0; i < sizeof durations / sizeof *durations; i++)
+    {
+      int64_t d = durations[i];
+      int64_t start, elapsed, ns_ticks, slop;
+      long long idle;
+      uint64_t start_ns;
+
+      start = timer_ticks ();
+      if (start < last)
+        fail ("timer_ticks() went back from %lld to %lld", last, start);
+      start_ns = ktime_ns ();
+      idle = idle_ticks ();
+
+      timer_sleep (d);
+
+      last = timer_ticks ();
+      elapsed = last - start;
+      ns_ticks = (ktime_ns () - start_ns) / tick_ns;
+      idle = idle_ticks () - idle;
+
+      if (elapsed < d)
+        fail ("woke up after %lld of %lld ticks", elapsed, d);
+      slop = 2 + d / 10;
+      if (elapsed > ns_ticks + slop || elapsed + slop < ns_ticks)
+        fail ("timer_ticks() advanced %lld ticks while ktime_ns() "
+              "advanced %lld", elapsed, ns_ticks);
+      if (idle < d - 2)
+        fail ("only %lld of %lld ticks asleep were charged as idle",
+              idle, d);
+      msg ("Slept %lld ticks.", d);
+    }
+}
@@ -0,0 +1,43 @@
+/* Checks sub-tick sleeps.  timer_usleep() for less than a tick
+   must wait at least as long as asked, as measured by
+   ktime_ns(), and must block on a high-resolution timer rather
+   than spin when one is available. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+#include "devices/hrtimer.h"
+#include "devices/timer.h"
+
+#define SLEEP_US 2000
+#define SLEEP_CNT 5
+
+void
+test_alarm_usleep (void)
+{
+  struct thread_stats before, after;
+  uint64_t start, elapsed;
+  int i;
+
+  thread_get_stats (&before);
+  for (i = 0; i < SLEEP_CNT; i++)
+    {
+      start = ktime_ns ();
+      timer_usleep (SLEEP_US);
+      elapsed = ktime_ns () - start;
+      if (elapsed < SLEEP_US * 1000)
+        fail ("slept only %llu ns of %d us", elapsed, SLEEP_US);
+    }
+  thread_get_stats (&after);
+  msg ("Each sleep lasted at least %d us.", SLEEP_US);
+
+  if (!hrtimer_available ())
+    {
+      msg ("No high-resolution timer.");
+      return;
+    }
+  if (after.voluntary_switches - before.voluntary_switches < SLEEP_CNT)
+    fail ("sleeps did not block");
+  msg ("Sleeps blocked.");
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF', <<'EOF']);
+(alarm-usleep) begin
+(alarm-usleep) Each sleep lasted at least 2000 us.
+(alarm-usleep) Sleeps blocked.
+(alarm-usleep) end
+EOF
+(alarm-usleep) begin
+(alarm-usleep) Each sleep lasted at least 2000 us.
+(alarm-usleep) No high-resolution timer.
+(alarm-usleep) end
+EOF
+pass;
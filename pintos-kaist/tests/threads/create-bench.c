@@ -0,0 +1,48 @@
+/* Measures the cost of creating a kernel thread and letting it
+   exit.  Each child has a higher priority than the main thread,
+   so it runs to completion inside thread_create(); a round is one
+   thread_create(), two switches, a thread_exit(), and reaping the
+   dead thread's page.
+
+   The cycle count is informational; the test passes as long as
+   every child ran. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/thread.h"
+#include "intrinsic.h"
+
+#define ROUND_CNT 2000
+
+static thread_func exit_thread;
+static int ran_cnt;
+
+void
+test_create_bench (void) 
+{
+  uint64_t start, cycles;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  start = rdtsc ();
+  for (i = 0; i < ROUND_CNT; i++) 
+    if (thread_create ("child", PRI_DEFAULT + 1, exit_thread, NULL)
+        == TID_ERROR)
+      fail ("thread_create failed after %d threads", i);
+  cycles = rdtsc () - start;
+
+  if (ran_cnt != ROUND_CNT)
+    fail ("only %d of %d threads ran", ran_cnt, ROUND_CNT);
+  msg ("%d threads, %llu cycles per create and exit.",
+       ROUND_CNT, (unsigned long long) (cycles / ROUND_CNT));
+  pass ();
+}
+
+/* Thread function used by test_create_bench(). */
+static void
+exit_thread (void *aux UNUSED) 
+{
+  ran_cnt++;
+}
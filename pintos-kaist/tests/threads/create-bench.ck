@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+fail "create-bench did not report cycles per create and exit\n"
+  if !grep (/^\(create-bench\) \d+ threads, \d+ cycles per create and exit\.$/,
+	    @output);
+fail "create-bench did not pass\n"
+  if !grep ($_ eq '(create-bench) PASS', @output);
+pass;
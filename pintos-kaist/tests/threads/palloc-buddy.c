@@ -0,0 +1,97 @@
+/* Checks the buddy page allocator: multi-page blocks that are
+   not a power of two come back contiguous and zeroed, and after
+   the kernel pool has been used up one page at a time and given
+   back in a scrambled order, the pages merge back into blocks so
+   that as many pages and a large block can be allocated again. */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+#define BIG_PAGES 256
+
+/* Allocates kernel pages one at a time until the pool runs out.
+   Each page holds a pointer to the one allocated before it.
+   Returns the number of pages and stores the last in *LAST. */
+static size_t
+exhaust (void **last)
+{
+  void *prev = NULL, *page;
+  size_t cnt = 0;
+
+  while ((page = palloc_get_page (0)) != NULL)
+    {
+      *(void **) page = prev;
+      prev = page;
+      cnt++;
+    }
+  *last = prev;
+  return cnt;
+}
+
+/* Frees the chain of pages that exhaust() built, every other
+   page first and then the rest, so that neighbours go back in
+   no particular order. */
+static void
+release (void *last)
+{
+  void *page, *next, *odd = NULL;
+  bool skip = false;
+
+  for (page = last; page != NULL; page = next)
+    {
+      next = *(void **) page;
+      if (skip)
+        {
+          *(void **) page = odd;
+          odd = page;
+        }
+      else
+        palloc_free_page (page);
+      skip = !skip;
+    }
+  for (page = odd; page != NULL; page = next)
+    {
+      next = *(void **) page;
+      palloc_free_page (page);
+    }
+}
+
+void
+test_palloc_buddy (void)
+{
+  size_t cnt[2];
+  uint8_t *block;
+  void *last;
+  size_t i;
+  int pass;
+
+  block = palloc_get_multiple (PAL_ZERO, 5);
+  ASSERT (block != NULL);
+  for (i = 0; i < 5 * PGSIZE; i++)
+    if (block[i] != 0)
+      fail ("byte %zu of a 5-page block is not zero", i);
+  memset (block, 0x5a, 5 * PGSIZE);
+  palloc_free_multiple (block, 5);
+  msg ("A 5-page block was contiguous and zeroed.");
+
+  for (pass = 0; pass < 2; pass++)
+    {
+      cnt[pass] = exhaust (&last);
+      if (palloc_get_multiple (0, 2) != NULL)
+        fail ("got 2 pages from an empty pool");
+      release (last);
+    }
+  if (cnt[0] == 0 || cnt[0] != cnt[1])
+    fail ("first pass got %zu pages, second pass %zu", cnt[0], cnt[1]);
+  msg ("Second pass allocated as many pages as the first.");
+
+  block = palloc_get_multiple (0, BIG_PAGES);
+  if (block == NULL)
+    fail ("freed pages did not merge into a %d-page block", BIG_PAGES);
+  palloc_free_multiple (block, BIG_PAGES);
+  msg ("Freed pages merged into a %d-page block.", BIG_PAGES);
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(palloc-buddy) begin
+(palloc-buddy) A 5-page block was contiguous and zeroed.
+(palloc-buddy) Second pass allocated as many pages as the first.
+(palloc-buddy) Freed pages merged into a 256-page block.
+(palloc-buddy) end
+EOF
+pass;
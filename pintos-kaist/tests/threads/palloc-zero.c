@@ -0,0 +1,58 @@
+/* Checks that PAL_ZERO pages are zero whether they come from the
+   pool's list of pages the idle thread zeroed ahead of time or
+   are zeroed on demand: more pages than the list holds are taken,
+   dirtied and freed, and then taken again after sleeping long
+   enough for the idle thread to refill the list. */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+#include "devices/timer.h"
+
+#define PAGE_CNT 200
+
+static uint8_t *pages[PAGE_CNT];
+
+/* Takes PAGE_CNT zeroed pages, checks them and dirties them. */
+static void
+take_zeroed (void)
+{
+  size_t i, j;
+
+  for (i = 0; i < PAGE_CNT; i++)
+    {
+      pages[i] = palloc_get_page (PAL_ZERO);
+      if (pages[i] == NULL)
+        fail ("out of pages after %zu", i);
+      for (j = 0; j < PGSIZE; j++)
+        if (pages[i][j] != 0)
+          fail ("byte %zu of page %zu is not zero", j, i);
+      memset (pages[i], 0xa5, PGSIZE);
+    }
+}
+
+static void
+give_back (void)
+{
+  size_t i;
+
+  for (i = 0; i < PAGE_CNT; i++)
+    palloc_free_page (pages[i]);
+}
+
+void
+test_palloc_zero (void)
+{
+  int pass;
+
+  for (pass = 0; pass < 2; pass++)
+    {
+      timer_sleep (10);
+      take_zeroed ();
+      give_back ();
+      msg ("Pass %d: %d pages were zero.", pass + 1, PAGE_CNT);
+    }
+}
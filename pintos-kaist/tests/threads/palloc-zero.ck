@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(palloc-zero) begin
+(palloc-zero) Pass 1: 200 pages were zero.
+(palloc-zero) Pass 2: 200 pages were zero.
+(palloc-zero) end
+EOF
+pass;
@@ -80,6 +80,7 @@ test_priority_donate_chain (void)
   lock_release (&locks[0]);
   msg ("%s finishing with priority %d.", thread_name (),
                                          thread_get_priority ());
+  wait_children (2 * (NESTING_DEPTH - 1));
 }
 
 static void
@@ -103,12 +104,14 @@ donor_thread_func (void *locks_)
 
   msg ("%s finishing with priority %d.", thread_name (),
                                          thread_get_priority ());
+  child_done ();
 }
 
 static void
 interloper_thread_func (void *arg_ UNUSED)
 {
   msg ("%s finished.", thread_name ());
+  child_done ();
 }
 
 // vim: sw=2
@@ -37,6 +37,7 @@ test_priority_donate_lower (void)
   msg ("acquire must already have finished.");
   msg ("Main thread should have priority %d.  Actual priority: %d.",
        PRI_DEFAULT - 10, thread_get_priority ());
+  wait_children (1);
 }
 
 static void
@@ -48,4 +49,5 @@ acquire_thread_func (void *lock_)
   msg ("acquire: got the lock");
   lock_release (lock);
   msg ("acquire: done");
+  child_done ();
 }
@@ -52,6 +52,7 @@ test_priority_donate_multiple (void)
   msg ("Thread a should have just finished.");
   msg ("Main thread should have priority %d.  Actual priority: %d.",
        PRI_DEFAULT, thread_get_priority ());
+  wait_children (2);
 }
 
 static void
@@ -63,6 +64,7 @@ a_thread_func (void *lock_)
   msg ("Thread a acquired lock a.");
   lock_release (lock);
   msg ("Thread a finished.");
+  child_done ();
 }
 
 static void
@@ -74,4 +76,5 @@ b_thread_func (void *lock_)
   msg ("Thread b acquired lock b.");
   lock_release (lock);
   msg ("Thread b finished.");
+  child_done ();
 }
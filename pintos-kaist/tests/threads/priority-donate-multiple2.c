@@ -59,6 +59,7 @@ test_priority_donate_multiple2 (void)
   msg ("Threads b, a, c should have just finished, in that order.");
   msg ("Main thread should have priority %d.  Actual priority: %d.",
        PRI_DEFAULT, thread_get_priority ());
+  wait_children (3);
 }
 
 static void
@@ -70,6 +71,7 @@ a_thread_func (void *lock_)
   msg ("Thread a acquired lock a.");
   lock_release (lock);
   msg ("Thread a finished.");
+  child_done ();
 }
 
 static void
@@ -81,10 +83,12 @@ b_thread_func (void *lock_)
   msg ("Thread b acquired lock b.");
   lock_release (lock);
   msg ("Thread b finished.");
+  child_done ();
 }
 
 static void
 c_thread_func (void *a_ UNUSED) 
 {
   msg ("Thread c finished.");
+  child_done ();
 }
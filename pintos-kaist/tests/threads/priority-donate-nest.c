@@ -58,6 +58,7 @@ test_priority_donate_nest (void)
   msg ("Medium thread should just have finished.");
   msg ("Low thread should have priority %d.  Actual priority: %d.",
        PRI_DEFAULT, thread_get_priority ());
+  wait_children (2);
 }
 
 static void
@@ -80,6 +81,7 @@ medium_thread_func (void *locks_)
 
   msg ("High thread should have just finished.");
   msg ("Middle thread finished.");
+  child_done ();
 }
 
 static void
@@ -91,4 +93,5 @@ high_thread_func (void *lock_)
   msg ("High thread got the lock.");
   lock_release (lock);
   msg ("High thread finished.");
+  child_done ();
 }
@@ -40,6 +40,7 @@ test_priority_donate_one (void)
   lock_release (&lock);
   msg ("acquire2, acquire1 must already have finished, in that order.");
   msg ("This should be the last line before finishing this test.");
+  wait_children (2);
 }
 
 static void
@@ -51,6 +52,7 @@ acquire1_thread_func (void *lock_)
   msg ("acquire1: got the lock");
   lock_release (lock);
   msg ("acquire1: done");
+  child_done ();
 }
 
 static void
@@ -62,4 +64,5 @@ acquire2_thread_func (void *lock_)
   msg ("acquire2: got the lock");
   lock_release (lock);
   msg ("acquire2: done");
+  child_done ();
 }
@@ -44,6 +44,7 @@ test_priority_donate_sema (void)
   thread_create ("high", PRI_DEFAULT + 5, h_thread_func, &ls);
   sema_up (&ls.sema);
   msg ("Main thread finished.");
+  wait_children (3);
 }
 
 static void
@@ -57,6 +58,7 @@ l_thread_func (void *ls_)
   msg ("Thread L downed semaphore.");
   lock_release (&ls->lock);
   msg ("Thread L finished.");
+  child_done ();
 }
 
 static void
@@ -66,6 +68,7 @@ m_thread_func (void *ls_)
 
   sema_down (&ls->sema);
   msg ("Thread M finished.");
+  child_done ();
 }
 
 static void
@@ -79,4 +82,5 @@ h_thread_func (void *ls_)
   sema_up (&ls->sema);
   lock_release (&ls->lock);
   msg ("Thread H finished.");
+  child_done ();
 }
@@ -0,0 +1,116 @@
+/* Checks rwlocks: readers do not block each other, a writer that
+   is waiting for readers shuts out readers that arrive after it
+   and donates its priority to the reader it waits for, along with
+   the donations it receives itself, the try variants fail exactly
+   when they would have to wait, and a writer that releases with
+   another thread queued keeps readers out until that thread takes
+   over. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+static struct rwlock rw;
+static struct semaphore go;
+static struct semaphore done;
+static int readers_inside;
+
+/* Holds RW for reading until GO is upped. */
+static void
+holding_reader (void *aux UNUSED)
+{
+  rwlock_read_acquire (&rw);
+  readers_inside++;
+  sema_down (&go);
+  readers_inside--;
+  rwlock_read_release (&rw);
+  sema_up (&done);
+}
+
+static void
+reader (void *aux UNUSED)
+{
+  rwlock_read_acquire (&rw);
+  msg ("%s got the lock.", thread_name ());
+  rwlock_read_release (&rw);
+  sema_up (&done);
+}
+
+static void
+writer (void *aux UNUSED)
+{
+  rwlock_write_acquire (&rw);
+  msg ("%s got the lock.", thread_name ());
+  rwlock_write_release (&rw);
+  sema_up (&done);
+}
+
+void
+test_rwlock (void)
+{
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  rwlock_init (&rw);
+  sema_init (&go, 0);
+  sema_init (&done, 0);
+
+  /* Two higher-priority readers join us without blocking. */
+  rwlock_read_acquire (&rw);
+  thread_create ("reader 1", PRI_DEFAULT + 1, holding_reader, NULL);
+  thread_create ("reader 2", PRI_DEFAULT + 1, holding_reader, NULL);
+  if (readers_inside != 2)
+    fail ("only %d of 2 readers got in beside us", readers_inside);
+  if (rwlock_write_try_acquire (&rw))
+    fail ("rwlock_write_try_acquire succeeded with readers inside");
+  if (!rwlock_read_try_acquire (&rw))
+    fail ("rwlock_read_try_acquire failed with only readers inside");
+  rwlock_read_release (&rw);
+  rwlock_read_release (&rw);
+  sema_up (&go);
+  sema_up (&go);
+  sema_down (&done);
+  sema_down (&done);
+  msg ("Readers shared the lock.");
+
+  /* A writer waits for us to leave and donates to us.  A reader
+     that comes after it, even at higher priority, waits for the
+     writer, and its donation reaches us through the writer. */
+  rwlock_read_acquire (&rw);
+  thread_create ("writer 1", PRI_DEFAULT + 1, writer, NULL);
+  if (rwlock_read_try_acquire (&rw))
+    fail ("rwlock_read_try_acquire got ahead of a waiting writer");
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 1, thread_get_priority ());
+  thread_create ("late reader", PRI_DEFAULT + 2, reader, NULL);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 2, thread_get_priority ());
+  msg ("Releasing the read lock.");
+  rwlock_read_release (&rw);
+  sema_down (&done);
+  sema_down (&done);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT, thread_get_priority ());
+
+  /* A lower-priority writer queues while we hold the lock.  When
+     we release, it still has to be scheduled to take over, and
+     until then a new reader must not get in. */
+  rwlock_write_acquire (&rw);
+  thread_create ("writer 2", PRI_DEFAULT - 1, writer, NULL);
+  timer_sleep (5);
+  rwlock_write_release (&rw);
+  if (rwlock_read_try_acquire (&rw))
+    fail ("a reader got in ahead of the queued writer");
+  msg ("Readers stay out until the next writer takes over.");
+  sema_down (&done);
+
+  if (!rwlock_read_try_acquire (&rw))
+    fail ("rwlock_read_try_acquire failed on a free lock");
+  rwlock_read_release (&rw);
+  if (!rwlock_write_try_acquire (&rw))
+    fail ("rwlock_write_try_acquire failed on a free lock");
+  rwlock_write_release (&rw);
+}
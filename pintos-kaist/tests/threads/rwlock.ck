@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock) begin
+(rwlock) Readers shared the lock.
+(rwlock) This thread should have priority 32.  Actual priority: 32.
+(rwlock) This thread should have priority 33.  Actual priority: 33.
+(rwlock) Releasing the read lock.
+(rwlock) writer 1 got the lock.
+(rwlock) late reader got the lock.
+(rwlock) This thread should have priority 31.  Actual priority: 31.
+(rwlock) Readers stay out until the next writer takes over.
+(rwlock) writer 2 got the lock.
+(rwlock) end
+EOF
+pass;
@@ -0,0 +1,48 @@
+/* Checks admission control for the EDF scheduling class, and
+   that an EDF thread is not preempted by a thread of the highest
+   static priority.
+
+   Each EDF thread is bound to one CPU, so a thread asking for all
+   of a CPU is rejected however many CPUs there are. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+
+static thread_func high_thread;
+
+void
+test_sched_deadline (void)
+{
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  if (thread_set_deadline (0, 10, 10)
+      || thread_set_deadline (20, 10, 50)
+      || thread_set_deadline (20, 60, 50))
+    fail ("invalid EDF parameters were admitted");
+  msg ("Invalid parameters rejected.");
+
+  if (!thread_set_deadline (20, 50, 50))
+    fail ("40%% EDF bandwidth was rejected");
+  msg ("Admitted runtime 20, deadline 50, period 50.");
+
+  thread_create ("high", PRI_MAX, high_thread, NULL);
+  msg ("Created priority %d thread.", PRI_MAX);
+
+  if (thread_set_deadline (50, 50, 50))
+    fail ("100%% EDF bandwidth was admitted");
+  if (thread_get_policy () != SCHED_DEADLINE)
+    fail ("rejected request changed the policy");
+  msg ("Over-utilization rejected.");
+
+  thread_set_policy (SCHED_PRIO);
+  msg ("Back to priority scheduling.");
+}
+
+static void
+high_thread (void *aux UNUSED)
+{
+  msg ("Priority %d thread ran.", PRI_MAX);
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(sched-deadline) begin
+(sched-deadline) Invalid parameters rejected.
+(sched-deadline) Admitted runtime 20, deadline 50, period 50.
+(sched-deadline) Created priority 63 thread.
+(sched-deadline) Over-utilization rejected.
+(sched-deadline) Priority 63 thread ran.
+(sched-deadline) Back to priority scheduling.
+(sched-deadline) end
+EOF
+pass;
@@ -0,0 +1,83 @@
+/* Checks that the fair scheduling class divides the CPU by nice
+   weight.  Two threads switch to the fair class, one with nice 0
+   and the other with nice 5, and spin for 10 seconds while the
+   main thread sleeps.  By weight they should receive about 75%
+   and 25% of the ticks, respectively; the test passes if the
+   first thread gets more than twice as many as the second and
+   neither starves. */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 2
+
+struct thread_info
+  {
+    int64_t start_time;
+    int tick_count;
+    int nice;
+  };
+
+static thread_func load_thread;
+
+void
+test_sched_fair (void)
+{
+  struct thread_info info[THREAD_CNT];
+  int64_t start_time;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  start_time = timer_ticks ();
+  msg ("Starting %d fair threads...", THREAD_CNT);
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      struct thread_info *ti = &info[i];
+      char name[16];
+
+      ti->start_time = start_time;
+      ti->tick_count = 0;
+      ti->nice = i * 5;
+
+      snprintf (name, sizeof name, "fair %d", i);
+      thread_create (name, PRI_DEFAULT, load_thread, ti);
+    }
+
+  msg ("Sleeping 12 seconds to let threads run, please wait...");
+  timer_sleep (12 * TIMER_FREQ);
+
+  for (i = 0; i < THREAD_CNT; i++)
+    msg ("Thread %d with nice %d received %d ticks.",
+         i, info[i].nice, info[i].tick_count);
+  if (info[1].tick_count == 0)
+    fail ("nice %d thread starved", info[1].nice);
+  if (info[0].tick_count <= 2 * info[1].tick_count)
+    fail ("nice %d thread did not get its share", info[0].nice);
+  pass ();
+}
+
+static void
+load_thread (void *ti_)
+{
+  struct thread_info *ti = ti_;
+  int64_t sleep_time = 1 * TIMER_FREQ;
+  int64_t spin_time = sleep_time + 10 * TIMER_FREQ;
+  int64_t last_time = 0;
+
+  thread_set_policy (SCHED_FAIR);
+  thread_set_nice (ti->nice);
+  timer_sleep (sleep_time - timer_elapsed (ti->start_time));
+  while (timer_elapsed (ti->start_time) < spin_time)
+    {
+      int64_t cur_time = timer_ticks ();
+      if (cur_time != last_time)
+        ti->tick_count++;
+      last_time = cur_time;
+    }
+}
@@ -0,0 +1,92 @@
+/* Checks object caches: objects from one cache never overlap,
+   the constructor runs once per object rather than once per
+   allocation, a freed object comes back from the magazine of the
+   CPU that freed it, and shrinking gives the slabs back. */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/slab.h"
+
+#define OBJ_CNT 500
+
+struct obj
+  {
+    int id;
+    char pad[52];
+  };
+
+static struct kmem_cache plain_cache, ctor_cache;
+static struct obj *objs[OBJ_CNT];
+static int ctor_cnt;
+
+static void
+obj_ctor (void *obj_)
+{
+  struct obj *obj = obj_;
+
+  obj->id = -1;
+  ctor_cnt++;
+}
+
+void
+test_slab (void)
+{
+  struct obj *obj;
+  int i, j;
+
+  kmem_cache_init (&plain_cache, "test plain", sizeof (struct obj), NULL,
+                   KMEM_MAGAZINE);
+  kmem_cache_init (&ctor_cache, "test ctor", sizeof (struct obj), obj_ctor, 0);
+
+  for (i = 0; i < OBJ_CNT; i++)
+    {
+      objs[i] = kmem_cache_alloc (&plain_cache);
+      if (objs[i] == NULL)
+        fail ("out of memory after %d objects", i);
+      objs[i]->id = i;
+      memset (objs[i]->pad, i, sizeof objs[i]->pad);
+    }
+  for (i = 0; i < OBJ_CNT; i++)
+    for (j = 0; j < (int) sizeof objs[i]->pad; j++)
+      if (objs[i]->id != i || objs[i]->pad[j] != (char) i)
+        fail ("object %d was overwritten", i);
+  for (i = 0; i < OBJ_CNT; i += 2)
+    kmem_cache_free (&plain_cache, objs[i]);
+  for (i = 1; i < OBJ_CNT; i += 2)
+    kmem_cache_free (&plain_cache, objs[i]);
+  msg ("%d objects did not overlap.", OBJ_CNT);
+
+  obj = kmem_cache_alloc (&plain_cache);
+  if (obj != objs[OBJ_CNT - 1])
+    fail ("last freed object did not come back first");
+  kmem_cache_free (&plain_cache, obj);
+  msg ("The magazine gave back the last freed object.");
+
+  for (i = 0; i < OBJ_CNT; i++)
+    {
+      objs[i] = kmem_cache_alloc (&ctor_cache);
+      if (objs[i]->id != -1)
+        fail ("object %d was not constructed", i);
+    }
+  for (i = 0; i < OBJ_CNT; i += 3)
+    {
+      kmem_cache_free (&ctor_cache, objs[i]);
+      objs[i] = kmem_cache_alloc (&ctor_cache);
+      if (objs[i]->id != -1)
+        fail ("object %d came back unconstructed", i);
+    }
+  for (i = 0; i < OBJ_CNT; i++)
+    kmem_cache_free (&ctor_cache, objs[i]);
+  if (ctor_cnt != OBJ_CNT)
+    fail ("constructor ran %d times for %d objects", ctor_cnt, OBJ_CNT);
+  msg ("The constructor ran once per object.");
+
+  kmem_cache_shrink (&plain_cache);
+  kmem_cache_shrink (&ctor_cache);
+  if (!list_empty (&plain_cache.partial) || !list_empty (&plain_cache.full)
+      || !list_empty (&plain_cache.empty) || !list_empty (&ctor_cache.empty))
+    fail ("shrinking left slabs behind");
+  msg ("Shrinking gave back every slab.");
+}
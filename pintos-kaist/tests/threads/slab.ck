@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(slab) begin
+(slab) 500 objects did not overlap.
+(slab) The magazine gave back the last freed object.
+(slab) The constructor ran once per object.
+(slab) Shrinking gave back every slab.
+(slab) end
+EOF
+pass;
@@ -0,0 +1,44 @@
+# -*- perl -*-
+use strict;
+use warnings;
+
+# Checks the output of a test that was written for one CPU but ran
+# on several.  Threads that would have waited for a higher-priority
+# thread on one CPU may run at the same time on another, so the
+# lines can come out in a different order and a priority printed
+# mid-test may not have caught up with a donation yet.  What must
+# still hold is that the test starts and ends, nothing panics, and
+# every expected line shows up exactly once.
+sub check_smp_expected {
+    my ($expected) = @_;
+    our ($test);
+
+    my (@output) = read_text_file ("$test.output");
+    common_checks ("run", @output);
+    @output = get_core_output ("run", @output);
+
+    my (@expected) = split ("\n", $expected);
+    fail "First line should be \"$expected[0]\".\n"
+      if !@output || $output[0] ne $expected[0];
+    fail "Last line should be \"$expected[$#expected]\".\n"
+      if $output[$#output] ne $expected[$#expected];
+
+    my (%count);
+    $count{smp_normalize ($_)}++ foreach @expected;
+    $count{smp_normalize ($_)}-- foreach @output;
+    foreach my $line (sort keys %count) {
+	fail "Missing line: $line\n" if $count{$line} > 0;
+	fail "Unexpected line: $line\n" if $count{$line} < 0;
+    }
+    pass;
+}
+
+# Masks the priorities that depend on how far the other CPUs have
+# got when the line is printed.
+sub smp_normalize {
+    my ($line) = @_;
+    $line =~ s/(Actual priority:|with priority) \d+/$1 N/;
+    return $line;
+}
+
+1;
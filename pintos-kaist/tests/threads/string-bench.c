@@ -0,0 +1,64 @@
+/* Measures the throughput of memcpy() and memset() on whole
+   pages, the way palloc, the page fault handler and the file
+   system bounce buffers use them, and of memcmp() and strlen()
+   on a page as well.
+
+   The cycle counts are informational; the test passes as long
+   as the results are right. */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
+
+#define ROUND_CNT 1000
+
+/* Prints the cycles per byte that CYCLES over ROUND_CNT pages
+   come to, in hundredths. */
+static void
+report (const char *name, uint64_t cycles)
+{
+  uint64_t centi = cycles * 100 / ((uint64_t) ROUND_CNT * PGSIZE);
+
+  msg ("%s: %llu.%02llu cycles per byte.", name,
+       (unsigned long long) (centi / 100), (unsigned long long) (centi % 100));
+}
+
+void
+test_string_bench (void) 
+{
+  char *a = palloc_get_page (PAL_ASSERT);
+  char *b = palloc_get_page (PAL_ASSERT);
+  uint64_t start;
+  int i;
+
+  start = rdtsc ();
+  for (i = 0; i < ROUND_CNT; i++)
+    memset (a, i, PGSIZE);
+  report ("memset", rdtsc () - start);
+
+  start = rdtsc ();
+  for (i = 0; i < ROUND_CNT; i++)
+    memcpy (b, a, PGSIZE);
+  report ("memcpy", rdtsc () - start);
+
+  start = rdtsc ();
+  for (i = 0; i < ROUND_CNT; i++)
+    if (memcmp (a, b, PGSIZE) != 0)
+      fail ("memcmp found a difference in equal pages");
+  report ("memcmp", rdtsc () - start);
+
+  memset (a, 'x', PGSIZE - 1);
+  a[PGSIZE - 1] = '\0';
+  start = rdtsc ();
+  for (i = 0; i < ROUND_CNT; i++)
+    if (strlen (a) != PGSIZE - 1)
+      fail ("strlen got the wrong length");
+  report ("strlen", rdtsc () - start);
+
+  palloc_free_page (a);
+  palloc_free_page (b);
+  pass ();
+}
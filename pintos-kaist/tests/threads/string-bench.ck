@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+foreach my $func (qw (memset memcpy memcmp strlen)) {
+    fail "string-bench did not report $func throughput\n"
+      if !grep (/^\(string-bench\) $func: \d+\.\d\d cycles per byte\.$/,
+		@output);
+}
+fail "string-bench did not pass\n"
+  if !grep ($_ eq '(string-bench) PASS', @output);
+pass;
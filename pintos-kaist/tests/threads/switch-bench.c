@@ -0,0 +1,57 @@
+/* Measures the cost of a kernel thread switch by making control
+   "ping-pong" between two threads of equal priority, the same
+   way sema_self_test() does.  Each round trip is two switches.
+
+   The cycle count is informational; the test passes as long as
+   the threads finish their rounds. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "intrinsic.h"
+
+#define ROUND_CNT 10000
+
+static thread_func pong_thread;
+
+void
+test_switch_bench (void) 
+{
+  struct semaphore sema[2];
+  uint64_t start, cycles;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&sema[0], 0);
+  sema_init (&sema[1], 0);
+  thread_create ("pong", thread_get_priority (), pong_thread, &sema);
+
+  start = rdtsc ();
+  for (i = 0; i < ROUND_CNT; i++) 
+    {
+      sema_up (&sema[0]);
+      sema_down (&sema[1]);
+    }
+  cycles = rdtsc () - start;
+
+  msg ("%d round trips, %llu cycles per switch.",
+       ROUND_CNT, (unsigned long long) (cycles / (2 * ROUND_CNT)));
+  pass ();
+}
+
+/* Thread function used by test_switch_bench(). */
+static void
+pong_thread (void *sema_) 
+{
+  struct semaphore *sema = sema_;
+  int i;
+
+  for (i = 0; i < ROUND_CNT; i++) 
+    {
+      sema_down (&sema[0]);
+      sema_up (&sema[1]);
+    }
+}
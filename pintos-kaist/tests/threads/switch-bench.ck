@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+fail "switch-bench did not report cycles per switch\n"
+  if !grep (/^\(switch-bench\) \d+ round trips, \d+ cycles per switch\.$/,
+	    @output);
+fail "switch-bench did not pass\n"
+  if !grep ($_ eq '(switch-bench) PASS', @output);
+pass;
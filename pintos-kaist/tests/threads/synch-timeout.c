@@ -0,0 +1,95 @@
+/* Checks the timeout variants of the synchronization primitives:
+   each one gives up no earlier than its timeout when nothing
+   wakes it, returns as soon as it is woken otherwise, and a
+   lock_acquire_timeout() that gives up takes its priority
+   donation back. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+static struct semaphore sema;
+static struct lock lock;
+static struct condition cond;
+static bool lock_result;
+
+static void
+sema_upper (void *aux UNUSED)
+{
+  timer_sleep (3);
+  sema_up (&sema);
+}
+
+static void
+lock_waiter (void *aux UNUSED)
+{
+  lock_result = lock_acquire_timeout (&lock, 10);
+  if (lock_result)
+    lock_release (&lock);
+}
+
+static void
+cond_signaler (void *aux UNUSED)
+{
+  timer_sleep (3);
+  lock_acquire (&lock);
+  cond_signal (&cond, &lock);
+  lock_release (&lock);
+}
+
+void
+test_synch_timeout (void)
+{
+  int64_t start, elapsed;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&sema, 0);
+  lock_init (&lock);
+  cond_init (&cond);
+
+  start = timer_ticks ();
+  if (sema_down_timeout (&sema, 5))
+    fail ("sema_down_timeout succeeded on a zero semaphore");
+  elapsed = timer_elapsed (start);
+  if (elapsed < 5)
+    fail ("sema_down_timeout gave up after %lld of 5 ticks", elapsed);
+  thread_create ("sema-upper", PRI_DEFAULT, sema_upper, NULL);
+  start = timer_ticks ();
+  if (!sema_down_timeout (&sema, 100))
+    fail ("sema_down_timeout missed sema_up");
+  if (timer_elapsed (start) >= 100)
+    fail ("sema_down_timeout waited for its whole timeout");
+  msg ("sema_down_timeout timed out and was woken.");
+
+  lock_acquire (&lock);
+  thread_create ("lock-waiter", PRI_DEFAULT + 5, lock_waiter, NULL);
+  if (thread_get_priority () != PRI_DEFAULT + 5)
+    fail ("waiter did not donate: priority %d", thread_get_priority ());
+  timer_sleep (20);
+  if (lock_result)
+    fail ("lock_acquire_timeout acquired a held lock");
+  if (thread_get_priority () != PRI_DEFAULT)
+    fail ("donation outlived the timeout: priority %d",
+          thread_get_priority ());
+  lock_release (&lock);
+  msg ("lock_acquire_timeout timed out and took its donation back.");
+
+  lock_acquire (&lock);
+  start = timer_ticks ();
+  if (cond_wait_timeout (&cond, &lock, 5))
+    fail ("cond_wait_timeout returned without a signal");
+  if (timer_elapsed (start) < 5)
+    fail ("cond_wait_timeout gave up early");
+  if (!lock_held_by_current_thread (&lock))
+    fail ("cond_wait_timeout did not reacquire the lock");
+  thread_create ("cond-signaler", PRI_DEFAULT, cond_signaler, NULL);
+  if (!cond_wait_timeout (&cond, &lock, 100))
+    fail ("cond_wait_timeout missed cond_signal");
+  lock_release (&lock);
+  msg ("cond_wait_timeout timed out and was signaled.");
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(synch-timeout) begin
+(synch-timeout) sema_down_timeout timed out and was woken.
+(synch-timeout) lock_acquire_timeout timed out and took its donation back.
+(synch-timeout) cond_wait_timeout timed out and was signaled.
+(synch-timeout) end
+EOF
+pass;
@@ -2,6 +2,7 @@
 #include <debug.h>
 #include <string.h>
 #include <stdio.h>
+#include "threads/synch.h"
 
 struct test 
   {
@@ -29,6 +30,23 @@ static const struct test tests[] =
     {"priority-preempt", test_priority_preempt},
     {"priority-sema", test_priority_sema},
     {"priority-condvar", test_priority_condvar},
+    {"switch-bench", test_switch_bench},
+    {"sched-fair", test_sched_fair},
+    {"sched-deadline", test_sched_deadline},
+    {"thread-stats", test_thread_stats},
+    {"alarm-slack", test_alarm_slack},
+    {"alarm-usleep", test_alarm_usleep},
+    {"workqueue", test_workqueue},
+    {"synch-timeout", test_synch_timeout},
+    {"waitq", test_waitq},
+    {"palloc-buddy", test_palloc_buddy},
+    {"palloc-zero", test_palloc_zero},
+    {"slab", test_slab},
+    {"vmalloc", test_vmalloc},
+    {"string-bench", test_string_bench},
+    {"rwlock", test_rwlock},
+    {"alarm-tickless", test_alarm_tickless},
+    {"create-bench", test_create_bench},
     {"mlfqs-load-1", test_mlfqs_load_1},
     {"mlfqs-load-60", test_mlfqs_load_60},
     {"mlfqs-load-avg", test_mlfqs_load_avg},
@@ -42,6 +60,9 @@ static const struct test tests[] =
 
 static const char *test_name;
 
+/* Ups once for each call to child_done(). */
+static struct semaphore children_done;
+
 /* Runs the test named NAME. */
 void
 run_test (const char *name) 
@@ -52,6 +73,7 @@ run_test (const char *name)
     if (!strcmp (name, t->name))
       {
         test_name = name;
+        sema_init (&children_done, 0);
         msg ("begin");
         t->function ();
         msg ("end");
@@ -100,3 +122,22 @@ pass (void)
   printf ("(%s) PASS\n", test_name);
 }
 
+/* Called by a thread that a test created, as the last thing it
+   does. */
+void
+child_done (void) 
+{
+  sema_up (&children_done);
+}
+
+/* Waits until CNT threads created by the current test have called
+   child_done().  On a single CPU the test's higher-priority
+   threads have usually finished by then, so this returns at once.
+   With several CPUs they may still be running elsewhere, and the
+   test must not return while they use its stack. */
+void
+wait_children (int cnt) 
+{
+  while (cnt-- > 0)
+    sema_down (&children_done);
+}
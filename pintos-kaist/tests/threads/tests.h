@@ -23,6 +23,23 @@ extern test_func test_priority_fifo;
 extern test_func test_priority_preempt;
 extern test_func test_priority_sema;
 extern test_func test_priority_condvar;
+extern test_func test_switch_bench;
+extern test_func test_sched_fair;
+extern test_func test_sched_deadline;
+extern test_func test_thread_stats;
+extern test_func test_alarm_slack;
+extern test_func test_alarm_usleep;
+extern test_func test_workqueue;
+extern test_func test_synch_timeout;
+extern test_func test_waitq;
+extern test_func test_palloc_buddy;
+extern test_func test_palloc_zero;
+extern test_func test_slab;
+extern test_func test_vmalloc;
+extern test_func test_string_bench;
+extern test_func test_rwlock;
+extern test_func test_alarm_tickless;
+extern test_func test_create_bench;
 extern test_func test_mlfqs_load_1;
 extern test_func test_mlfqs_load_60;
 extern test_func test_mlfqs_load_avg;
@@ -36,6 +53,8 @@ extern test_func test_mlfqs_block;
 void msg (const char *, ...);
 void fail (const char *, ...);
 void pass (void);
+void child_done (void);
+void wait_children (int cnt);
 
 #endif /* tests/threads/tests.h */
 
@@ -0,0 +1,71 @@
+/* Checks per-thread accounting.  The main thread holds a lock
+   while a higher-priority thread tries to acquire it, so the
+   waiter must block, be counted as a voluntary switch, and have
+   its wait charged to its lock-wait time and to the lock-wait
+   histogram. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func waiter_thread;
+
+static uint64_t
+hist_total (enum thread_hist which)
+{
+  uint64_t counts[THREAD_HIST_BUCKETS];
+  uint64_t total = 0;
+  int i;
+
+  thread_get_hist (which, counts);
+  for (i = 0; i < THREAD_HIST_BUCKETS; i++)
+    total += counts[i];
+  return total;
+}
+
+void
+test_thread_stats (void)
+{
+  struct thread_stats stats;
+  struct lock lock;
+  uint64_t lock_waits;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  thread_get_stats (&stats);
+  if (stats.kernel_cycles == 0)
+    fail ("main thread was charged no kernel time");
+
+  lock_init (&lock);
+  lock_acquire (&lock);
+  lock_waits = hist_total (THREAD_HIST_LOCK);
+  thread_create ("waiter", PRI_DEFAULT + 1, waiter_thread, &lock);
+  msg ("Waiter is blocked on the lock.");
+  lock_release (&lock);
+
+  if (hist_total (THREAD_HIST_LOCK) <= lock_waits)
+    fail ("lock wait was not counted in the histogram");
+  if (hist_total (THREAD_HIST_READY) == 0)
+    fail ("run-queue latency histogram is empty");
+  msg ("Histograms updated.");
+}
+
+static void
+waiter_thread (void *lock_)
+{
+  struct lock *lock = lock_;
+  struct thread_stats stats;
+
+  lock_acquire (lock);
+  thread_get_stats (&stats);
+  lock_release (lock);
+
+  if (stats.lock_cycles == 0)
+    fail ("lock wait was not charged");
+  if (stats.voluntary_switches == 0)
+    fail ("blocking was not counted as a voluntary switch");
+  msg ("Waiter was charged for its lock wait.");
+}
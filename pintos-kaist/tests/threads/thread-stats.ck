@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(thread-stats) begin
+(thread-stats) Waiter is blocked on the lock.
+(thread-stats) Waiter was charged for its lock wait.
+(thread-stats) Histograms updated.
+(thread-stats) end
+EOF
+pass;
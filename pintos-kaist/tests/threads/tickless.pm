@@ -0,0 +1,25 @@
+# -*- perl -*-
+use strict;
+use warnings;
+
+# Checks that every timer tick of the run was charged to exactly
+# one of idle, kernel, or user time, including the ticks that went
+# by with the periodic tick stopped in tickless idle.  A tick may
+# pass between the two lines that report the counts.
+sub check_tick_accounting {
+    our ($test);
+
+    my (@output) = read_text_file ("$test.output");
+    my ($ticks) = map (/^Timer: (\d+) ticks$/, @output);
+    my ($idle, $kernel, $user)
+      = map (/^Thread: (\d+) idle ticks, (\d+) kernel ticks, (\d+) user ticks$/,
+	     @output);
+    fail "missing \"Timer: # ticks\" line\n" if !defined $ticks;
+    fail "missing \"Thread: # idle ticks\" line\n" if !defined $user;
+
+    my ($charged) = $idle + $kernel + $user;
+    fail "$charged ticks charged but $ticks ticks went by\n"
+      if $charged < $ticks || $charged > $ticks + 1;
+}
+
+1;
@@ -0,0 +1,6 @@
+# -*- perl -*-
+use tests::tests;
+use tests::threads::alarm;
+use tests::threads::tickless;
+check_tick_accounting ();
+check_alarm (7);
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::threads::tickless;
+check_tick_accounting ();
+check_expected ([<<'EOF']);
+(alarm-tickless) begin
+(alarm-tickless) Slept 1 ticks.
+(alarm-tickless) Slept 3 ticks.
+(alarm-tickless) Slept 7 ticks.
+(alarm-tickless) Slept 30 ticks.
+(alarm-tickless) Slept 150 ticks.
+(alarm-tickless) end
+EOF
+pass;
@@ -0,0 +1,81 @@
+/* Checks that vmalloc() and large malloc() requests succeed when
+   the kernel pool is so fragmented that no two free pages are
+   physically contiguous, and that vfree() gives the pages back. */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+#include "threads/vmalloc.h"
+
+#define VM_PAGES 32
+#define BIG_SIZE (64 * 1024)
+
+/* Fills BUF with a pattern that depends on SEED and checks it. */
+static void
+fill_and_check (uint8_t *buf, size_t size, int seed)
+{
+  size_t i;
+
+  for (i = 0; i < size; i++)
+    buf[i] = i * 7 + seed;
+  for (i = 0; i < size; i++)
+    if (buf[i] != (uint8_t) (i * 7 + seed))
+      fail ("byte %zu of a %zu-byte buffer changed", i, size);
+}
+
+void
+test_vmalloc (void)
+{
+  void *held = NULL, *odd = NULL, *page, *next;
+  uint8_t *buf;
+
+  /* Take the whole kernel pool and give back every page at an
+     odd page number, so that no two free pages are adjacent. */
+  while ((page = palloc_get_page (0)) != NULL)
+    {
+      void **chain = pg_no (page) % 2 ? &odd : &held;
+
+      *(void **) page = *chain;
+      *chain = page;
+    }
+  if (held == NULL || odd == NULL)
+    fail ("could not take any pages");
+  for (page = odd; page != NULL; page = next)
+    {
+      next = *(void **) page;
+      palloc_free_page (page);
+    }
+  if (palloc_get_multiple (0, 2) != NULL)
+    fail ("got 2 contiguous pages from a fragmented pool");
+  msg ("No two free pages are contiguous.");
+
+  buf = vmalloc (VM_PAGES * PGSIZE);
+  if (buf == NULL)
+    fail ("vmalloc of %d pages failed", VM_PAGES);
+  fill_and_check (buf, VM_PAGES * PGSIZE, 1);
+  vfree (buf);
+  msg ("vmalloc() mapped %d scattered pages.", VM_PAGES);
+
+  buf = malloc (BIG_SIZE);
+  if (buf == NULL)
+    fail ("malloc of %d bytes failed", BIG_SIZE);
+  fill_and_check (buf, BIG_SIZE, 2);
+  free (buf);
+  msg ("malloc() of %d bytes succeeded.", BIG_SIZE);
+
+  buf = vmalloc (VM_PAGES * PGSIZE);
+  if (buf == NULL)
+    fail ("vfree() did not give the pages back");
+  vfree (buf);
+
+  for (page = held; page != NULL; page = next)
+    {
+      next = *(void **) page;
+      palloc_free_page (page);
+    }
+  msg ("vfree() gave the pages back.");
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(vmalloc) begin
+(vmalloc) No two free pages are contiguous.
+(vmalloc) vmalloc() mapped 32 scattered pages.
+(vmalloc) malloc() of 65536 bytes succeeded.
+(vmalloc) vfree() gave the pages back.
+(vmalloc) end
+EOF
+pass;
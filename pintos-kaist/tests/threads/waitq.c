@@ -0,0 +1,92 @@
+/* Checks wait queues: a wakeup for N exclusive waiters wakes
+   every shared waiter but only the N highest priority exclusive
+   waiters, and a later wakeup for all of them wakes the rest. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define WAITER_CNT 3
+
+static struct waitq wq;
+static int woken_shared, woken_exclusive;
+static int woken_order[WAITER_CNT];
+
+static void
+waiter (void *aux)
+{
+  bool exclusive = aux != NULL;
+  enum intr_level old_level;
+
+  old_level = intr_disable ();
+  spinlock_acquire (&wq.lock);
+  waitq_add (&wq, exclusive);
+  waitq_block (&wq, 0);
+  spinlock_release (&wq.lock);
+  intr_set_level (old_level);
+
+  if (exclusive)
+    woken_order[woken_exclusive++] = thread_get_priority ();
+  else
+    woken_shared++;
+}
+
+static size_t
+wake (size_t nr_exclusive)
+{
+  enum intr_level old_level;
+  struct list woken;
+  size_t cnt;
+
+  list_init (&woken);
+  old_level = intr_disable ();
+  spinlock_acquire (&wq.lock);
+  cnt = waitq_wake (&wq, nr_exclusive, &woken);
+  spinlock_release (&wq.lock);
+  thread_unblock_list (&woken);
+  intr_set_level (old_level);
+  thread_preemption ();
+  return cnt;
+}
+
+void
+test_waitq (void)
+{
+  size_t cnt;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  waitq_init (&wq);
+  for (i = 0; i < WAITER_CNT; i++)
+    {
+      char name[16];
+
+      snprintf (name, sizeof name, "shared %d", i);
+      thread_create (name, PRI_DEFAULT + 1, waiter, NULL);
+      snprintf (name, sizeof name, "exclusive %d", i);
+      thread_create (name, PRI_DEFAULT + 1 + i, waiter, &wq);
+    }
+
+  cnt = wake (1);
+  if (cnt != WAITER_CNT + 1)
+    fail ("waitq_wake (1) woke %zu threads", cnt);
+  if (woken_shared != WAITER_CNT || woken_exclusive != 1)
+    fail ("%d shared and %d exclusive waiters ran",
+          woken_shared, woken_exclusive);
+  if (woken_order[0] != PRI_DEFAULT + WAITER_CNT)
+    fail ("exclusive waiter of priority %d woke first", woken_order[0]);
+  msg ("One wakeup woke all shared waiters and one exclusive waiter.");
+
+  cnt = wake (WAITQ_ALL);
+  if (cnt != WAITER_CNT - 1 || woken_exclusive != WAITER_CNT)
+    fail ("waitq_wake (WAITQ_ALL) woke %zu threads", cnt);
+  for (i = 1; i < WAITER_CNT; i++)
+    if (woken_order[i] > woken_order[i - 1])
+      fail ("exclusive waiters woke out of priority order");
+  msg ("A wakeup for all woke the rest in priority order.");
+}
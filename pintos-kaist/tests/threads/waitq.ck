@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(waitq) begin
+(waitq) One wakeup woke all shared waiters and one exclusive waiter.
+(waitq) A wakeup for all woke the rest in priority order.
+(waitq) end
+EOF
+pass;
@@ -0,0 +1,89 @@
+/* Checks work queues: queued work runs on a worker thread and
+   workqueue_flush() waits for it, a work item already queued is
+   not queued again, delayed work runs no earlier than asked, and
+   cancelled work does not run. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+#include "threads/workqueue.h"
+#include "devices/timer.h"
+
+#define WORK_CNT 8
+
+static int ran[WORK_CNT];
+static tid_t ran_on[WORK_CNT];
+static int64_t delayed_ran_at;
+static int cancelled_ran;
+
+static void
+count_work (void *aux)
+{
+  int i = (int) (intptr_t) aux;
+
+  ran[i]++;
+  ran_on[i] = thread_tid ();
+}
+
+static void
+delayed_work (void *aux UNUSED)
+{
+  delayed_ran_at = timer_ticks ();
+}
+
+static void
+cancelled_work (void *aux UNUSED)
+{
+  cancelled_ran++;
+}
+
+void
+test_workqueue (void)
+{
+  struct workqueue *wq;
+  struct work works[WORK_CNT];
+  struct work delayed, cancelled;
+  int64_t start;
+  int i;
+
+  wq = workqueue_create ("test", PRI_DEFAULT, 2);
+  if (wq == NULL)
+    fail ("workqueue_create failed");
+
+  for (i = 0; i < WORK_CNT; i++)
+    {
+      work_init (&works[i], count_work, (void *) (intptr_t) i);
+      if (!work_queue (wq, &works[i]))
+        fail ("idle work %d was not queued", i);
+    }
+  workqueue_flush (wq);
+  for (i = 0; i < WORK_CNT; i++)
+    {
+      if (ran[i] == 0)
+        fail ("work %d did not run", i);
+      if (ran_on[i] == thread_tid ())
+        fail ("work %d ran on the caller's thread", i);
+    }
+  msg ("Queued work ran on worker threads.");
+
+  work_init (&delayed, delayed_work, NULL);
+  work_init (&cancelled, cancelled_work, NULL);
+  start = timer_ticks ();
+  work_queue_delayed (wq, &delayed, 10);
+  if (work_queue (wq, &delayed))
+    fail ("pending work was queued twice");
+  work_queue_delayed (wq, &cancelled, 5);
+  if (!work_cancel (&cancelled))
+    fail ("delayed work could not be cancelled");
+  timer_sleep (20);
+  workqueue_flush (wq);
+  if (delayed_ran_at == 0)
+    fail ("delayed work did not run");
+  if (delayed_ran_at < start + 10)
+    fail ("delayed work ran %lld ticks early",
+          start + 10 - delayed_ran_at);
+  if (cancelled_ran)
+    fail ("cancelled work ran");
+  msg ("Delayed work ran on time; cancelled work did not run.");
+}
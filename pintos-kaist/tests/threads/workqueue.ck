@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(workqueue) begin
+(workqueue) Queued work ran on worker threads.
+(workqueue) Delayed work ran on time; cancelled work did not run.
+(workqueue) end
+EOF
+pass;
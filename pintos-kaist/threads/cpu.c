@@ -0,0 +1,188 @@
+#include "threads/cpu.h"
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/lapic.h"
+#include "devices/timer.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/loader.h"
+#include "threads/sched.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
+
+/* CPU마다 하나씩 있는 상태.  cpus[0]이 BSP(부팅한 CPU)입니다. */
+struct cpu cpus[CPU_MAX];
+
+/* 켜진 CPU 수.  smp_init()이 AP를 하나씩 켤 때마다 늘어납니다. */
+int cpu_cnt = 1;
+
+/* -smp=N: 켤 CPU 수.  1이면 AP를 켜지 않습니다. */
+int smp_cpu_request = 1;
+
+/* TLB shootdown에 아직 응답하지 않은 CPU 수. */
+static int tlb_pending;
+
+/* AP 시작 코드 (start.S).  LOADER_AP_BASE로 복사해서 실행합니다. */
+extern const uint8_t ap_trampoline[], ap_trampoline_end[];
+
+/* start.S의 ap_entry_64가 읽는 값.  켜지는 AP가 쓸 페이지 테이블과
+   스택 꼭대기입니다. */
+uint64_t ap_boot_cr3;
+void *ap_boot_stack;
+
+/* C를 ID번 CPU의 빈 상태로 초기화합니다. */
+void
+cpu_init (struct cpu *c, int id) {
+	ASSERT (c != NULL);
+
+	memset (c, 0, sizeof *c);
+	c->id = id;
+	sched_rq_init (&c->rq);
+	list_init (&c->destruction_req);
+}
+
+/* C가 다시 스케줄링하도록 재스케줄 IPI를 보냅니다.  C가 현재
+   CPU이거나 아직 켜지지 않았으면 아무 일도 하지 않습니다. */
+void
+cpu_kick (struct cpu *c) {
+	if (c != this_cpu () && c->online && cpu_cnt > 1)
+		lapic_send_ipi (c->lapic_id, LAPIC_RESCHED_VEC);
+}
+
+/* 놀고 있는 CPU 하나를 깨워서 다른 CPU의 실행 큐에서 일을 훔쳐
+   가게 합니다. */
+void
+cpu_kick_idle (void) {
+	struct cpu *self = this_cpu ();
+	int i;
+
+	for (i = 0; i < cpu_cnt; i++) {
+		struct cpu *c = &cpus[i];
+
+		if (c != self && c->online && c->curr == c->idle_thread) {
+			cpu_kick (c);
+			return;
+		}
+	}
+}
+
+/* 모든 CPU가 TLB를 비우게 하고, 다른 CPU들이 다 비울 때까지
+   기다립니다.  커널 주소의 매핑을 지운 뒤에 부릅니다.  한 번에 한
+   스레드만 불러야 하고, 다른 CPU가 있으면 서로 기다리다 멈추지
+   않도록 인터럽트를 켠 채로 불러야 합니다. */
+void
+cpu_flush_tlb (void) {
+	struct cpu *self;
+	enum intr_level old_level;
+	int i, cnt = 0;
+
+	ASSERT (!intr_context ());
+
+	old_level = intr_disable ();
+	self = this_cpu ();
+	lcr3 (rcr3 ());
+	for (i = 0; i < cpu_cnt; i++)
+		if (&cpus[i] != self && cpus[i].online)
+			cnt++;
+	__atomic_store_n (&tlb_pending, cnt, __ATOMIC_SEQ_CST);
+	for (i = 0; i < cpu_cnt; i++)
+		if (&cpus[i] != self && cpus[i].online)
+			lapic_send_ipi (cpus[i].lapic_id, LAPIC_TLB_VEC);
+	intr_set_level (old_level);
+
+	if (cnt == 0)
+		return;
+	ASSERT (intr_get_level () == INTR_ON);
+	while (__atomic_load_n (&tlb_pending, __ATOMIC_SEQ_CST) > 0)
+		asm volatile ("pause" : : : "memory");
+}
+
+/* TLB shootdown IPI를 받은 CPU에서 부릅니다. */
+void
+cpu_tlb_interrupt (void) {
+	lcr3 (rcr3 ());
+	__atomic_sub_fetch (&tlb_pending, 1, __ATOMIC_SEQ_CST);
+}
+
+/* BSP의 로컬 APIC을 켜고, -smp=N으로 요청한 만큼 AP(application
+   processor)를 켭니다.  BSP의 로컬 APIC은 CPU가 하나여도 켜서 고해상도
+   타이머(devices/hrtimer.c)가 쓸 수 있게 합니다.
+   BSP에서 timer_calibrate() 뒤에 호출해야 합니다.
+
+   ACPI/MP 테이블은 읽지 않고, QEMU처럼 APIC ID가 0부터 차례로
+   매겨져 있다고 가정합니다.  AP는 하나씩 INIT-SIPI-SIPI 순서로
+   깨우고, 스스로 online을 켤 때까지 기다립니다.  제때 켜지지 않은
+   AP는 ap_state를 AP_ABANDONED로 바꿔 늦게라도 켜지지 못하게 하고,
+   INIT으로 멈춘 뒤에 idle 스레드 페이지를 돌려줍니다.  그 사이에
+   AP가 먼저 AP_STARTED로 바꿨다면 곧 켜지므로 마저 기다립니다. */
+void
+smp_init (void) {
+	int id;
+
+	ASSERT (this_cpu () == &cpus[0]);
+
+	if (!lapic_init ()) {
+		if (smp_cpu_request > 1)
+			printf ("smp: no local APIC, using 1 CPU.\n");
+		return;
+	}
+	cpus[0].lapic_id = lapic_id ();
+	if (smp_cpu_request <= 1)
+		return;
+
+	memcpy (ptov (LOADER_AP_BASE), ap_trampoline,
+			ap_trampoline_end - ap_trampoline);
+	ap_boot_cr3 = vtop (base_pml4);
+
+	for (id = 1; id < smp_cpu_request && id < CPU_MAX; id++) {
+		struct cpu *c = &cpus[id];
+		struct thread *idle;
+		int i;
+
+		cpu_init (c, id);
+		c->lapic_id = id;
+		idle = thread_create_ap_idle (c);
+		if (idle == NULL)
+			break;
+		ap_boot_stack = (uint8_t *) idle + PGSIZE;
+
+		lapic_start_ap (c->lapic_id, LOADER_AP_BASE);
+		for (i = 0; i < 100 && !c->online; i++)
+			timer_msleep (1);
+		if (!c->online) {
+			int state = AP_BOOTING;
+
+			if (__atomic_compare_exchange_n (&c->ap_state, &state,
+						AP_ABANDONED, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+				printf ("smp: cpu %d did not start.\n", id);
+				lapic_park_ap (c->lapic_id);
+				thread_destroy_ap_idle (c);
+				break;
+			}
+			while (!c->online)
+				asm volatile ("pause" : : : "memory");
+		}
+		cpu_cnt++;
+	}
+	printf ("smp: %d CPUs online.\n", cpu_cnt);
+}
+
+/* AP의 C 진입점.  start.S의 ap_entry_64가 이 CPU의 idle 스레드
+   페이지를 스택으로 삼아 인터럽트가 꺼진 채로 호출합니다. */
+void
+cpu_ap_main (void) {
+	struct cpu *c = this_cpu ();
+	int state = AP_BOOTING;
+
+	/* BSP가 이미 포기했으면 켜지지 않고 멈춥니다. */
+	if (!__atomic_compare_exchange_n (&c->ap_state, &state, AP_STARTED,
+				false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+		for (;;)
+			asm volatile ("cli; hlt" : : : "memory");
+
+	intr_init_ap ();
+	lapic_init_ap ();
+	c->online = true;
+	thread_start_ap ();
+}
@@ -9,7 +9,9 @@
 #include "threads/thread.h"
 #include "threads/mmu.h"
 #include "threads/vaddr.h"
+#include "devices/lapic.h"
 #include "devices/timer.h"
+#include "threads/cpu.h"
 #include "intrinsic.h"
 #ifdef USERPROG
 #include "userprog/gdt.h"
@@ -99,9 +101,16 @@ static const char *intr_names[INTR_CNT];
    pre-empted.  Handlers for external interrupts also may not
    sleep, although they may invoke intr_yield_on_return() to
    request that a new process be scheduled just before the
-   interrupt returns. */
-static bool in_external_intr;   /* Are we processing an external interrupt? */
-static bool yield_on_return;    /* Should we yield on interrupt return? */
+   interrupt returns.
+
+   Whether a CPU is processing an external interrupt, and whether
+   it should yield on return, are kept per CPU in struct cpu's
+   in_external_intr and yield_on_return members.
+
+   Besides the PIC's 0x20...0x2f, the local APIC's vectors
+   0xf0...0xfe are external interrupts. */
+#define is_external_vec(VEC) \
+	(((VEC) >= 0x20 && (VEC) < 0x30) || ((VEC) >= 0xf0 && (VEC) < 0xff))
 
 /* Programmable Interrupt Controller helpers. */
 static void pic_init (void);
@@ -110,6 +119,12 @@ static void pic_end_of_interrupt (int irq);
 /* Interrupt handlers. */
 void intr_handler (struct intr_frame *args);
 
+static enum intr_level disable_from (void *caller);
+#ifdef INTR_TRACE
+static void intr_off_begin (void *caller);
+static void intr_off_end (void);
+#endif
+
 /* Returns the current interrupt status. */
 enum intr_level
 intr_get_level (void) {
@@ -128,7 +143,8 @@ intr_get_level (void) {
    returns the previous interrupt status. */
 enum intr_level
 intr_set_level (enum intr_level level) {
-	return level == INTR_ON ? intr_enable () : intr_disable ();
+	return (level == INTR_ON ? intr_enable ()
+			: disable_from (__builtin_return_address (0)));
 }
 
 /* Enables interrupts and returns the previous interrupt status. */
@@ -137,6 +153,11 @@ intr_enable (void) {
 	enum intr_level old_level = intr_get_level ();
 	ASSERT (!intr_context ());
 
+#ifdef INTR_TRACE
+	if (old_level == INTR_OFF)
+		intr_off_end ();
+#endif
+
 	/* Enable interrupts by setting the interrupt flag.
 
 	   See [IA32-v2b] "STI" and [IA32-v3a] 5.8.1 "Masking Maskable
@@ -149,6 +170,13 @@ intr_enable (void) {
 /* Disables interrupts and returns the previous interrupt status. */
 enum intr_level
 intr_disable (void) {
+	return disable_from (__builtin_return_address (0));
+}
+
+/* Does the work of intr_disable().  CALLER is the code that asked
+   for interrupts off, for the interrupts-off tracer. */
+static enum intr_level
+disable_from (void *caller UNUSED) {
 	enum intr_level old_level = intr_get_level ();
 
 	/* Disable interrupts by clearing the interrupt flag.
@@ -156,6 +184,11 @@ intr_disable (void) {
 	   Hardware Interrupts". */
 	asm volatile ("cli" : : : "memory");
 
+#ifdef INTR_TRACE
+	if (old_level == INTR_ON)
+		intr_off_begin (caller);
+#endif
+
 	return old_level;
 }
 
@@ -203,6 +236,13 @@ intr_init (void) {
 	intr_names[19] = "#XF SIMD Floating-Point Exception";
 }
 
+/* Loads the IDT built by intr_init() on an application
+   processor, which shares all interrupt handlers with the BSP. */
+void
+intr_init_ap (void) {
+	lidt(&idt_desc);
+}
+
 /* Registers interrupt VEC_NO to invoke HANDLER with descriptor
    privilege level DPL.  Names the interrupt NAME for debugging
    purposes.  The interrupt handler will be invoked with
@@ -227,7 +267,7 @@ register_handler (uint8_t vec_no, int dpl, enum intr_level level,
 void
 intr_register_ext (uint8_t vec_no, intr_handler_func *handler,
 		const char *name) {
-	ASSERT (vec_no >= 0x20 && vec_no <= 0x2f);
+	ASSERT (is_external_vec (vec_no));
 	register_handler (vec_no, 0, INTR_OFF, handler, name);
 }
 
@@ -248,7 +288,7 @@ void
 intr_register_int (uint8_t vec_no, int dpl, enum intr_level level,
 		intr_handler_func *handler, const char *name)
 {
-	ASSERT (vec_no < 0x20 || vec_no > 0x2f);
+	ASSERT (!is_external_vec (vec_no));
 	register_handler (vec_no, dpl, level, handler, name);
 }
 
@@ -256,7 +296,12 @@ intr_register_int (uint8_t vec_no, int dpl, enum intr_level level,
    and false at all other times. */
 bool
 intr_context (void) {
-	return in_external_intr;
+	/* External interrupts run with interrupts off, so with them on
+	   we cannot be in one.  Checking this first also keeps us from
+	   reading another CPU's flag after being migrated. */
+	if (intr_get_level () == INTR_ON)
+		return false;
+	return this_cpu ()->in_external_intr;
 }
 
 /* During processing of an external interrupt, directs the
@@ -266,7 +311,7 @@ intr_context (void) {
 void
 intr_yield_on_return (void) {
 	ASSERT (intr_context ());
-	yield_on_return = true;
+	this_cpu ()->yield_on_return = true;
 }
 
 /* 8259A Programmable Interrupt Controller. */
@@ -331,19 +376,43 @@ pic_end_of_interrupt (int irq) {
 void
 intr_handler (struct intr_frame *frame) {
 	bool external;
+	bool from_user = (frame->cs & 3) == 3;
 	intr_handler_func *handler;
 
+	/* Time spent before this point was spent in user mode. */
+	if (from_user)
+		thread_enter_kernel ();
+
+#ifdef INTR_TRACE
+	/* The interrupted code ran with interrupts on, so a window
+	   still open on this CPU was closed without intr_enable(), by
+	   "sti; hlt" in the idle thread or by an iret, and its length
+	   is unknown.  Drop it, and time the handler instead if it
+	   runs with interrupts off. */
+	if (frame->eflags & FLAG_IF) {
+		this_cpu ()->intr_off_stamp = 0;
+		if (intr_get_level () == INTR_OFF)
+			intr_off_begin (intr_handlers[frame->vec_no]);
+	}
+#endif
+
 	/* External interrupts are special.
 	   We only handle one at a time (so interrupts must be off)
 	   and they need to be acknowledged on the PIC (see below).
 	   An external interrupt handler cannot sleep. */
-	external = frame->vec_no >= 0x20 && frame->vec_no < 0x30;
+	external = is_external_vec (frame->vec_no);
 	if (external) {
 		ASSERT (intr_get_level () == INTR_OFF);
 		ASSERT (!intr_context ());
 
-		in_external_intr = true;
-		yield_on_return = false;
+		this_cpu ()->in_external_intr = true;
+		this_cpu ()->yield_on_return = false;
+
+		/* If the timer was stopped while the CPU was idle, bring the
+		   tick count up to date before any handler looks at it.
+		   The timer's own handler does this itself. */
+		if (frame->vec_no != 0x20)
+			timer_idle_exit ();
 	}
 
 	/* Invoke the interrupt's handler. */
@@ -366,12 +435,130 @@ intr_handler (struct intr_frame *frame) {
 		ASSERT (intr_get_level () == INTR_OFF);
 		ASSERT (intr_context ());
 
-		in_external_intr = false;
-		pic_end_of_interrupt (frame->vec_no);
+		this_cpu ()->in_external_intr = false;
+		if (frame->vec_no >= 0xf0)
+			lapic_eoi ();
+		else
+			pic_end_of_interrupt (frame->vec_no);
 
-		if (yield_on_return)
+		if (this_cpu ()->yield_on_return)
 			thread_yield ();
 	}
+
+	if (from_user)
+		thread_enter_user ();
+
+#ifdef INTR_TRACE
+	/* The iret turns interrupts back on. */
+	if (frame->eflags & FLAG_IF)
+		intr_off_end ();
+#endif
+}
+
+#ifdef INTR_TRACE
+/* Interrupts-off tracer.
+
+   Built only with INTR_TRACE defined (`make INTR_TRACE=1').
+   Every switch from interrupts on to off through intr_disable()
+   or intr_set_level() stamps the current CPU with the TSC and
+   the caller's address, and the matching intr_enable() charges
+   the window to a log2 histogram and, if it is long enough, to a
+   short list of the longest windows.  Interrupt handlers that
+   run with interrupts off are timed the same way, charged to the
+   handler function.  intr_print_stats() merges the per-CPU data
+   at power-off; the addresses can be turned into source lines
+   with the `backtrace' tool.
+
+   A window that starts in one thread and ends in another, across
+   a context switch, is charged to the code that started it, since
+   that is how long the CPU could not take interrupts.
+
+   Everything here runs with interrupts off on the CPU whose data
+   it touches, so no locking is needed. */
+
+/* Starts an interrupts-off window on this CPU, turned off by
+   CALLER. */
+static void
+intr_off_begin (void *caller) {
+	struct cpu *c = this_cpu ();
+
+	c->intr_off_caller = caller;
+	c->intr_off_stamp = rdtsc ();
+}
+
+/* Ends this CPU's interrupts-off window, if one is being timed,
+   and records its length. */
+static void
+intr_off_end (void) {
+	struct cpu *c = this_cpu ();
+	uint64_t now = rdtsc ();
+	uint64_t cycles;
+	int min, k, i;
+
+	if (c->intr_off_stamp == 0)
+		return;
+	cycles = now > c->intr_off_stamp ? now - c->intr_off_stamp : 0;
+	c->intr_off_stamp = 0;
+
+	k = cycles == 0 ? 0 : 64 - __builtin_clzll (cycles);
+	if (k >= INTR_TRACE_BUCKETS)
+		k = INTR_TRACE_BUCKETS - 1;
+	c->intr_off_hist[k]++;
+
+	/* Replace the shortest of the kept windows. */
+	min = 0;
+	for (i = 1; i < INTR_TRACE_TOP; i++)
+		if (c->intr_off_top[i].cycles < c->intr_off_top[min].cycles)
+			min = i;
+	if (cycles > c->intr_off_top[min].cycles) {
+		c->intr_off_top[min].cycles = cycles;
+		c->intr_off_top[min].caller = c->intr_off_caller;
+	}
+}
+#endif /* INTR_TRACE */
+
+/* Prints the longest interrupts-off windows over all CPUs and a
+   histogram of their lengths.  Prints nothing unless the kernel
+   was built with INTR_TRACE. */
+void
+intr_print_stats (void) {
+#ifdef INTR_TRACE
+	struct intr_off_window top[INTR_TRACE_TOP];
+	uint64_t hist[INTR_TRACE_BUCKETS];
+	int i, j, k;
+
+	for (i = 0; i < INTR_TRACE_TOP; i++)
+		top[i].cycles = 0;
+	for (k = 0; k < INTR_TRACE_BUCKETS; k++)
+		hist[k] = 0;
+
+	/* Merge the per-CPU lists, keeping TOP sorted longest first. */
+	for (i = 0; i < cpu_cnt; i++) {
+		struct cpu *c = &cpus[i];
+
+		for (k = 0; k < INTR_TRACE_BUCKETS; k++)
+			hist[k] += c->intr_off_hist[k];
+		for (j = 0; j < INTR_TRACE_TOP; j++) {
+			struct intr_off_window w = c->intr_off_top[j];
+
+			if (w.cycles <= top[INTR_TRACE_TOP - 1].cycles)
+				continue;
+			for (k = INTR_TRACE_TOP - 1; k > 0 && top[k - 1].cycles < w.cycles;
+					k--)
+				top[k] = top[k - 1];
+			top[k] = w;
+		}
+	}
+
+	printf ("Longest interrupts-off windows (cycles):\n");
+	for (i = 0; i < INTR_TRACE_TOP && top[i].cycles > 0; i++)
+		printf ("  %12llu  %p\n", (unsigned long long) top[i].cycles,
+				top[i].caller);
+	printf ("Interrupts-off windows (cycles):\n");
+	for (k = 0; k < INTR_TRACE_BUCKETS; k++)
+		if (hist[k] > 0)
+			printf ("  < 2^%-2d %llu\n", k, (unsigned long long) hist[k]);
+#endif
 }
 
 /* Dumps interrupt frame F to the console, for debugging. */
@@ -8,6 +8,7 @@
 #include "threads/palloc.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
+#include "threads/vmalloc.h"
 
 /* A simple implementation of malloc().
 
@@ -40,6 +41,7 @@ struct desc {
 	size_t blocks_per_arena;    /* Number of blocks in an arena. */
 	struct list free_list;      /* List of free blocks. */
 	struct lock lock;           /* Lock. */
+	char name[16];              /* Name of the lock, e.g. "malloc 64". */
 };
 
 /* Magic number for detecting arena corruption. */
@@ -75,7 +77,8 @@ malloc_init (void) {
 		d->block_size = block_size;
 		d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
 		list_init (&d->free_list);
-		lock_init (&d->lock);
+		snprintf (d->name, sizeof d->name, "malloc %zu", block_size);
+		lock_init_named (&d->lock, d->name);
 	}
 }
 
@@ -98,9 +101,14 @@ malloc (size_t size) {
 			break;
 	if (d == descs + desc_cnt) {
 		/* SIZE is too big for any descriptor.
-		   Allocate enough pages to hold SIZE plus an arena. */
+		   Allocate enough pages to hold SIZE plus an arena.
+		   More than one page comes from vmalloc(), which does not
+		   need them to be physically contiguous, once it is
+		   up. */
 		size_t page_cnt = DIV_ROUND_UP (size + sizeof *a, PGSIZE);
-		a = palloc_get_multiple (0, page_cnt);
+		a = page_cnt > 1 ? vmalloc (PGSIZE * page_cnt) : NULL;
+		if (a == NULL)
+			a = palloc_get_multiple (0, page_cnt);
 		if (a == NULL)
 			return NULL;
 
@@ -233,7 +241,10 @@ free (void *p) {
 			lock_release (&d->lock);
 		} else {
 			/* It's a big block.  Free its pages. */
-			palloc_free_multiple (a, a->free_cnt);
+			if (is_vmalloc_vaddr (a))
+				vfree (a);
+			else
+				palloc_free_multiple (a, a->free_cnt);
 			return;
 		}
 	}
@@ -1,13 +1,14 @@
 #include "threads/palloc.h"
-#include <bitmap.h>
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/loader.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
@@ -24,13 +25,62 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   Each pool is a binary buddy allocator.  Free memory is kept as
+   blocks of 2**K pages, aligned to 2**K pages relative to the
+   pool base, on one free list per order K.  The list_elem of a
+   free block lives in its first page, so the only other
+   bookkeeping is one byte per page that tells whether the page
+   begins a free block and of what order.  Allocation takes the
+   smallest non-empty order at or above the one requested (one
+   bit scan over free_orders) and splits it down; freeing merges
+   a block with its buddy for as long as the buddy is free.  Both
+   are bounded by PAL_ORDERS steps, however big the pool is.
+
+   Requests that are not a power of two take the next larger
+   block and give back the tail right away, and frees break the
+   range up into aligned blocks again, so the caller only has to
+   pass the same page count to palloc_free_multiple() as to
+   palloc_get_multiple(), just like before.
+
+   Each pool also keeps a list of pages that are already filled
+   with zeros, so that PAL_ZERO requests for a single page do not
+   have to clear 4 kB on the spot.  Idle CPUs refill it through
+   palloc_zero_idle(): once it falls below ZERO_LOW pages they
+   take pages from the buddy lists and zero them until it holds
+   ZERO_HIGH.  The list_elem of a zeroed page sits in its first
+   bytes and is cleared again when the page is handed out.  When
+   the buddy lists run dry, the zeroed pages go back to them. */
+
+/* Number of block orders: blocks of 1 to 2**(PAL_ORDERS - 1)
+   pages. */
+#define PAL_ORDERS 20
+
+/* page_info[] bit set on the first page of a free block; the
+   low bits hold the block's order. */
+#define PAGE_FREE 0x80
+#define PAGE_ORDER 0x1f
+
+/* Watermarks for each pool's list of zeroed pages. */
+#define ZERO_LOW 32
+#define ZERO_HIGH 128
 
 /* A memory pool. */
 struct pool {
 	struct lock lock;               /* Mutual exclusion. */
-	struct bitmap *used_map;        /* Bitmap of free pages. */
 	uint8_t *base;                  /* Base of pool. */
+	size_t page_cnt;                /* Number of pages in pool. */
+	uint8_t *page_info;             /* Per page, PAGE_FREE | order. */
+	struct list free_lists[PAL_ORDERS]; /* Free blocks by order. */
+	uint32_t free_orders;           /* Bit K set if free_lists[K]
+	                                   is nonempty. */
+	size_t free_cnt;                /* Number of free pages. */
+
+	struct spinlock zero_lock;      /* Protects the members below. */
+	struct list zeroed;             /* Pages filled with zeros. */
+	size_t zeroed_cnt;              /* Number of pages in zeroed. */
+	bool zero_refill;               /* Refilling up to ZERO_HIGH. */
 };
 
 /* Two pools: one for kernel data, one for user pages. */
@@ -39,9 +89,18 @@ static struct pool kernel_pool, user_pool;
 /* Maximum number of pages to put in user pool. */
 size_t user_page_limit = SIZE_MAX;
 static void
-init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end);
+init_pool (struct pool *p, const char *name, void **bm_base,
+		uint64_t start, uint64_t end);
 
 static bool page_from_pool (const struct pool *, void *page);
+static int page_order (size_t page_cnt);
+static bool buddy_alloc (struct pool *, int order, size_t *page_idx);
+static void buddy_free (struct pool *, size_t page_idx, int order);
+static void buddy_free_range (struct pool *, size_t page_idx,
+		size_t page_cnt);
+static void *pool_get (struct pool *, size_t page_cnt);
+static void *zeroed_pop (struct pool *);
+static bool zeroed_drain (struct pool *);
 
 /* multiboot info */
 struct multiboot_info {
@@ -158,7 +217,7 @@ populate_pools (struct area *base_mem, struct area *ext_mem) {
 						break;
 					}
 					// generate kernel pool
-					init_pool (&kernel_pool,
+					init_pool (&kernel_pool, "kernel pool",
 							&free_start, region_start, start + rem * PGSIZE);
 					// Transition to the next state
 					if (rem == size_in_pg) {
@@ -188,7 +247,7 @@ populate_pools (struct area *base_mem, struct area *ext_mem) {
 	}
 
 	// generate the user pool
-	init_pool(&user_pool, &free_start, region_start, end);
+	init_pool(&user_pool, "user pool", &free_start, region_start, end);
 
 	// Iterate over the e820_entry. Setup the usable.
 	uint64_t usable_bound = (uint64_t) free_start;
@@ -219,16 +278,18 @@ split:
 			else
 				NOT_REACHED ();
 
-			pool_end = pool->base + bitmap_size (pool->used_map) * PGSIZE;
+			pool_end = pool->base + pool->page_cnt * PGSIZE;
 			page_idx = pg_no (start) - pg_no (pool->base);
 			if ((uint64_t) pool_end < end) {
 				page_cnt = ((uint64_t) pool_end - start) / PGSIZE;
-				bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+				buddy_free_range (pool, page_idx, page_cnt);
+				pool->free_cnt += page_cnt;
 				start = (uint64_t) pool_end;
 				goto split;
 			} else {
 				page_cnt = ((uint64_t) end - start) / PGSIZE;
-				bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+				buddy_free_range (pool, page_idx, page_cnt);
+				pool->free_cnt += page_cnt;
 			}
 		}
 	}
@@ -262,25 +323,21 @@ palloc_init (void) {
 void *
 palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
 	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
-
-	lock_acquire (&pool->lock);
-	size_t page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
-	lock_release (&pool->lock);
-	void *pages;
-
-	if (page_idx != BITMAP_ERROR)
-		pages = pool->base + PGSIZE * page_idx;
-	else
-		pages = NULL;
-
-	if (pages) {
-		if (flags & PAL_ZERO)
+	void *pages = NULL;
+
+	if (page_cnt == 1 && (flags & PAL_ZERO))
+		pages = zeroed_pop (pool);
+	if (pages == NULL) {
+		pages = pool_get (pool, page_cnt);
+		if (pages == NULL && zeroed_drain (pool))
+			pages = pool_get (pool, page_cnt);
+		if (pages != NULL && (flags & PAL_ZERO))
 			memset (pages, 0, PGSIZE * page_cnt);
-	} else {
-		if (flags & PAL_ASSERT)
-			PANIC ("palloc_get: out of pages");
 	}
 
+	if (pages == NULL && (flags & PAL_ASSERT))
+		PANIC ("palloc_get: out of pages");
+
 	return pages;
 }
 
@@ -315,11 +372,15 @@ palloc_free_multiple (void *pages, size_t page_cnt) {
 
 	page_idx = pg_no (pages) - pg_no (pool->base);
 
+	ASSERT (page_idx + page_cnt <= pool->page_cnt);
+
 #ifndef NDEBUG
 	memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
-	ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
-	bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+	lock_acquire (&pool->lock);
+	buddy_free_range (pool, page_idx, page_cnt);
+	pool->free_cnt += page_cnt;
+	lock_release (&pool->lock);
 }
 
 /* Frees the page at PAGE. */
@@ -328,23 +389,83 @@ palloc_free_page (void *page) {
 	palloc_free_multiple (page, 1);
 }
 
-/* Initializes pool P as starting at START and ending at END */
+/* Zeroes one page for a pool whose zeroed list is being
+   refilled.  Called by the idle thread with interrupts on, so it
+   never waits for a pool lock.  Returns true if it zeroed a page
+   and there may be more to do. */
+bool
+palloc_zero_idle (void) {
+	struct pool *pools[] = { &kernel_pool, &user_pool };
+	size_t i;
+
+	for (i = 0; i < sizeof pools / sizeof *pools; i++) {
+		struct pool *p = pools[i];
+		enum intr_level old_level;
+		void *page = NULL;
+
+		if (!__atomic_load_n (&p->zero_refill, __ATOMIC_RELAXED))
+			continue;
+
+		/* Keep the interrupts off while holding the lock, so that
+		   nobody waits on it behind the idle thread. */
+		old_level = intr_disable ();
+		if (lock_try_acquire (&p->lock)) {
+			size_t page_idx;
+
+			/* Leave the last pages of a nearly full pool alone. */
+			if (p->free_cnt > ZERO_HIGH && buddy_alloc (p, 0, &page_idx)) {
+				p->free_cnt--;
+				page = p->base + PGSIZE * page_idx;
+			} else
+				p->zero_refill = false;
+			lock_release (&p->lock);
+		}
+		intr_set_level (old_level);
+		if (page == NULL)
+			continue;
+
+		memset (page, 0, PGSIZE);
+
+		old_level = intr_disable ();
+		spinlock_acquire (&p->zero_lock);
+		list_push_front (&p->zeroed, page);
+		if (++p->zeroed_cnt >= ZERO_HIGH)
+			p->zero_refill = false;
+		spinlock_release (&p->zero_lock);
+		intr_set_level (old_level);
+		return true;
+	}
+	return false;
+}
+
+/* Initializes pool P, called NAME, as starting at START and
+   ending at END */
 static void
-init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
-  /* We'll put the pool's used_map at its base.
-     Calculate the space needed for the bitmap
-     and subtract it from the pool's size. */
+init_pool (struct pool *p, const char *name, void **bm_base,
+		uint64_t start, uint64_t end) {
+  /* We'll put the pool's page_info at BM_BASE.
+     Calculate the space needed for it, one byte per page. */
 	uint64_t pgcnt = (end - start) / PGSIZE;
-	size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (pgcnt), PGSIZE) * PGSIZE;
+	size_t info_pages = DIV_ROUND_UP (pgcnt, PGSIZE) * PGSIZE;
+	int order;
 
-	lock_init(&p->lock);
-	p->used_map = bitmap_create_in_buf (pgcnt, *bm_base, bm_pages);
+	lock_init_named (&p->lock, name);
 	p->base = (void *) start;
+	p->page_cnt = pgcnt;
+	p->page_info = *bm_base;
+	for (order = 0; order < PAL_ORDERS; order++)
+		list_init (&p->free_lists[order]);
+	p->free_orders = 0;
+	p->free_cnt = 0;
+	spinlock_init (&p->zero_lock);
+	list_init (&p->zeroed);
+	p->zeroed_cnt = 0;
+	p->zero_refill = true;
 
 	// Mark all to unusable.
-	bitmap_set_all(p->used_map, true);
+	memset (p->page_info, 0, pgcnt);
 
-	*bm_base += bm_pages;
+	*bm_base += info_pages;
 }
 
 /* Returns true if PAGE was allocated from POOL,
@@ -353,6 +474,185 @@ static bool
 page_from_pool (const struct pool *pool, void *page) {
 	size_t page_no = pg_no (page);
 	size_t start_page = pg_no (pool->base);
-	size_t end_page = start_page + bitmap_size (pool->used_map);
+	size_t end_page = start_page + pool->page_cnt;
 	return page_no >= start_page && page_no < end_page;
 }
+
+/* Obtains PAGE_CNT contiguous pages from P's buddy lists, or
+   returns a null pointer if there is no block big enough. */
+static void *
+pool_get (struct pool *p, size_t page_cnt) {
+	void *pages = NULL;
+	size_t page_idx;
+	int order = page_order (page_cnt);
+
+	if (page_cnt == 0 || order >= PAL_ORDERS)
+		return NULL;
+
+	lock_acquire (&p->lock);
+	if (buddy_alloc (p, order, &page_idx)) {
+		/* Give back what the power of two rounded up. */
+		if (page_cnt != (size_t) 1 << order)
+			buddy_free_range (p, page_idx + page_cnt,
+					((size_t) 1 << order) - page_cnt);
+		p->free_cnt -= page_cnt;
+		pages = p->base + PGSIZE * page_idx;
+	}
+	lock_release (&p->lock);
+	return pages;
+}
+
+/* Takes a page off P's zeroed list and returns it, or returns a
+   null pointer if the list is empty. */
+static void *
+zeroed_pop (struct pool *p) {
+	enum intr_level old_level;
+	struct list_elem *page = NULL;
+
+	old_level = intr_disable ();
+	spinlock_acquire (&p->zero_lock);
+	if (!list_empty (&p->zeroed)) {
+		page = list_pop_front (&p->zeroed);
+		p->zeroed_cnt--;
+	}
+	if (p->zeroed_cnt < ZERO_LOW)
+		p->zero_refill = true;
+	spinlock_release (&p->zero_lock);
+	intr_set_level (old_level);
+
+	if (page != NULL)
+		memset (page, 0, sizeof *page);
+	return page;
+}
+
+/* Gives all of P's zeroed pages back to its buddy lists.
+   Returns true if there were any. */
+static bool
+zeroed_drain (struct pool *p) {
+	enum intr_level old_level;
+	struct list pages;
+
+	list_init (&pages);
+	old_level = intr_disable ();
+	spinlock_acquire (&p->zero_lock);
+	if (!list_empty (&p->zeroed))
+		list_splice (list_end (&pages), list_begin (&p->zeroed),
+				list_end (&p->zeroed));
+	p->zeroed_cnt = 0;
+	spinlock_release (&p->zero_lock);
+	intr_set_level (old_level);
+
+	if (list_empty (&pages))
+		return false;
+
+	lock_acquire (&p->lock);
+	while (!list_empty (&pages)) {
+		void *page = list_pop_front (&pages);
+
+		buddy_free (p, pg_no (page) - pg_no (p->base), 0);
+		p->free_cnt++;
+	}
+	lock_release (&p->lock);
+	return true;
+}
+
+/* Returns the smallest order whose blocks hold PAGE_CNT
+   pages. */
+static int
+page_order (size_t page_cnt) {
+	if (page_cnt <= 1)
+		return 0;
+	return 64 - __builtin_clzll (page_cnt - 1);
+}
+
+/* Returns the free list element stored in the page at PAGE_IDX. */
+static struct list_elem *
+block_elem (struct pool *p, size_t page_idx) {
+	return (struct list_elem *) (p->base + PGSIZE * page_idx);
+}
+
+/* Puts the block of 2**ORDER pages at PAGE_IDX on its free list. */
+static void
+free_list_push (struct pool *p, size_t page_idx, int order) {
+	p->page_info[page_idx] = PAGE_FREE | order;
+	list_push_front (&p->free_lists[order], block_elem (p, page_idx));
+	p->free_orders |= 1u << order;
+}
+
+/* Takes the block of 2**ORDER pages at PAGE_IDX off its free
+   list. */
+static void
+free_list_remove (struct pool *p, size_t page_idx, int order) {
+	ASSERT (p->page_info[page_idx] == (PAGE_FREE | order));
+
+	p->page_info[page_idx] = 0;
+	list_remove (block_elem (p, page_idx));
+	if (list_empty (&p->free_lists[order]))
+		p->free_orders &= ~(1u << order);
+}
+
+/* Takes a free block of 2**ORDER pages from P, splitting a
+   bigger one if there is none of that size, and stores the index
+   of its first page in *PAGE_IDX.  Returns false if P has no
+   block big enough.  A single page comes straight off the
+   order-0 list whenever it is nonempty.  Must hold P's lock. */
+static bool
+buddy_alloc (struct pool *p, int order, size_t *page_idx) {
+	uint32_t orders = p->free_orders >> order;
+	size_t idx;
+	int k;
+
+	if (orders == 0)
+		return false;
+
+	k = order + __builtin_ctz (orders);
+	idx = pg_no (list_front (&p->free_lists[k])) - pg_no (p->base);
+	free_list_remove (p, idx, k);
+
+	/* Hand the upper halves back until the block is small enough. */
+	while (k > order) {
+		k--;
+		free_list_push (p, idx + ((size_t) 1 << k), k);
+	}
+	*page_idx = idx;
+	return true;
+}
+
+/* Frees the block of 2**ORDER pages at PAGE_IDX, merging it with
+   its buddy for as long as the buddy is free too.  Must hold P's
+   lock. */
+static void
+buddy_free (struct pool *p, size_t page_idx, int order) {
+	ASSERT (!(p->page_info[page_idx] & PAGE_FREE));
+
+	while (order < PAL_ORDERS - 1) {
+		size_t buddy = page_idx ^ ((size_t) 1 << order);
+
+		if (buddy >= p->page_cnt
+				|| p->page_info[buddy] != (PAGE_FREE | order))
+			break;
+		free_list_remove (p, buddy, order);
+		page_idx &= ~((size_t) 1 << order);
+		order++;
+	}
+	free_list_push (p, page_idx, order);
+}
+
+/* Frees the PAGE_CNT pages at PAGE_IDX, as the largest aligned
+   blocks that fit.  Must hold P's lock, except while the pools
+   are being populated. */
+static void
+buddy_free_range (struct pool *p, size_t page_idx, size_t page_cnt) {
+	while (page_cnt > 0) {
+		int order = page_idx == 0 ? PAL_ORDERS - 1
+			: __builtin_ctzll (page_idx);
+
+		if (order > PAL_ORDERS - 1)
+			order = PAL_ORDERS - 1;
+		while (((size_t) 1 << order) > page_cnt)
+			order--;
+		buddy_free (p, page_idx, order);
+		page_idx += (size_t) 1 << order;
+		page_cnt -= (size_t) 1 << order;
+	}
+}
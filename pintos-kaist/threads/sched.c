@@ -0,0 +1,666 @@
+#include "threads/sched.h"
+#include <debug.h>
+#include <stdio.h>
+#include "threads/cpu.h"
+#include "threads/synch.h"
+#include "devices/timer.h"
+
+/* 스케줄링 클래스들입니다 (sched.h).
+
+   EDF 클래스는 마감이 있는 실시간 스레드를 위한 것으로, 절대 마감이
+   가장 이른 스레드를 먼저 실행하며 다른 모든 클래스를 선점합니다.
+   스레드는 주기(period)마다 실행 시간(runtime)을 받고, 그 예산을 다
+   쓰면 다음 주기까지 잠듭니다 (CBS).  EDF는 분할 방식입니다.  승인할
+   때 대역폭이 남는 CPU 하나를 골라 스레드를 그 CPU에 묶고, CPU마다
+   묶인 스레드들의 runtime / period 합을 DL_BW_MAX 이하로 유지합니다.
+   EDF 스레드는 다른 CPU가 훔쳐 가지 않으므로, 한 스레드가 예산을
+   넘겨 다른 스레드의 마감을 망치거나 다른 클래스를 굶기지 못합니다.
+
+   우선순위 클래스는 원래의 우선순위 라운드 로빈입니다.  우선순위가
+   높은 스레드가 먼저 실행되고, 같은 우선순위끼리는 TIME_SLICE 틱씩
+   돌아가며 실행됩니다.  MLFQS도 이 클래스에서 우선순위만 다르게
+   정하는 것입니다.
+
+   공정 클래스는 CFS를 본뜬 것으로, 스레드마다 nice로 정해지는 가중치로
+   나눈 실행 시간(vruntime)을 재고 vruntime이 가장 작은 스레드를
+   실행합니다.  준비된 스레드들은 vruntime 순서의 레드-블랙 트리에
+   있으므로 다음 스레드를 고르는 데 O(1), 넣고 빼는 데 O(log n)이
+   듭니다.  우선순위 클래스에 준비된 스레드가 있으면 공정 클래스의
+   스레드는 실행되지 않습니다. */
+
+/* EDF 대역폭 (runtime / period)은 DL_BW_SHIFT 비트의 소수부를 가진
+   고정소수점으로 나타냅니다.  DL_BW_MAX는 CPU 하나에서 EDF 스레드들이
+   쓸 수 있는 대역폭의 상한으로, 나머지는 다른 클래스의 몫입니다. */
+#define DL_BW_SHIFT 20
+#define DL_BW_ONE (1ULL << DL_BW_SHIFT)
+#define DL_BW_MAX (DL_BW_ONE * 95 / 100)
+
+/* 우선순위 클래스: 같은 우선순위의 스레드에게 주는 타이머 틱 수. */
+#define TIME_SLICE 4
+
+/* 우선순위 클래스의 비어 있지 않은 큐들을 64비트 mask에 담습니다. */
+#define PRI_CNT (PRI_MAX - PRI_MIN + 1)
+#if PRI_CNT > 64
+#error runqueue mask holds at most 64 priorities
+#endif
+
+/* 공정 클래스의 시간 단위.  nice가 0인 스레드가 틱 하나를 쓰면
+   vruntime이 FAIR_TICK만큼 늘어납니다. */
+#define FAIR_TICK (1ULL << 20)
+
+/* nice가 0인 스레드의 가중치. */
+#define FAIR_WEIGHT_0 1024
+
+/* 준비된 공정 클래스 스레드가 모두 한 번씩 실행되는 주기 (틱).
+   스레드가 많아 한 스레드의 몫이 FAIR_MIN_SLICE보다 작아지면 주기를
+   늘립니다. */
+#define FAIR_LATENCY 8
+#define FAIR_MIN_SLICE 1
+
+/* 깨어난 스레드가 실행 중인 스레드를 선점하려면 vruntime이 이만큼
+   더 작아야 합니다.  너무 잦은 전환을 막습니다. */
+#define FAIR_WAKEUP_GRAN FAIR_TICK
+
+/* nice NICE_MIN...NICE_MAX에 대응하는 가중치.  nice가 1 늘 때마다
+   CPU 몫이 약 10%씩 줄도록 이웃한 값의 비가 약 1.25입니다. */
+static const unsigned long fair_weights[NICE_MAX - NICE_MIN + 1] = {
+	/* -20 */ 88761, 71755, 56483, 46273, 36291,
+	/* -15 */ 29154, 23254, 18705, 14949, 11916,
+	/* -10 */  9548,  7620,  6100,  4904,  3906,
+	/*  -5 */  3121,  2501,  1991,  1586,  1277,
+	/*   0 */  1024,   820,   655,   526,   423,
+	/*   5 */   335,   272,   215,   172,   137,
+	/*  10 */   110,    87,    70,    56,    45,
+	/*  15 */    36,    29,    23,    18,    15,
+	/*  20 */    12,
+};
+
+/* 순위 순서로 늘어놓은 클래스들. */
+static const struct sched_class *const sched_classes[] = {
+	&sched_dl_class,
+	&sched_prio_class,
+	&sched_fair_class,
+};
+#define SCHED_CLASS_CNT (sizeof sched_classes / sizeof *sched_classes)
+
+/* EDF 승인 제어: 각 실행 큐의 dl_bw를 보호합니다. */
+static struct spinlock dl_bw_lock;
+
+/* EDF 통계. */
+static long long dl_admitted;           /* 승인한 요청 수. */
+static long long dl_rejected;           /* 거절한 요청 수. */
+
+static bool dl_less (const struct heap_elem *, const struct heap_elem *,
+		void *aux);
+static void dl_replenish (struct thread *, int64_t now);
+static bool fair_less (const struct rb_node *, const struct rb_node *,
+		void *aux);
+
+/* 스케줄러의 전역 상태를 초기화합니다.  thread_init()에서
+   호출됩니다. */
+void
+sched_init (void) {
+	spinlock_init (&dl_bw_lock);
+}
+
+/* RQ를 빈 실행 큐로 초기화합니다. */
+void
+sched_rq_init (struct runqueue *rq) {
+	size_t i;
+
+	spinlock_init (&rq->lock);
+	rq->nr_ready = 0;
+	for (i = 0; i < sizeof rq->queues / sizeof *rq->queues; i++)
+		list_init (&rq->queues[i]);
+	rq->mask = 0;
+	heap_init (&rq->dl_heap, dl_less, NULL);
+	rq->dl_bw = 0;
+	rb_init (&rq->fair_tree, fair_less, NULL);
+	rq->min_vruntime = 0;
+	rq->fair_load = 0;
+}
+
+/* T가 지금 속해야 할 클래스를 반환합니다.
+
+   공정 정책의 스레드라도 원래보다 높은 우선순위를 기부받는 동안에는
+   우선순위 클래스에서 그 우선순위로 실행됩니다.  그렇지 않으면 그
+   스레드가 가진 락을 기다리는 우선순위 클래스의 스레드가 다른 우선순위
+   클래스 스레드들에게 밀려 무한정 기다릴 수 있습니다.  MLFQS에는
+   기부가 없으므로 정책만 봅니다. */
+const struct sched_class *
+sched_class_of (const struct thread *t) {
+	if (t->policy == SCHED_DEADLINE)
+		return &sched_dl_class;
+	if (t->policy == SCHED_FAIR
+			&& (thread_mlfqs || t->priority <= t->init_priority))
+		return &sched_fair_class;
+	return &sched_prio_class;
+}
+
+/* T를 RQ에 넣습니다.  RQ의 락을 잡은 상태에서 호출해야 합니다. */
+void
+sched_enqueue (struct runqueue *rq, struct thread *t) {
+	ASSERT (spinlock_held (&rq->lock));
+	ASSERT (t->rq == NULL);
+
+	t->rq = rq;
+	t->rq_class = sched_class_of (t);
+	t->rq_class->enqueue (rq, t);
+	rq->nr_ready++;
+}
+
+/* RQ에 들어 있는 T를 꺼냅니다.
+   RQ의 락을 잡은 상태에서 호출해야 합니다. */
+void
+sched_dequeue (struct runqueue *rq, struct thread *t) {
+	ASSERT (spinlock_held (&rq->lock));
+	ASSERT (t->rq == rq);
+
+	t->rq_class->dequeue (rq, t);
+	rq->nr_ready--;
+	t->rq = NULL;
+	t->rq_class = NULL;
+}
+
+/* RQ에서 다음에 실행할 스레드를 꺼내지 않고 반환합니다.  RQ가
+   비어 있으면 NULL.  RQ의 락을 잡은 상태에서 호출해야 합니다. */
+struct thread *
+sched_pick_next (struct runqueue *rq) {
+	size_t i;
+
+	ASSERT (spinlock_held (&rq->lock));
+
+	if (rq->nr_ready == 0)
+		return NULL;
+	for (i = 0; i < SCHED_CLASS_CNT; i++) {
+		struct thread *t = sched_classes[i]->pick_next (rq);
+
+		if (t != NULL)
+			return t;
+	}
+	NOT_REACHED ();
+}
+
+/* RQ에서 FILTER (T, AUX)가 true인 스레드 중 가장 먼저 실행할 것을
+   꺼내지 않고 반환합니다.  없으면 NULL.  RQ의 락을 잡은 상태에서
+   호출해야 합니다. */
+struct thread *
+sched_pick_steal (struct runqueue *rq, sched_filter_func *filter,
+		void *aux) {
+	size_t i;
+
+	ASSERT (spinlock_held (&rq->lock));
+
+	for (i = 0; i < SCHED_CLASS_CNT && rq->nr_ready != 0; i++) {
+		struct thread *t = sched_classes[i]->pick_steal (rq, filter, aux);
+
+		if (t != NULL)
+			return t;
+	}
+	return NULL;
+}
+
+/* RQ의 CPU에서 실행 중인 CURR이 틱 하나를 썼습니다.  CURR이 이제
+   양보해야 하면 true를 반환합니다.  타이머 인터럽트에서 호출됩니다. */
+bool
+sched_tick (struct runqueue *rq, struct thread *curr) {
+	ASSERT (intr_context ());
+
+	return sched_class_of (curr)->tick (rq, curr);
+}
+
+/* RQ의 CPU에서 실행 중인 CURR을 RQ에 있는 T가 선점해야 하면 true를
+   반환합니다.  T가 NULL이면 RQ에서 다음에 실행할 스레드로 판단합니다.
+   순위가 높은 클래스의 스레드는 항상 선점하고, 같은 클래스끼리는
+   클래스가 정합니다.  RQ의 락을 잡은 상태에서 호출해야 합니다. */
+bool
+sched_preempts (struct runqueue *rq, struct thread *curr, struct thread *t) {
+	const struct sched_class *curr_class;
+
+	ASSERT (spinlock_held (&rq->lock));
+
+	if (t == NULL && (t = sched_pick_next (rq)) == NULL)
+		return false;
+	ASSERT (t->rq == rq);
+
+	/* idle 스레드는 무엇에든 양보합니다. */
+	if (curr->cpu != NULL && curr == curr->cpu->idle_thread)
+		return true;
+
+	curr_class = sched_class_of (curr);
+	if (t->rq_class != curr_class)
+		return t->rq_class->rank < curr_class->rank;
+	return curr_class->check_preempt (rq, curr, t);
+}
+
+/* T가 주기 PERIOD마다 RUNTIME 틱을, 주기 시작부터 DEADLINE 틱 안에
+   쓰는 EDF 스레드가 되도록 승인을 요청합니다.  세 값은
+   0 < RUNTIME <= DEADLINE <= PERIOD를 만족해야 합니다.  ONLY가 NULL이
+   아니면 T는 그 CPU에만 묶일 수 있습니다.
+
+   T가 이미 EDF 스레드라면 예전 대역폭을 빼고 셈하며, 묶인 CPU에 자리가
+   남으면 그대로 둡니다.  아니면 EDF 대역폭이 가장 적게 쓰인 CPU를
+   고릅니다.  승인되면 T를 그 CPU에 묶고 (t->dl_cpu) EDF 인자와 첫
+   인스턴스를 설정한 뒤 true를, 자리가 있는 CPU가 없으면 아무것도
+   바꾸지 않고 false를 반환합니다.  T는 실행 큐에 들어 있으면 안
+   됩니다.  T를 묶인 CPU로 옮기는 것은 호출자의 몫입니다. */
+bool
+sched_dl_admit (struct thread *t, int64_t runtime, int64_t deadline,
+		int64_t period, struct cpu *only) {
+	struct cpu *old_cpu = NULL, *best = NULL;
+	uint64_t bw, old_bw = 0, best_used = 0;
+	enum intr_level old_level;
+	int i;
+
+	ASSERT (t->rq == NULL);
+
+	if (runtime <= 0 || runtime > deadline || deadline > period)
+		return false;
+	bw = ((uint64_t) runtime << DL_BW_SHIFT) / period;
+	if (t->policy == SCHED_DEADLINE) {
+		old_cpu = t->dl_cpu;
+		old_bw = ((uint64_t) t->dl_runtime << DL_BW_SHIFT) / t->dl_period;
+	}
+
+	old_level = intr_disable ();
+	spinlock_acquire (&dl_bw_lock);
+	if (old_cpu != NULL && (only == NULL || only == old_cpu)
+			&& old_cpu->rq.dl_bw - old_bw + bw <= DL_BW_MAX)
+		best = old_cpu;
+	else
+		for (i = 0; i < cpu_cnt; i++) {
+			struct cpu *c = &cpus[i];
+			uint64_t used = c->rq.dl_bw - (c == old_cpu ? old_bw : 0);
+
+			if ((only == NULL || only == c) && used + bw <= DL_BW_MAX
+					&& (best == NULL || used < best_used)) {
+				best = c;
+				best_used = used;
+			}
+		}
+	if (best != NULL) {
+		if (old_cpu != NULL)
+			old_cpu->rq.dl_bw -= old_bw;
+		best->rq.dl_bw += bw;
+		dl_admitted++;
+	} else
+		dl_rejected++;
+	spinlock_release (&dl_bw_lock);
+
+	if (best != NULL) {
+		t->dl_cpu = best;
+		t->dl_runtime = runtime;
+		t->dl_deadline = deadline;
+		t->dl_period = period;
+		t->dl_wakeup = 0;
+		dl_replenish (t, timer_ticks ());
+	}
+	intr_set_level (old_level);
+	return best != NULL;
+}
+
+/* EDF 스레드 T가 EDF 클래스를 떠나거나 종료합니다.  T가 묶인 CPU에
+   대역폭을 돌려주고 T를 풀어 줍니다.  T가 EDF 스레드가 아니면 아무
+   일도 하지 않습니다. */
+void
+sched_dl_release (struct thread *t) {
+	enum intr_level old_level;
+
+	if (t->policy != SCHED_DEADLINE)
+		return;
+
+	old_level = intr_disable ();
+	spinlock_acquire (&dl_bw_lock);
+	t->dl_cpu->rq.dl_bw -=
+		((uint64_t) t->dl_runtime << DL_BW_SHIFT) / t->dl_period;
+	t->dl_cpu = NULL;
+	spinlock_release (&dl_bw_lock);
+	intr_set_level (old_level);
+}
+
+/* 스케줄러 통계를 출력합니다.  EDF를 쓴 적이 없으면 아무것도
+   출력하지 않습니다. */
+void
+sched_print_stats (void) {
+	long long misses = 0;
+	int i;
+
+	if (dl_admitted == 0 && dl_rejected == 0)
+		return;
+	for (i = 0; i < cpu_cnt; i++)
+		misses += cpus[i].dl_misses;
+	printf ("EDF: %lld admitted, %lld rejected, %lld deadline misses\n",
+			dl_admitted, dl_rejected, misses);
+}
+
+/* EDF 클래스. */
+
+/* 힙 비교 함수: A 스레드의 절대 마감이 B보다 늦으면 true.  힙의
+   꼭대기에는 마감이 가장 이른 스레드가 옵니다. */
+static bool
+dl_less (const struct heap_elem *a, const struct heap_elem *b,
+		void *aux UNUSED) {
+	return heap_entry (a, struct thread, dl_elem)->dl_abs_deadline
+		> heap_entry (b, struct thread, dl_elem)->dl_abs_deadline;
+}
+
+/* T에게 NOW부터 시작하는 새 인스턴스를 줍니다. */
+static void
+dl_replenish (struct thread *t, int64_t now) {
+	t->dl_abs_deadline = now + t->dl_deadline;
+	t->dl_remaining = t->dl_runtime;
+	t->dl_missed = false;
+}
+
+/* 깨어났거나 예산을 다시 받은 T를 RQ의 힙에 넣습니다.
+
+   CBS 규칙에 따라, 마감이 지났거나 남은 예산을 마감까지 쓰면
+   대역폭을 넘게 되는 스레드는 지금부터 새 인스턴스를 시작합니다.
+   그렇지 않으면 원래 마감과 남은 예산을 그대로 씁니다. */
+static void
+dl_enqueue (struct runqueue *rq, struct thread *t) {
+	int64_t now = timer_ticks ();
+
+	t->dl_wakeup = 0;
+	if (now >= t->dl_abs_deadline
+			|| t->dl_remaining * t->dl_deadline
+			> (t->dl_abs_deadline - now) * t->dl_runtime)
+		dl_replenish (t, now);
+	heap_push (&rq->dl_heap, &t->dl_elem);
+}
+
+static void
+dl_dequeue (struct runqueue *rq, struct thread *t) {
+	heap_remove (&rq->dl_heap, &t->dl_elem);
+}
+
+/* 마감이 가장 이른 스레드.  힙의 꼭대기이므로 O(1). */
+static struct thread *
+dl_pick_next (struct runqueue *rq) {
+	struct heap_elem *top = heap_top (&rq->dl_heap);
+
+	return top != NULL ? heap_entry (top, struct thread, dl_elem) : NULL;
+}
+
+/* 힙은 순서대로 훑을 수 없으므로 꼭대기만 봅니다.  꼭대기를 가져갈
+   수 없으면 이 큐의 EDF 스레드는 훔치지 않고 다른 클래스로 넘어갑니다. */
+static struct thread *
+dl_pick_steal (struct runqueue *rq, sched_filter_func *filter,
+		void *aux) {
+	struct heap_elem *top = heap_top (&rq->dl_heap);
+	struct thread *t;
+
+	if (top == NULL)
+		return NULL;
+	t = heap_entry (top, struct thread, dl_elem);
+	return filter (t, aux) ? t : NULL;
+}
+
+/* CURR이 틱 하나를 썼습니다.  마감이 지나도록 실행 중이면 마감을
+   놓친 것으로 셉니다 (인스턴스마다 한 번).  예산을 다 썼으면 다음
+   주기가 시작될 때까지 잠들도록 dl_wakeup을 정하고 양보합니다.
+   thread_yield()가 dl_wakeup을 보고 재웁니다. */
+static bool
+dl_tick (struct runqueue *rq UNUSED, struct thread *curr) {
+	int64_t now = timer_ticks ();
+	int64_t next_period;
+
+	if (!curr->dl_missed && now >= curr->dl_abs_deadline) {
+		curr->dl_missed = true;
+		curr->cpu->dl_misses++;
+	}
+	if (--curr->dl_remaining > 0)
+		return false;
+
+	next_period = curr->dl_abs_deadline - curr->dl_deadline + curr->dl_period;
+	if (next_period > now)
+		curr->dl_wakeup = next_period;
+	else
+		dl_replenish (curr, now);
+	return true;
+}
+
+static bool
+dl_check_preempt (struct runqueue *rq UNUSED, struct thread *curr,
+		struct thread *t) {
+	return t->dl_abs_deadline < curr->dl_abs_deadline;
+}
+
+const struct sched_class sched_dl_class = {
+	.name = "deadline",
+	.rank = 0,
+	.enqueue = dl_enqueue,
+	.dequeue = dl_dequeue,
+	.pick_next = dl_pick_next,
+	.pick_steal = dl_pick_steal,
+	.tick = dl_tick,
+	.check_preempt = dl_check_preempt,
+};
+
+/* 우선순위 클래스. */
+
+/* T를 RQ의 자기 우선순위 큐 맨 뒤에 넣습니다.  같은 우선순위끼리는
+   들어온 순서대로 실행되므로 라운드 로빈 순서가 유지됩니다. */
+static void
+prio_enqueue (struct runqueue *rq, struct thread *t) {
+	ASSERT (PRI_MIN <= t->priority && t->priority <= PRI_MAX);
+
+	t->rq_priority = t->priority;
+	list_push_back (&rq->queues[t->rq_priority], &t->elem);
+	rq->mask |= 1ULL << t->rq_priority;
+}
+
+static void
+prio_dequeue (struct runqueue *rq, struct thread *t) {
+	list_remove (&t->elem);
+	if (list_empty (&rq->queues[t->rq_priority]))
+		rq->mask &= ~(1ULL << t->rq_priority);
+}
+
+/* 가장 높은 우선순위 큐의 맨 앞 스레드.  비트마스크 덕분에 O(1). */
+static struct thread *
+prio_pick_next (struct runqueue *rq) {
+	int priority;
+
+	if (rq->mask == 0)
+		return NULL;
+	priority = 63 - __builtin_clzll (rq->mask);
+	return list_entry (list_front (&rq->queues[priority]),
+			struct thread, elem);
+}
+
+static struct thread *
+prio_pick_steal (struct runqueue *rq, sched_filter_func *filter,
+		void *aux) {
+	uint64_t mask;
+
+	for (mask = rq->mask; mask != 0; ) {
+		int priority = 63 - __builtin_clzll (mask);
+		struct list_elem *e;
+
+		mask &= ~(1ULL << priority);
+		for (e = list_begin (&rq->queues[priority]);
+				e != list_end (&rq->queues[priority]); e = list_next (e)) {
+			struct thread *t = list_entry (e, struct thread, elem);
+
+			if (filter (t, aux))
+				return t;
+		}
+	}
+	return NULL;
+}
+
+/* 같은 우선순위끼리 돌아가도록 TIME_SLICE 틱마다 양보합니다. */
+static bool
+prio_tick (struct runqueue *rq UNUSED, struct thread *curr) {
+	return ++curr->cpu->thread_ticks >= TIME_SLICE;
+}
+
+static bool
+prio_check_preempt (struct runqueue *rq UNUSED, struct thread *curr,
+		struct thread *t) {
+	return t->priority > curr->priority;
+}
+
+const struct sched_class sched_prio_class = {
+	.name = "prio",
+	.rank = 1,
+	.enqueue = prio_enqueue,
+	.dequeue = prio_dequeue,
+	.pick_next = prio_pick_next,
+	.pick_steal = prio_pick_steal,
+	.tick = prio_tick,
+	.check_preempt = prio_check_preempt,
+};
+
+/* 공정 클래스. */
+
+/* vruntime A가 B보다 앞서면 true.  값이 한 바퀴 돌아도 맞도록
+   차이의 부호로 비교합니다. */
+static inline bool
+vruntime_before (uint64_t a, uint64_t b) {
+	return (int64_t) (a - b) < 0;
+}
+
+/* 트리 비교 함수: A 스레드의 vruntime이 B보다 작으면 true. */
+static bool
+fair_less (const struct rb_node *a, const struct rb_node *b,
+		void *aux UNUSED) {
+	return vruntime_before (rb_entry (a, struct thread, fair_node)->vruntime,
+			rb_entry (b, struct thread, fair_node)->vruntime);
+}
+
+/* T의 nice에 대응하는 가중치. */
+static unsigned long
+fair_weight (const struct thread *t) {
+	ASSERT (NICE_MIN <= t->nice && t->nice <= NICE_MAX);
+	return fair_weights[t->nice - NICE_MIN];
+}
+
+/* T의 vruntime을 RQ 기준으로 옮깁니다.  실행 큐마다 min_vruntime이
+   따로 흘러가므로, 다른 CPU에서 온 스레드는 그 CPU의 min_vruntime에
+   대한 차이를 그대로 가져옵니다.  공정 클래스에 처음 들어온 스레드는
+   min_vruntime에서 시작합니다.  T는 트리에 들어 있으면 안 됩니다. */
+static void
+fair_rebase (struct runqueue *rq, struct thread *t) {
+	struct runqueue *old = t->vruntime_rq;
+
+	if (old == rq)
+		return;
+	if (old == NULL)
+		t->vruntime = rq->min_vruntime;
+	else
+		t->vruntime = t->vruntime - old->min_vruntime + rq->min_vruntime;
+	t->vruntime_rq = rq;
+}
+
+/* RQ의 min_vruntime을 실행 중인 CURR과 트리의 가장 작은 vruntime 중
+   작은 쪽까지 올립니다.  min_vruntime은 줄어들지 않습니다. */
+static void
+fair_update_min (struct runqueue *rq, const struct thread *curr) {
+	struct rb_node *first = rb_first (&rq->fair_tree);
+	uint64_t vruntime = curr->vruntime;
+
+	if (first != NULL) {
+		uint64_t v = rb_entry (first, struct thread, fair_node)->vruntime;
+
+		if (vruntime_before (v, vruntime))
+			vruntime = v;
+	}
+	if (vruntime_before (rq->min_vruntime, vruntime))
+		rq->min_vruntime = vruntime;
+}
+
+/* RQ에서 CURR이 한 번에 실행할 틱 수.  한 주기를 CURR과 트리에 든
+   스레드들의 가중치 비율대로 나눈 몫입니다. */
+static unsigned
+fair_slice (const struct runqueue *rq, const struct thread *curr) {
+	unsigned long weight = fair_weight (curr);
+	uint64_t nr = rb_size (&rq->fair_tree) + 1;
+	uint64_t period = FAIR_LATENCY;
+	uint64_t slice;
+
+	if (nr * FAIR_MIN_SLICE > period)
+		period = nr * FAIR_MIN_SLICE;
+	slice = period * weight / (rq->fair_load + weight);
+	return slice > FAIR_MIN_SLICE ? slice : FAIR_MIN_SLICE;
+}
+
+/* T를 RQ의 트리에 넣습니다.  오래 잠들어 있던 스레드는 vruntime이
+   크게 뒤처져 있으므로 min_vruntime에서 반 주기 앞까지만 인정합니다.
+   그래야 깨어난 스레드가 곧바로 실행되면서도 CPU를 독차지하지
+   않습니다. */
+static void
+fair_enqueue (struct runqueue *rq, struct thread *t) {
+	uint64_t floor;
+
+	fair_rebase (rq, t);
+	floor = rq->min_vruntime - FAIR_LATENCY * FAIR_TICK / 2;
+	if (vruntime_before (t->vruntime, floor))
+		t->vruntime = floor;
+
+	rb_insert (&rq->fair_tree, &t->fair_node);
+	rq->fair_load += fair_weight (t);
+}
+
+static void
+fair_dequeue (struct runqueue *rq, struct thread *t) {
+	rb_remove (&rq->fair_tree, &t->fair_node);
+	rq->fair_load -= fair_weight (t);
+}
+
+/* vruntime이 가장 작은 스레드.  트리가 캐시해 두므로 O(1). */
+static struct thread *
+fair_pick_next (struct runqueue *rq) {
+	struct rb_node *first = rb_first (&rq->fair_tree);
+
+	return first != NULL ? rb_entry (first, struct thread, fair_node) : NULL;
+}
+
+static struct thread *
+fair_pick_steal (struct runqueue *rq, sched_filter_func *filter,
+		void *aux) {
+	struct rb_node *n;
+
+	for (n = rb_first (&rq->fair_tree); n != NULL; n = rb_next (n)) {
+		struct thread *t = rb_entry (n, struct thread, fair_node);
+
+		if (filter (t, aux))
+			return t;
+	}
+	return NULL;
+}
+
+/* CURR의 vruntime에 가중치로 나눈 틱 하나를 더하고, 몫을 다 썼고
+   기다리는 공정 클래스 스레드가 있으면 양보합니다. */
+static bool
+fair_tick (struct runqueue *rq, struct thread *curr) {
+	unsigned ran = ++curr->cpu->thread_ticks;
+	bool resched;
+
+	spinlock_acquire (&rq->lock);
+	fair_rebase (rq, curr);
+	curr->vruntime += FAIR_TICK * FAIR_WEIGHT_0 / fair_weight (curr);
+	fair_update_min (rq, curr);
+	resched = !rb_empty (&rq->fair_tree) && ran >= fair_slice (rq, curr);
+	spinlock_release (&rq->lock);
+
+	return resched;
+}
+
+static bool
+fair_check_preempt (struct runqueue *rq UNUSED, struct thread *curr,
+		struct thread *t) {
+	return vruntime_before (t->vruntime + FAIR_WAKEUP_GRAN, curr->vruntime);
+}
+
+const struct sched_class sched_fair_class = {
+	.name = "fair",
+	.rank = 2,
+	.enqueue = fair_enqueue,
+	.dequeue = fair_dequeue,
+	.pick_next = fair_pick_next,
+	.pick_steal = fair_pick_steal,
+	.tick = fair_tick,
+	.check_preempt = fair_check_preempt,
+};
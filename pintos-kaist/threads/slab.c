@@ -0,0 +1,280 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include <string.h>
+#include "threads/cpu.h"
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* 슬랩 할당자입니다 (slab.h).
+
+   슬랩은 커널 풀의 페이지 하나이고, 맨 앞에 struct slab이 있고 그
+   뒤에 객체들이 obj_size 간격으로 놓입니다.  해제된 객체들은 각자
+   link_ofs 위치에 다음 객체의 주소를 적어 슬랩의 free 리스트로
+   이어집니다.  생성자가 없으면 link_ofs는 0이라 객체의 첫 워드를
+   쓰고, 있으면 생성된 내용을 지키도록 객체 뒤에 워드 하나를 덧붙여
+   씁니다.
+
+   새 슬랩은 객체들을 리스트로 엮어 두지 않습니다.  아직 한 번도 내준
+   적 없는 객체는 carved부터 순서대로 잘라 주므로, 슬랩을 만드는
+   비용이 객체 수에 비례하지 않습니다.
+
+   슬랩은 쓰는 객체 수에 따라 partial, full, empty 리스트 중 하나에
+   있습니다.  할당은 partial, empty 순으로 슬랩을 고르고, 빈 슬랩이
+   KMEM_EMPTY_MAX개를 넘으면 페이지를 palloc에 돌려줍니다.
+
+   매거진은 인터럽트를 끈 채로 현재 CPU의 것만 만지므로 락이
+   필요 없습니다.  가득 찬 매거진에 해제하면 절반을 한 번에
+   슬랩으로 돌려보냅니다. */
+
+/* 캐시마다 남겨 두는 빈 슬랩의 수. */
+#define KMEM_EMPTY_MAX 1
+
+/* struct slab의 magic 값.  잘못된 포인터를 잡는 데 씁니다. */
+#define SLAB_MAGIC 0x51ab51ab
+
+/* 슬랩 페이지의 머리. */
+struct slab {
+	unsigned magic;                 /* SLAB_MAGIC. */
+	struct kmem_cache *cache;       /* 주인 캐시. */
+	struct list_elem elem;          /* 캐시의 슬랩 리스트 원소. */
+	void *free;                     /* 해제된 객체 리스트. */
+	size_t inuse;                   /* 내준 객체 수. */
+	size_t carved;                  /* 한 번이라도 잘라 준 객체 수. */
+};
+
+static void *slab_alloc (struct kmem_cache *);
+static void slab_free (struct kmem_cache *, void *obj);
+
+/* 첫 객체가 놓이는 슬랩 안의 위치. */
+static size_t
+first_ofs (void) {
+	return ROUND_UP (sizeof (struct slab), sizeof (void *));
+}
+
+/* 해제된 객체 OBJ 안의 다음 포인터. */
+static void **
+obj_link (struct kmem_cache *c, void *obj) {
+	return (void **) ((uint8_t *) obj + c->link_ofs);
+}
+
+/* OBJ가 들어 있는 슬랩을 반환합니다. */
+static struct slab *
+obj_to_slab (struct kmem_cache *c, void *obj) {
+	struct slab *s = pg_round_down (obj);
+
+	ASSERT (s->magic == SLAB_MAGIC);
+	ASSERT (s->cache == c);
+	ASSERT ((pg_ofs (obj) - first_ofs ()) % c->obj_size == 0);
+	return s;
+}
+
+/* 캐시 C를 NAME이라는 이름으로, SIZE 바이트짜리 객체의 캐시로
+   초기화합니다.  CTOR이 NULL이 아니면 객체를 처음 잘라 낼 때
+   부릅니다.  FLAGS에 KMEM_MAGAZINE이 있으면 CPU별 매거진을 씁니다.
+   malloc_init() 뒤에 불러야 합니다. */
+void
+kmem_cache_init (struct kmem_cache *c, const char *name, size_t size,
+		kmem_ctor *ctor, unsigned flags) {
+	ASSERT (c != NULL);
+	ASSERT (size > 0);
+
+	c->name = name;
+	c->size = size;
+	c->ctor = ctor;
+	if (ctor != NULL) {
+		c->link_ofs = ROUND_UP (size, sizeof (void *));
+		c->obj_size = c->link_ofs + sizeof (void *);
+	} else {
+		c->link_ofs = 0;
+		c->obj_size = ROUND_UP (size, sizeof (void *));
+	}
+	ASSERT (c->obj_size <= PGSIZE - first_ofs ());
+	c->objs_per_slab = (PGSIZE - first_ofs ()) / c->obj_size;
+
+	lock_init_named (&c->lock, name);
+	list_init (&c->partial);
+	list_init (&c->full);
+	list_init (&c->empty);
+	c->empty_cnt = 0;
+
+	c->mags = NULL;
+	if (flags & KMEM_MAGAZINE) {
+		c->mags = calloc (CPU_MAX, sizeof *c->mags);
+		if (c->mags == NULL)
+			PANIC ("kmem_cache_init: out of memory for %s magazines", name);
+	}
+}
+
+/* 캐시 C에서 객체 하나를 받아 반환합니다.  메모리가 없으면 NULL을
+   반환합니다.  인터럽트 컨텍스트에서 부르면 안 됩니다. */
+void *
+kmem_cache_alloc (struct kmem_cache *c) {
+	void *obj = NULL;
+
+	ASSERT (!intr_context ());
+
+	if (c->mags != NULL) {
+		enum intr_level old_level = intr_disable ();
+		struct kmem_magazine *m = &c->mags[this_cpu ()->id];
+
+		if (m->cnt > 0)
+			obj = m->objs[--m->cnt];
+		intr_set_level (old_level);
+		if (obj != NULL)
+			return obj;
+	}
+
+	lock_acquire (&c->lock);
+	obj = slab_alloc (c);
+	lock_release (&c->lock);
+	return obj;
+}
+
+/* kmem_cache_alloc()으로 C에서 받은 객체 OBJ를 돌려줍니다.
+   생성자가 있는 캐시라면 OBJ는 생성된 상태여야 합니다. */
+void
+kmem_cache_free (struct kmem_cache *c, void *obj) {
+	void *flush[KMEM_MAG_SIZE / 2];
+	size_t flush_cnt = 0;
+	size_t i;
+
+	ASSERT (!intr_context ());
+	if (obj == NULL)
+		return;
+	obj_to_slab (c, obj);
+
+#ifndef NDEBUG
+	/* 해제한 뒤에 쓰는 버그를 잡기 쉽도록 지웁니다. */
+	if (c->ctor == NULL)
+		memset (obj, 0xcc, c->size);
+#endif
+
+	if (c->mags != NULL) {
+		enum intr_level old_level = intr_disable ();
+		struct kmem_magazine *m = &c->mags[this_cpu ()->id];
+
+		/* 가득 찼으면 절반을 덜어 내 슬랩으로 보냅니다. */
+		if (m->cnt == KMEM_MAG_SIZE)
+			while (flush_cnt < KMEM_MAG_SIZE / 2)
+				flush[flush_cnt++] = m->objs[--m->cnt];
+		m->objs[m->cnt++] = obj;
+		intr_set_level (old_level);
+		if (flush_cnt == 0)
+			return;
+	} else
+		flush[flush_cnt++] = obj;
+
+	lock_acquire (&c->lock);
+	for (i = 0; i < flush_cnt; i++)
+		slab_free (c, flush[i]);
+	lock_release (&c->lock);
+}
+
+/* 매거진에 든 객체들을 슬랩으로 돌려보내고, 빈 슬랩을 모두
+   palloc에 돌려줍니다. */
+void
+kmem_cache_shrink (struct kmem_cache *c) {
+	int i;
+
+	ASSERT (!intr_context ());
+
+	if (c->mags != NULL) {
+		for (i = 0; i < CPU_MAX; i++) {
+			struct kmem_magazine *m = &c->mags[i];
+			void *objs[KMEM_MAG_SIZE];
+			size_t cnt;
+			enum intr_level old_level;
+
+			old_level = intr_disable ();
+			cnt = m->cnt;
+			memcpy (objs, m->objs, cnt * sizeof *objs);
+			m->cnt = 0;
+			intr_set_level (old_level);
+
+			lock_acquire (&c->lock);
+			while (cnt > 0)
+				slab_free (c, objs[--cnt]);
+			lock_release (&c->lock);
+		}
+	}
+
+	lock_acquire (&c->lock);
+	while (!list_empty (&c->empty)) {
+		struct slab *s = list_entry (list_pop_front (&c->empty),
+				struct slab, elem);
+		c->empty_cnt--;
+		palloc_free_page (s);
+	}
+	lock_release (&c->lock);
+}
+
+/* C의 슬랩에서 객체 하나를 떼어 반환합니다.  C의 락을 잡고
+   불러야 합니다. */
+static void *
+slab_alloc (struct kmem_cache *c) {
+	struct slab *s;
+	void *obj;
+
+	if (!list_empty (&c->partial))
+		s = list_entry (list_front (&c->partial), struct slab, elem);
+	else if (!list_empty (&c->empty)) {
+		s = list_entry (list_front (&c->empty), struct slab, elem);
+		list_remove (&s->elem);
+		list_push_front (&c->partial, &s->elem);
+		c->empty_cnt--;
+	} else {
+		s = palloc_get_page (0);
+		if (s == NULL)
+			return NULL;
+		s->magic = SLAB_MAGIC;
+		s->cache = c;
+		s->free = NULL;
+		s->inuse = 0;
+		s->carved = 0;
+		list_push_front (&c->partial, &s->elem);
+	}
+
+	if (s->free != NULL) {
+		obj = s->free;
+		s->free = *obj_link (c, obj);
+	} else {
+		ASSERT (s->carved < c->objs_per_slab);
+		obj = (uint8_t *) s + first_ofs () + c->obj_size * s->carved++;
+		if (c->ctor != NULL)
+			c->ctor (obj);
+	}
+
+	if (++s->inuse == c->objs_per_slab) {
+		list_remove (&s->elem);
+		list_push_front (&c->full, &s->elem);
+	}
+	return obj;
+}
+
+/* OBJ를 자기 슬랩에 돌려줍니다.  C의 락을 잡고 불러야 합니다. */
+static void
+slab_free (struct kmem_cache *c, void *obj) {
+	struct slab *s = obj_to_slab (c, obj);
+
+	ASSERT (s->inuse > 0);
+
+	*obj_link (c, obj) = s->free;
+	s->free = obj;
+
+	if (s->inuse-- == c->objs_per_slab) {
+		list_remove (&s->elem);
+		list_push_front (&c->partial, &s->elem);
+	}
+	if (s->inuse == 0) {
+		list_remove (&s->elem);
+		if (c->empty_cnt < KMEM_EMPTY_MAX) {
+			list_push_front (&c->empty, &s->elem);
+			c->empty_cnt++;
+		} else
+			palloc_free_page (s);
+	}
+}
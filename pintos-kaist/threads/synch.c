@@ -29,8 +29,209 @@
 #include "threads/synch.h"
 #include <stdio.h>
 #include <string.h>
+#include "intrinsic.h"
+#include "threads/cpu.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "devices/timer.h"
+
+/* 우선순위 기부 상태를 보호하는 스핀락.  synch.h를 참조하세요. */
+struct spinlock donation_lock;
+
+static void lock_waiter_cancel (struct lock *, struct thread *);
+
+#ifdef LOCKSTAT
+/* Statistics of every named lock, newest first.  Named locks
+   are never unregistered, so they must live until power-off. */
+static struct lock_stat *lockstat_list;
+
+static void lockstat_acquired (struct lock *);
+static void lockstat_released (struct lock *);
+static void lockstat_waited (struct lock *, uint64_t cycles);
+static void lockstat_donated (struct lock *, int chain);
+#else
+#define lockstat_acquired(LOCK) ((void) 0)
+#define lockstat_released(LOCK) ((void) 0)
+#define lockstat_waited(LOCK, CYCLES) ((void) 0)
+#define lockstat_donated(LOCK, CHAIN) ((void) 0)
+#endif
+
+/* Initializes spinlock SL as unlocked. */
+void
+spinlock_init (struct spinlock *sl) {
+	ASSERT (sl != NULL);
+
+	sl->locked = 0;
+	sl->cpu = NULL;
+}
+
+/* Acquires SL, spinning until it becomes available.  Interrupts
+   must be off, so that an interrupt handler on this CPU cannot
+   try to take SL while we hold it, and SL must not already be
+   held by this CPU.
+
+   The inner loop only reads the lock word, so waiting CPUs do
+   not keep stealing the cache line from the holder; the `pause'
+   hint tells the CPU that this is a spin-wait loop. */
+void
+spinlock_acquire (struct spinlock *sl) {
+	ASSERT (sl != NULL);
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (!spinlock_held (sl));
+
+	while (__atomic_exchange_n (&sl->locked, 1, __ATOMIC_ACQUIRE))
+		while (sl->locked)
+			asm volatile ("pause" : : : "memory");
+	sl->cpu = this_cpu ();
+}
+
+/* Tries to acquire SL and returns true if successful or false
+   on failure.  Never spins.  Interrupts must be off. */
+bool
+spinlock_try_acquire (struct spinlock *sl) {
+	ASSERT (sl != NULL);
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (sl->locked || __atomic_exchange_n (&sl->locked, 1, __ATOMIC_ACQUIRE))
+		return false;
+	sl->cpu = this_cpu ();
+	return true;
+}
+
+/* Releases SL, which must be held by this CPU. */
+void
+spinlock_release (struct spinlock *sl) {
+	ASSERT (spinlock_held (sl));
+
+	sl->cpu = NULL;
+	__atomic_store_n (&sl->locked, 0, __ATOMIC_RELEASE);
+}
+
+/* Returns true if this CPU holds SL, false otherwise. */
+bool
+spinlock_held (const struct spinlock *sl) {
+	ASSERT (sl != NULL);
+
+	return sl->locked && sl->cpu == this_cpu ();
+}
+
+/* Initializes wait queue WQ as empty. */
+void
+waitq_init (struct waitq *wq) {
+	ASSERT (wq != NULL);
+
+	heap_init (&wq->exclusive, thread_priority_less, NULL);
+	heap_init (&wq->shared, thread_priority_less, NULL);
+	spinlock_init (&wq->lock);
+}
+
+/* Returns true if no thread waits on WQ.  WQ->lock must be
+   held. */
+bool
+waitq_empty (const struct waitq *wq) {
+	ASSERT (spinlock_held (&wq->lock));
+
+	return heap_empty (&wq->exclusive) && heap_empty (&wq->shared);
+}
+
+/* Puts the current thread on WQ, as an exclusive waiter if
+   EXCLUSIVE is true, but does not sleep yet; waitq_block() does.
+   WQ->lock must be held.
+
+   The caller may drop WQ->lock in between, for example to
+   release a monitor lock as cond_wait() does.  A wakeup that
+   comes in the meantime is remembered, and waitq_block() then
+   returns without sleeping. */
+void
+waitq_add (struct waitq *wq, bool exclusive) {
+	struct thread *cur = thread_current ();
+	struct heap *h = exclusive ? &wq->exclusive : &wq->shared;
+
+	ASSERT (spinlock_held (&wq->lock));
+
+	cur->wait_woken = false;
+	spinlock_acquire (&donation_lock);
+	heap_push (h, &cur->wait_elem);
+	cur->wait_heap = h;
+	spinlock_release (&donation_lock);
+}
+
+/* Sleeps until waitq_wake() picks the current thread, which
+   waitq_add() must have put on WQ, and returns true.  If
+   DEADLINE is nonzero and timer tick DEADLINE comes first,
+   takes the thread off WQ and returns false instead.  WQ->lock
+   must be held, and is held again on return.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler.  Interrupts must be off. */
+bool
+waitq_block (struct waitq *wq, int64_t deadline) {
+	struct thread *cur = thread_current ();
+
+	ASSERT (!intr_context ());
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (spinlock_held (&wq->lock));
+
+	while (!cur->wait_woken) {
+		bool timed_out = false;
+
+		cur->wait_asleep = true;
+		if (deadline == 0)
+			thread_block_locked (&wq->lock);
+		else
+			timed_out = thread_block_timeout (&wq->lock, deadline);
+		cur->wait_asleep = false;
+
+		/* 타임아웃과 같은 때 깨웠다면 깨운 쪽을 따릅니다. */
+		if (timed_out && !cur->wait_woken) {
+			spinlock_acquire (&donation_lock);
+			heap_remove (cur->wait_heap, &cur->wait_elem);
+			cur->wait_heap = NULL;
+			spinlock_release (&donation_lock);
+			return false;
+		}
+	}
+	return true;
+}
+
+/* Takes the highest priority thread off H and marks it woken.
+   If it is already asleep, appends it to WOKEN for the caller to
+   unblock. */
+static void
+waitq_wake_top (struct heap *h, struct list *woken) {
+	struct thread *t = heap_entry (heap_pop (h), struct thread, wait_elem);
+
+	t->wait_heap = NULL;
+	t->wait_woken = true;
+	if (t->wait_asleep && thread_claim_wakeup (t))
+		list_push_back (woken, &t->elem);
+}
+
+/* Wakes every shared waiter on WQ and the NR_EXCLUSIVE highest
+   priority exclusive waiters, or all of them for WAITQ_ALL.
+   Returns the number of threads woken.  WQ->lock must be held.
+
+   The threads that were asleep are appended to WOKEN rather
+   than unblocked one by one; after dropping WQ->lock the caller
+   passes WOKEN to thread_unblock_list() and then decides on
+   preemption once, with thread_preemption(). */
+size_t
+waitq_wake (struct waitq *wq, size_t nr_exclusive, struct list *woken) {
+	size_t cnt = 0;
+
+	ASSERT (spinlock_held (&wq->lock));
+	ASSERT (woken != NULL);
+
+	spinlock_acquire (&donation_lock);
+	for (; !heap_empty (&wq->shared); cnt++)
+		waitq_wake_top (&wq->shared, woken);
+	for (; nr_exclusive > 0 && !heap_empty (&wq->exclusive); nr_exclusive--) {
+		waitq_wake_top (&wq->exclusive, woken);
+		cnt++;
+	}
+	spinlock_release (&donation_lock);
+	return cnt;
+}
 
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
@@ -46,7 +247,7 @@ sema_init (struct semaphore *sema, unsigned value) {
 	ASSERT (sema != NULL);
 
 	sema->value = value;
-	list_init (&sema->waiters);
+	waitq_init (&sema->waiters);
 }
 
 /* Down or "P" operation on a semaphore.  Waits for SEMA's value
@@ -65,15 +266,50 @@ sema_down (struct semaphore *sema) {
 	ASSERT (!intr_context ());
 
 	old_level = intr_disable ();
+	spinlock_acquire (&sema->waiters.lock);
 	while (sema->value == 0) {
-		list_insert_ordered(&sema->waiters, &thread_current()->elem, compare_thread_priority, NULL );
-		donate_priority_thread(thread_current());
-		thread_block ();
+		waitq_add (&sema->waiters, true);
+		waitq_block (&sema->waiters, 0);
 	}
 	sema->value--;
+	spinlock_release (&sema->waiters.lock);
 	intr_set_level (old_level);
+}
+
+/* Like sema_down(), but gives up once TICKS timer ticks have
+   passed.  Returns true if SEMA was decremented, false if the
+   timeout came first.  With TICKS <= 0 this is sema_try_down().
+
+   The thread waits on SEMA's wait queue and on the sleep timer
+   wheel at once, and thread_block_timeout() lets whichever of
+   sema_up() and the timeout comes first wake it. */
+bool
+sema_down_timeout (struct semaphore *sema, int64_t ticks) {
+	enum intr_level old_level;
+	int64_t deadline;
+	bool timed_out = false;
+	bool success;
 
+	ASSERT (sema != NULL);
+	ASSERT (!intr_context ());
+
+	if (ticks <= 0)
+		return sema_try_down (sema);
+	deadline = timer_ticks () + ticks;
+
+	old_level = intr_disable ();
+	spinlock_acquire (&sema->waiters.lock);
+	while (sema->value == 0 && !timed_out) {
+		waitq_add (&sema->waiters, true);
+		timed_out = !waitq_block (&sema->waiters, deadline);
+	}
+	success = sema->value > 0;
+	if (success)
+		sema->value--;
+	spinlock_release (&sema->waiters.lock);
+	intr_set_level (old_level);
 
+	return success;
 }
 
 /* Down or "P" operation on a semaphore, but only if the
@@ -89,6 +325,7 @@ sema_try_down (struct semaphore *sema) {
 	ASSERT (sema != NULL);
 
 	old_level = intr_disable ();
+	spinlock_acquire (&sema->waiters.lock);
 	if (sema->value > 0)
 	{
 		sema->value--;
@@ -96,6 +333,7 @@ sema_try_down (struct semaphore *sema) {
 	}
 	else
 		success = false;
+	spinlock_release (&sema->waiters.lock);
 	intr_set_level (old_level);
 
 	return success;
@@ -108,20 +346,18 @@ sema_try_down (struct semaphore *sema) {
 void
 sema_up (struct semaphore *sema) {
 	enum intr_level old_level;
+	struct list woken;
 
 	ASSERT (sema != NULL);
 
+	list_init (&woken);
 	old_level = intr_disable ();
-
-	if (!list_empty (&sema->waiters)) {
-		//  waiters 리스트를 priority 순으로 정렬
-		list_sort(&sema->waiters, compare_thread_priority, NULL);
-		
-		//  우선순위 가장 높은 스레드 깨우기
-		thread_unblock (list_entry (list_pop_front (&sema->waiters), struct thread, elem));
-	}
-
+	spinlock_acquire (&sema->waiters.lock);
 	sema->value++;
+	//  우선순위 가장 높은 스레드 깨우기
+	waitq_wake (&sema->waiters, 1, &woken);
+	spinlock_release (&sema->waiters.lock);
+	thread_unblock_list (&woken);
 	intr_set_level (old_level);
 
 	//  현재보다 높은 우선순위가 깨어났다면 양보
@@ -169,55 +405,187 @@ sema_test_helper (void *sema_) {
    is, it is an error for the thread currently holding a lock to
    try to acquire that lock.
 
-   A lock is a specialization of a semaphore with an initial
-   value of 1.  The difference between a lock and such a
-   semaphore is twofold.  First, a semaphore can have a value
-   greater than 1, but a lock can only be owned by a single
-   thread at a time.  Second, a semaphore does not have an owner,
-   meaning that one thread can "down" the semaphore and then
-   another one "up" it, but with a lock the same thread must both
-   acquire and release it.  When these restrictions prove
-   onerous, it's a good sign that a semaphore should be used,
-   instead of a lock. */
+   A lock is like a semaphore with an initial value of 1, but it
+   has an owner: the same thread must both acquire and release
+   it.  The owner is kept in LOCK->holder, which doubles as the
+   lock word, so a free lock is taken and given back without
+   touching the wait list or the donation state.  When these
+   restrictions prove onerous, it's a good sign that a semaphore
+   should be used, instead of a lock. */
 void
 lock_init (struct lock *lock) {
 	ASSERT (lock != NULL);
 
 	lock->holder = NULL;
-	sema_init (&lock->semaphore, 1);
+	lock->contenders = 0;
+	waitq_init (&lock->waiters);
+	lock->donee = NULL;
+	heap_elem_init (&lock->donor_elem);
+#ifdef LOCKSTAT
+	lock->acquired_at = 0;
+	memset (&lock->stat, 0, sizeof lock->stat);
+#endif
+}
+
+/* Initializes LOCK like lock_init() and gives it NAME.  In a
+   kernel built with LOCKSTAT, the lock's contention is counted
+   and lock_print_stats() reports it under NAME, so LOCK must not
+   go away before power-off. */
+void
+lock_init_named (struct lock *lock, const char *name) {
+	ASSERT (name != NULL);
+
+	lock_init (lock);
+#ifdef LOCKSTAT
+	lock->stat.name = name;
+	lock->stat.next = __atomic_load_n (&lockstat_list, __ATOMIC_RELAXED);
+	while (!__atomic_compare_exchange_n (&lockstat_list, &lock->stat.next,
+				&lock->stat, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+		continue;
+#endif
+}
+
+/* Tries to make the current thread LOCK's holder with a single
+   compare-and-swap.  On failure, stores the thread that holds
+   LOCK into *HOLDER. */
+static inline bool
+lock_cas_holder (struct lock *lock, struct thread **holder) {
+	*holder = NULL;
+	return __atomic_compare_exchange_n (&lock->holder, holder,
+			thread_current (), false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+/* Slow path of lock_acquire(), taken when LOCK was held.
+
+   We count ourselves in LOCK->contenders before retrying the
+   CAS, and the holder reads contenders after clearing the lock
+   word, so either our retry sees the lock free or the holder
+   sees us and takes lock_release_slow().  The latter needs
+   LOCK->waiters.lock, which we keep until waitq_block() puts us
+   to sleep, so our donation is in place and we are on the wait
+   queue before the holder looks at either.
+
+   A woken thread does not own the lock; it competes for it
+   again, like a thread woken by sema_up() competes for the
+   semaphore's value.  Whoever ends up holding the lock receives
+   the donation of the threads still waiting.
+
+   If DEADLINE is nonzero we give up at timer tick DEADLINE and
+   return false, taking our donation back with us. */
+static bool
+lock_acquire_slow (struct lock *lock, int64_t deadline) {
+	struct thread *cur = thread_current ();
+	struct thread *holder;
+	enum intr_level old_level;
+	uint64_t start = rdtsc ();
+	bool blocked = false;
+	bool timed_out = false;
+	bool success;
+
+	old_level = intr_disable ();
+	spinlock_acquire (&lock->waiters.lock);
+	__atomic_add_fetch (&lock->contenders, 1, __ATOMIC_SEQ_CST);
+	while (!(success = lock_cas_holder (lock, &holder)) && !timed_out) {
+		blocked = true;
+		waitq_add (&lock->waiters, true);
+		spinlock_acquire (&donation_lock);
+		cur->wait_on_lock = lock;
+		/* MLFQS는 우선순위를 스스로 계산하므로 기부하지 않습니다. */
+		if (!thread_mlfqs)
+			lockstat_donated (lock, donate_priority (lock, holder));
+		spinlock_release (&donation_lock);
+		if (!waitq_block (&lock->waiters, deadline)) {
+			timed_out = true;
+			lock_waiter_cancel (lock, cur);
+		}
+	}
+	__atomic_sub_fetch (&lock->contenders, 1, __ATOMIC_SEQ_CST);
+	if (blocked) {
+		uint64_t now = rdtsc ();
+		uint64_t cycles = now > start ? now - start : 0;
+
+		thread_account_lock_wait (cycles);
+		lockstat_waited (lock, cycles);
+	}
+	if (success)
+		lockstat_acquired (lock);
+
+	spinlock_acquire (&donation_lock);
+	cur->wait_on_lock = NULL;
+	/* 아직 기다리는 스레드들은 이제 우리에게 기부합니다. */
+	if (success && !thread_mlfqs && !waitq_empty (&lock->waiters))
+		donate_priority (lock, cur);
+	spinlock_release (&donation_lock);
+	spinlock_release (&lock->waiters.lock);
+	intr_set_level (old_level);
+	return success;
+}
+
+/* T timed out waiting for LOCK and waitq_block() has taken it
+   off LOCK's wait queue.  Recomputes the donation LOCK makes
+   without T.  LOCK->waiters.lock must be held. */
+static void
+lock_waiter_cancel (struct lock *lock, struct thread *t) {
+	ASSERT (spinlock_held (&lock->waiters.lock));
+
+	spinlock_acquire (&donation_lock);
+	t->wait_on_lock = NULL;
+	if (!thread_mlfqs) {
+		if (waitq_empty (&lock->waiters))
+			remove_with_lock (lock);
+		else if (lock->donee != NULL)
+			donate_priority (lock, lock->donee);
+	}
+	spinlock_release (&donation_lock);
 }
 
 /* Acquires LOCK, sleeping until it becomes available if
    necessary.  The lock must not already be held by the current
    thread.
 
+   A free lock costs one compare-and-swap.  Priority donation
+   only happens in lock_acquire_slow(), when we have to wait.
+
    This function may sleep, so it must not be called within an
    interrupt handler.  This function may be called with
    interrupts disabled, but interrupts will be turned back on if
    we need to sleep. */
-/* threads/synch.c */
-/* before */
-
-void lock_acquire(struct lock *lock)
-{
-	ASSERT(lock != NULL);
-	ASSERT(!intr_context());
-	ASSERT(!lock_held_by_current_thread(lock));
-
-	/* donation priority */
-	struct thread *cur_thread = thread_current();  
-	if (lock->holder)  
-	{
-		cur_thread->wait_on_lock = lock;
-		list_insert_ordered(&lock->holder->donations, &cur_thread->donations_elem,
-							compare_thread_priority, 0);
-		donate_priority();
-	}
+void
+lock_acquire (struct lock *lock) {
+	struct thread *holder;
+
+	ASSERT (lock != NULL);
+	ASSERT (!intr_context ());
+	ASSERT (!lock_held_by_current_thread (lock));
 
-	sema_down(&lock->semaphore);
-	
-	cur_thread->wait_on_lock = NULL;  
-	lock->holder = thread_current();
+	if (lock_cas_holder (lock, &holder))
+		lockstat_acquired (lock);
+	else
+		lock_acquire_slow (lock, 0);
+}
+
+/* Like lock_acquire(), but gives up once TICKS timer ticks have
+   passed.  Returns true if the current thread now holds LOCK,
+   false if the timeout came first.  With TICKS <= 0 this is
+   lock_try_acquire().
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+bool
+lock_acquire_timeout (struct lock *lock, int64_t ticks) {
+	struct thread *holder;
+
+	ASSERT (lock != NULL);
+	ASSERT (!intr_context ());
+	ASSERT (!lock_held_by_current_thread (lock));
+
+	if (lock_cas_holder (lock, &holder)) {
+		lockstat_acquired (lock);
+		return true;
+	}
+	if (ticks <= 0)
+		return false;
+	return lock_acquire_slow (lock, timer_ticks () + ticks);
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -228,38 +596,69 @@ void lock_acquire(struct lock *lock)
    interrupt handler. */
 bool
 lock_try_acquire (struct lock *lock) {
-	bool success;
+	struct thread *holder;
 
 	ASSERT (lock != NULL);
 	ASSERT (!lock_held_by_current_thread (lock));
 
-	success = sema_try_down (&lock->semaphore);
-	if (success)
-		lock->holder = thread_current ();
-	return success;
+	if (!lock_cas_holder (lock, &holder))
+		return false;
+	lockstat_acquired (lock);
+	return true;
+}
+
+/* Slow path of lock_release(): LOCK has contenders, which may
+   have donated priority to us and may be asleep on the wait
+   queue.  Takes back their donations and wakes the highest
+   priority waiter.
+
+   LOCK->holder is already NULL, so a contender may have taken
+   LOCK and moved the donation to itself before we got
+   LOCK->waiters.lock.  The donation is then no longer ours to
+   take back, and donate_priority() has already lowered our
+   priority. */
+static void
+lock_release_slow (struct lock *lock) {
+	enum intr_level old_level;
+	struct list woken;
+
+	list_init (&woken);
+	old_level = intr_disable ();
+	spinlock_acquire (&lock->waiters.lock);
+	if (!thread_mlfqs) {
+		spinlock_acquire (&donation_lock);
+		if (lock->donee == thread_current ())
+			remove_with_lock (lock);
+		refresh_priority ();
+		spinlock_release (&donation_lock);
+	}
+	waitq_wake (&lock->waiters, 1, &woken);
+	spinlock_release (&lock->waiters.lock);
+	thread_unblock_list (&woken);
+	intr_set_level (old_level);
+
+	//  깨운 스레드나 기부가 빠져 낮아진 우선순위 때문에 양보
+	thread_preemption ();
 }
 
 /* Releases LOCK, which must be owned by the current thread.
-   This is lock_release function.
+
+   Without contenders this is a single atomic store: nobody can
+   have donated to us for LOCK, because a donor stays counted in
+   LOCK->contenders until it gets the lock.
 
    An interrupt handler cannot acquire a lock, so it does not
    make sense to try to release a lock within an interrupt
    handler. */
-/* threads/synch.c */
-/* after */
-
-
-void lock_release(struct lock *lock)
-{
-	ASSERT(lock != NULL);
-	ASSERT(lock_held_by_current_thread(lock));
-
-	/* donation priority */		
-	remove_with_lock(lock);  
-	refresh_priority();  
+void
+lock_release (struct lock *lock) {
+	ASSERT (lock != NULL);
+	ASSERT (lock_held_by_current_thread (lock));
 
-	lock->holder = NULL;
-	sema_up(&lock->semaphore);
+	lockstat_released (lock);
+	__atomic_store_n (&lock->holder, NULL, __ATOMIC_SEQ_CST);
+	if (__atomic_load_n (&lock->contenders, __ATOMIC_SEQ_CST) != 0)
+		lock_release_slow (lock);
 }
 
 /* Returns true if the current thread holds LOCK, false
@@ -269,15 +668,14 @@ bool
 lock_held_by_current_thread (const struct lock *lock) {
 	ASSERT (lock != NULL);
 
-	return lock->holder == thread_current ();
+	return __atomic_load_n (&lock->holder, __ATOMIC_RELAXED)
+		== thread_current ();
 }
 
 
-/* One semaphore in a list. */
-struct semaphore_elem {
-	struct list_elem elem;              /* List element. */
-	struct semaphore semaphore;         /* This semaphore. */
-};
+static bool cond_wait_until (struct condition *, struct lock *,
+		int64_t deadline);
+static void cond_wake (struct condition *, size_t cnt);
 
 /* Initializes condition variable COND.  A condition variable
    allows one piece of code to signal a condition and cooperating
@@ -286,7 +684,7 @@ void
 cond_init (struct condition *cond) {
 	ASSERT (cond != NULL);
 
-	list_init (&cond->waiters);
+	waitq_init (&cond->waiters);
 }
 
 /* Atomically releases LOCK and waits for COND to be signaled by
@@ -311,19 +709,56 @@ cond_init (struct condition *cond) {
    we need to sleep. */
 void
 cond_wait (struct condition *cond, struct lock *lock) {
-	struct semaphore_elem waiter;
+	cond_wait_until (cond, lock, 0);
+}
+
+/* Like cond_wait(), but stops waiting once TICKS timer ticks
+   have passed.  Returns true if COND was signaled, false if the
+   timeout came first.  Either way LOCK is held again on return.
+   With TICKS <= 0 returns false at once, without releasing
+   LOCK. */
+bool
+cond_wait_timeout (struct condition *cond, struct lock *lock, int64_t ticks) {
+	if (ticks <= 0)
+		return false;
+	return cond_wait_until (cond, lock, timer_ticks () + ticks);
+}
+
+/* Waits on COND as described for cond_wait(), giving up at
+   timer tick DEADLINE unless it is 0.  Returns true if COND was
+   signaled.
+
+   We join COND's wait queue before releasing LOCK, so a signal
+   sent as soon as LOCK is free already finds us there.  If it
+   comes before we are back under COND->waiters.lock,
+   waitq_block() sees that we were woken and does not sleep. */
+static bool
+cond_wait_until (struct condition *cond, struct lock *lock,
+		int64_t deadline) {
+	enum intr_level old_level;
+	bool signaled;
 
 	ASSERT (cond != NULL);
 	ASSERT (lock != NULL);
 	ASSERT (!intr_context ());
 	ASSERT (lock_held_by_current_thread (lock));
 
-	sema_init (&waiter.semaphore, 0);
-	list_insert_ordered(&cond->waiters, &waiter.elem, compare_sema_list_priority, 0 );
+	old_level = intr_disable ();
+	spinlock_acquire (&cond->waiters.lock);
+	waitq_add (&cond->waiters, true);
+	spinlock_release (&cond->waiters.lock);
+	intr_set_level (old_level);
+
 	lock_release (lock);
-	sema_down (&waiter.semaphore);
+
+	old_level = intr_disable ();
+	spinlock_acquire (&cond->waiters.lock);
+	signaled = waitq_block (&cond->waiters, deadline);
+	spinlock_release (&cond->waiters.lock);
+	intr_set_level (old_level);
+
 	lock_acquire (lock);
-	
+	return signaled;
 }
 
 /* If any threads are waiting on COND (protected by LOCK), then
@@ -340,17 +775,15 @@ cond_signal (struct condition *cond, struct lock *lock UNUSED) {
 	ASSERT (!intr_context ());
 	ASSERT (lock_held_by_current_thread (lock));
 
-	if (!list_empty (&cond->waiters))
-	{
-		list_sort(&cond->waiters, compare_sema_list_priority, NULL);
-		sema_up (&list_entry (list_pop_front (&cond->waiters),
-					struct semaphore_elem, elem)->semaphore);
-	}
+	cond_wake (cond, 1);
 }
 
 /* Wakes up all threads, if any, waiting on COND (protected by
    LOCK).  LOCK must be held before calling this function.
 
+   All the waiters are put on the run queues in one batch, and
+   the current thread yields at most once afterward.
+
    An interrupt handler cannot acquire a lock, so it does not
    make sense to try to signal a condition variable within an
    interrupt handler. */
@@ -358,31 +791,362 @@ void
 cond_broadcast (struct condition *cond, struct lock *lock) {
 	ASSERT (cond != NULL);
 	ASSERT (lock != NULL);
+	ASSERT (!intr_context ());
+	ASSERT (lock_held_by_current_thread (lock));
+
+	cond_wake (cond, WAITQ_ALL);
+}
+
+/* Wakes up to CNT of the threads waiting on COND, highest
+   priority first, and yields if one of them should preempt the
+   current thread. */
+static void
+cond_wake (struct condition *cond, size_t cnt) {
+	enum intr_level old_level;
+	struct list woken;
+
+	list_init (&woken);
+	old_level = intr_disable ();
+	spinlock_acquire (&cond->waiters.lock);
+	waitq_wake (&cond->waiters, cnt, &woken);
+	spinlock_release (&cond->waiters.lock);
+	thread_unblock_list (&woken);
+	intr_set_level (old_level);
+
+	thread_preemption ();
+}
+
+#ifdef LOCKSTAT
+/* Lock statistics.
+
+   Built only with LOCKSTAT defined (`make LOCKSTAT=1'), and kept
+   only for locks named with lock_init_named().  Each group of
+   counters has a single writer at a time: the holder counts
+   acquisitions and hold time, waiters count contention and wait
+   time under LOCK->waiters.lock, and donations are counted under
+   donation_lock. */
+
+/* The current thread has just acquired LOCK. */
+static void
+lockstat_acquired (struct lock *lock) {
+	if (lock->stat.name == NULL)
+		return;
+	lock->stat.acquired++;
+	lock->acquired_at = rdtsc ();
+}
+
+/* The current thread is about to release LOCK. */
+static void
+lockstat_released (struct lock *lock) {
+	uint64_t now, cycles;
+
+	if (lock->stat.name == NULL)
+		return;
+	now = rdtsc ();
+	cycles = now > lock->acquired_at ? now - lock->acquired_at : 0;
+	lock->stat.hold_cycles += cycles;
+	if (cycles > lock->stat.max_hold_cycles)
+		lock->stat.max_hold_cycles = cycles;
+}
+
+/* The current thread slept CYCLES waiting for LOCK, and may or
+   may not have got it. */
+static void
+lockstat_waited (struct lock *lock, uint64_t cycles) {
+	ASSERT (spinlock_held (&lock->waiters.lock));
+
+	if (lock->stat.name == NULL)
+		return;
+	lock->stat.contended++;
+	lock->stat.wait_cycles += cycles;
+	if (cycles > lock->stat.max_wait_cycles)
+		lock->stat.max_wait_cycles = cycles;
+}
+
+/* A waiter for LOCK donated its priority, which changed the
+   priority of CHAIN threads. */
+static void
+lockstat_donated (struct lock *lock, int chain) {
+	ASSERT (spinlock_held (&donation_lock));
+
+	if (lock->stat.name == NULL || chain == 0)
+		return;
+	lock->stat.donations++;
+	if (chain > lock->stat.max_chain)
+		lock->stat.max_chain = chain;
+}
+#endif /* LOCKSTAT */
+
+/* Prints the statistics of every named lock that was ever
+   acquired, the most contended first.  Prints nothing unless the
+   kernel was built with LOCKSTAT.  Meant for power-off, when the
+   counters no longer change; it reorders the list of named
+   locks. */
+void
+lock_print_stats (void) {
+#ifdef LOCKSTAT
+	struct lock_stat *sorted = NULL;
+	struct lock_stat *st, **p;
+
+	/* Insertion sort, most contended first. */
+	while ((st = lockstat_list) != NULL) {
+		lockstat_list = st->next;
+		for (p = &sorted; *p != NULL && (*p)->contended >= st->contended;
+				p = &(*p)->next)
+			continue;
+		st->next = *p;
+		*p = st;
+	}
+	lockstat_list = sorted;
+
+	printf ("Lock contention (cycles):\n");
+	printf ("  %-12s %9s %9s %12s %12s %12s %12s %7s %5s\n",
+			"lock", "acquired", "contended", "wait", "max wait",
+			"hold", "max hold", "donated", "chain");
+	for (st = sorted; st != NULL; st = st->next)
+		if (st->acquired > 0 || st->contended > 0)
+			printf ("  %-12s %9lu %9lu %12llu %12llu %12llu %12llu %7lu %5d\n",
+					st->name, st->acquired, st->contended,
+					(unsigned long long) st->wait_cycles,
+					(unsigned long long) st->max_wait_cycles,
+					(unsigned long long) st->hold_cycles,
+					(unsigned long long) st->max_hold_cycles,
+					st->donations, st->max_chain);
+#endif
+}
+
+/* Initializes RW as an rwlock that nobody holds. */
+void
+rwlock_init (struct rwlock *rw) {
+	ASSERT (rw != NULL);
+
+	rw->state = 0;
+	lock_init (&rw->writer);
+	lock_init (&rw->drained);
+	rw->reader = NULL;
+}
+
+/* Records the current thread, which just got RW for reading, as
+   the reader a writer waiting for RW to drain donates to. */
+static inline void
+rwlock_note_reader (struct rwlock *rw) {
+	__atomic_store_n (&rw->reader, thread_current (), __ATOMIC_SEQ_CST);
+}
+
+/* Acquires RW for reading, sleeping while a writer holds it or
+   is waiting for it.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_read_acquire (struct rwlock *rw) {
+	unsigned old;
+
+	ASSERT (rw != NULL);
+	ASSERT (!intr_context ());
+	ASSERT (!rwlock_write_held_by_current_thread (rw));
+
+	if (rwlock_read_try_acquire (rw))
+		return;
+
+	/* Queue up behind the writer, donating to it.  Once we hold
+	   RW->writer no writer is inside, but the last one may have
+	   left RW_WRITER set for the next holder of RW->writer; we are
+	   that holder, so clear it as we enter. */
+	lock_acquire (&rw->writer);
+	old = __atomic_load_n (&rw->state, __ATOMIC_RELAXED);
+	while (!__atomic_compare_exchange_n (&rw->state, &old,
+				(old & ~RW_WRITER) + RW_READER, false,
+				__ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+		continue;
+	rwlock_note_reader (rw);
+	lock_release (&rw->writer);
+}
+
+/* Tries to acquire RW for reading and returns true if
+   successful or false on failure.  Fails whenever a writer holds
+   or is waiting for RW.
+
+   This function will not sleep, so it may be called within an
+   interrupt handler. */
+bool
+rwlock_read_try_acquire (struct rwlock *rw) {
+	unsigned old;
+
+	ASSERT (rw != NULL);
+
+	old = __atomic_load_n (&rw->state, __ATOMIC_RELAXED);
+	while (!(old & RW_WRITER))
+		if (__atomic_compare_exchange_n (&rw->state, &old, old + RW_READER,
+					false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+			rwlock_note_reader (rw);
+			return true;
+		}
+	return false;
+}
+
+/* Slow path of rwlock_read_release(): a writer is waiting for
+   RW's readers to drain, and NEW is RW->state after we left.
+   Takes back the writer's donation if it went to us, passing it
+   on to the recorded reader if there is one, and wakes the
+   writer if we were the last reader.
+
+   A thread recorded in RW->reader has not yet left, and when it
+   does it sees RW_WRITER and comes here, where it waits for
+   RW->drained.waiters.lock.  So any thread we read from
+   RW->reader under that lock is still alive. */
+static void
+rwlock_read_release_slow (struct rwlock *rw, unsigned new) {
+	struct thread *cur = thread_current ();
+	enum intr_level old_level;
+	struct lock *drained = &rw->drained;
+	struct list woken;
+
+	list_init (&woken);
+	old_level = intr_disable ();
+	spinlock_acquire (&drained->waiters.lock);
+	if (!thread_mlfqs) {
+		spinlock_acquire (&donation_lock);
+		if (drained->donee == cur) {
+			struct thread *next = __atomic_load_n (&rw->reader,
+					__ATOMIC_SEQ_CST);
+
+			remove_with_lock (drained);
+			refresh_priority ();
+			if (new != RW_WRITER && next != NULL && next != cur
+					&& !waitq_empty (&drained->waiters))
+				donate_priority (drained, next);
+		}
+		spinlock_release (&donation_lock);
+	}
+	if (new == RW_WRITER)
+		waitq_wake (&drained->waiters, 1, &woken);
+	spinlock_release (&drained->waiters.lock);
+	thread_unblock_list (&woken);
+	intr_set_level (old_level);
 
-	while (!list_empty (&cond->waiters))
-		cond_signal (cond, lock);
+	//  깨운 쓰기 스레드나 기부가 빠져 낮아진 우선순위 때문에 양보
+	thread_preemption ();
 }
-/* condition priority */
-bool compare_sema_list_priority(const struct list_elem *a, const struct list_elem *b, void *aux)
-{
-	struct semaphore_elem *sa = list_entry(a, struct semaphore_elem, elem);
-	struct semaphore_elem *sb = list_entry(b, struct semaphore_elem, elem);
 
-	struct list_elem *ta = list_begin(&sa->semaphore.waiters);
-	struct list_elem *tb = list_begin(&sb->semaphore.waiters);
-	return compare_thread_priority(ta, tb, NULL);
+/* Releases RW, which the current thread must hold for reading.
+   The last reader out wakes a writer waiting for readers to
+   drain. */
+void
+rwlock_read_release (struct rwlock *rw) {
+	struct thread *cur = thread_current ();
+	unsigned new;
+
+	ASSERT (rw != NULL);
+	ASSERT (rw->state >= RW_READER);
+
+	/* Stop being the recorded reader before leaving, so that no
+	   writer starts donating to us once we are gone. */
+	__atomic_compare_exchange_n (&rw->reader, &cur, NULL, false,
+			__ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	new = __atomic_sub_fetch (&rw->state, RW_READER, __ATOMIC_SEQ_CST);
+	if (new & RW_WRITER)
+		rwlock_read_release_slow (rw, new);
 }
 
-/* threads/synch.c */
+/* Waits until the readers of RW, on which the current thread
+   just set RW_WRITER, have all left.  While waiting we donate to
+   the recorded reader, and a donation we receive ourselves is
+   passed on to it through our wait_on_lock. */
+static void
+rwlock_wait_drained (struct rwlock *rw) {
+	struct thread *cur = thread_current ();
+	struct lock *drained = &rw->drained;
+	enum intr_level old_level;
+
+	old_level = intr_disable ();
+	spinlock_acquire (&drained->waiters.lock);
+	while (__atomic_load_n (&rw->state, __ATOMIC_SEQ_CST) != RW_WRITER) {
+		struct thread *reader;
+
+		waitq_add (&drained->waiters, true);
+		spinlock_acquire (&donation_lock);
+		cur->wait_on_lock = drained;
+		reader = __atomic_load_n (&rw->reader, __ATOMIC_SEQ_CST);
+		if (!thread_mlfqs && reader != NULL)
+			donate_priority (drained, reader);
+		spinlock_release (&donation_lock);
+		waitq_block (&drained->waiters, 0);
+	}
+	spinlock_acquire (&donation_lock);
+	cur->wait_on_lock = NULL;
+	spinlock_release (&donation_lock);
+	spinlock_release (&drained->waiters.lock);
+	intr_set_level (old_level);
+}
 
-bool compare_semaphore_priority(const struct list_elem *a, const struct list_elem *b, void *aux)
-{
-	struct semaphore_elem *sa = list_entry(a, struct semaphore_elem, elem);
-	struct semaphore_elem *sb = list_entry(b, struct semaphore_elem, elem);
+/* Acquires RW for writing, sleeping until no other thread holds
+   it.  The current thread must not already hold RW.
+
+   Setting RW_WRITER shuts out new readers, so the readers
+   counted at that moment are the only ones we wait for, and the
+   one that brings the count to zero wakes us.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_write_acquire (struct rwlock *rw) {
+	unsigned old;
+
+	ASSERT (rw != NULL);
+	ASSERT (!intr_context ());
 
-	struct list_elem *ta = list_begin(&sa->semaphore.waiters);
-	struct list_elem *tb = list_begin(&sb->semaphore.waiters);
-	return compare_thread_priority(ta, tb, NULL);
+	lock_acquire (&rw->writer);
+	old = __atomic_fetch_or (&rw->state, RW_WRITER, __ATOMIC_SEQ_CST);
+	if (old >= RW_READER)
+		rwlock_wait_drained (rw);
 }
 
-// synch.h 헤더 파일에 함수 선언을 꼭 해주세요
\ No newline at end of file
+/* Tries to acquire RW for writing and returns true if
+   successful or false on failure.  Fails if any other thread
+   holds RW.
+
+   This function will not sleep, so it may be called within an
+   interrupt handler. */
+bool
+rwlock_write_try_acquire (struct rwlock *rw) {
+	unsigned old;
+
+	ASSERT (rw != NULL);
+
+	if (!lock_try_acquire (&rw->writer))
+		return false;
+	old = __atomic_load_n (&rw->state, __ATOMIC_RELAXED);
+	while (old < RW_READER)
+		if (__atomic_compare_exchange_n (&rw->state, &old, RW_WRITER,
+					false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+			return true;
+	lock_release (&rw->writer);
+	return false;
+}
+
+/* Releases RW, which the current thread must hold for writing.
+
+   If other threads are queued on RW->writer, RW_WRITER stays set
+   so that readers arriving meanwhile keep queueing instead of
+   slipping in ahead of them; whoever gets RW->writer next takes
+   it over. */
+void
+rwlock_write_release (struct rwlock *rw) {
+	ASSERT (rw != NULL);
+	ASSERT (rwlock_write_held_by_current_thread (rw));
+
+	if (__atomic_load_n (&rw->writer.contenders, __ATOMIC_SEQ_CST) == 0)
+		__atomic_and_fetch (&rw->state, ~RW_WRITER, __ATOMIC_RELEASE);
+	lock_release (&rw->writer);
+}
+
+/* Returns true if the current thread holds RW for writing,
+   false otherwise. */
+bool
+rwlock_write_held_by_current_thread (const struct rwlock *rw) {
+	ASSERT (rw != NULL);
+
+	return lock_held_by_current_thread (&rw->writer)
+		&& (rw->state & RW_WRITER);
+}
@@ -4,12 +4,16 @@
 #include <random.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/cpu.h"
 #include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
 #include "threads/palloc.h"
+#include "threads/sched.h"
+#include "threads/switch.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
+#include "devices/timer.h"
 #include "intrinsic.h"
 #ifdef USERPROG
 #include "userprog/process.h"
@@ -24,18 +28,16 @@
 #define THREAD_BASIC 0xd42df210
 
 
-void thread_awake(int64_t ticks);
-int64_t timer_ticks(void);
+/* THREAD_READY 상태의 프로세스는 CPU마다 있는 실행 큐(struct runqueue,
+   cpu.h)에 들어 있습니다.  큐 안의 순서는 스레드가 속한 스케줄링
+   클래스가 정합니다 (sched.c).
 
+   스레드는 마지막으로 실행된 CPU의 큐로 돌아갑니다.  할 일이 없는 CPU는
+   다른 CPU의 큐에서 스레드를 훔쳐 옵니다 (steal_thread()). */
 
-/* THREAD_READY 상태의 프로세스 목록입니다. 실행 준비는 되었지만 실제로 실행되고 있지는 않은 프로세스입니다. */
-static struct list ready_list;
-
-/* sleep list 만들기 */
-static struct list sleep_list;
-
-/* Idle(유휴) 스레드입니다. */
-static struct thread *idle_thread;
+/* 잠든 스레드들을 깨어날 틱 기준으로 담는 타이머 휠과 그 락입니다. */
+static struct wheel sleep_wheel;
+static struct spinlock sleep_lock;
 
 /* 초기 스레드로, init.c의 main()을 실행하는 스레드입니다. */
 static struct thread *initial_thread;
@@ -43,18 +45,36 @@ static struct thread *initial_thread;
 /* allocate_tid()에서 사용하는 락입니다. */
 static struct lock tid_lock;
 
-/* 스레드 제거 요청 목록입니다. */
-static struct list destruction_req;
-int64_t MIN_alarm_time = INT64_MAX;
+/* 살아 있는 모든 스레드의 목록과 그 락입니다.  MLFQS가 1초마다
+   모든 스레드의 recent_cpu와 우선순위를 다시 계산할 때 훑습니다.
+   락 순서는 all_lock -> 실행 큐입니다. */
+static struct list all_list;
+static struct spinlock all_lock;
 
-/* 통계 관련 변수입니다. */
-static long long idle_ticks;    /* # of timer ticks spent idle. */
-static long long kernel_ticks;  /* # of timer ticks in kernel threads. */
-static long long user_ticks;    /* # of timer ticks in user programs. */
+/* switch_threads()가 쓰는 struct thread의 `stack' 멤버 오프셋. */
+const uint64_t thread_stack_ofs = offsetof (struct thread, stack);
 
-/* 스케줄링 관련 매크로 및 변수입니다. */
-#define TIME_SLICE 4            /* # of timer ticks to give each thread. */
-static unsigned thread_ticks;   /* # of timer ticks since last yield. */
+/* 다시 쓸 스레드 페이지 캐시와 그 락입니다.  죽은 스레드의 페이지를
+   palloc에 돌려주지 않고 최대 THREAD_CACHE_MAX개까지 모아 두었다가
+   thread_create()에서 그대로 씁니다. */
+#define THREAD_CACHE_MAX 16
+static struct list thread_cache;
+static size_t thread_cache_cnt;
+static struct spinlock thread_cache_lock;
+
+/* MLFQS: 최근 1분 동안 실행 준비가 된 스레드 수의 평균. */
+static fixed_t load_avg;
+
+/* MLFQS 부기에 든 비용 (통계용, rdtsc 사이클). */
+static long long mlfqs_sweeps;          /* 1초마다 하는 재계산 횟수. */
+static long long mlfqs_sweep_cycles;    /* 그 재계산에 든 사이클 합. */
+
+int64_t MIN_alarm_time = INT64_MAX;
+
+/* 깨운 스레드 수와, 그 스레드들을 한꺼번에 깨운 횟수 (통계용).
+   sleep_lock이 보호합니다. */
+static long long sleep_wakeups;
+static long long sleep_batches;
 
 /* false일 경우(기본값) 라운드 로빈 스케줄러를 사용합니다.
    true일 경우, 다단계 피드백 큐 스케줄러를 사용합니다.
@@ -64,11 +84,33 @@ bool thread_mlfqs;
 static void kernel_thread (thread_func *, void *aux);
 
 static void idle (void *aux UNUSED);
+static void idle_loop (void) NO_RETURN;
 static struct thread *next_thread_to_run (void);
+static struct thread *steal_thread (struct cpu *);
 static void init_thread (struct thread *, const char *name, int priority);
 static void do_schedule(int status);
+static struct thread *thread_page_alloc (void);
+static void thread_reap (void);
 static void schedule (void);
+static void schedule_tail (void);
 static tid_t allocate_tid (void);
+static bool thread_bsp_only (struct thread *);
+static struct cpu *thread_home_cpu (struct thread *);
+static bool thread_stealable (struct thread *, void *self);
+static void ready_queue_push (struct thread *);
+static bool ready_queue_push_list (struct list *);
+static bool rq_should_preempt (struct cpu *, struct thread *curr);
+static bool wait_claim (struct thread *, int result);
+static void thread_change_priority (struct thread *, int priority);
+static bool donor_less (const struct heap_elem *, const struct heap_elem *,
+		void *aux);
+static int mlfqs_priority (const struct thread *);
+static void mlfqs_update_priority (struct thread *);
+static void mlfqs_tick (struct thread *);
+static void mlfqs_second (void);
+static void thread_account (struct thread *, uint64_t now);
+static void hist_add (struct cpu *, enum thread_hist, uint64_t cycles);
+static void print_hist (const char *name, enum thread_hist);
 
 /* T가 유효한 스레드를 가리키는 것으로 보이면 true를 반환합니다. */
 #define is_thread(t) ((t) != NULL && (t)->magic == THREAD_MAGIC)
@@ -80,6 +122,9 @@ static tid_t allocate_tid (void);
  * somewhere in the middle, this locates the curent thread. */
 #define running_thread() ((struct thread *) (pg_round_down (rrsp ())))
 
+/* T가 어떤 CPU의 idle 스레드이면 true를 반환합니다. */
+#define is_idle_thread(t) ((t)->cpu != NULL && (t) == (t)->cpu->idle_thread)
+
 // Global descriptor table for the thread_start.
 // Because the gdt will be setup after the thread_init, we should
 // setup temporal gdt first.
@@ -111,15 +156,25 @@ void thread_init (void) {
 	lgdt (&gdt_ds);
 
 	/* Init the globla thread context */
-	lock_init (&tid_lock);
-	list_init (&ready_list);
-	list_init(&sleep_list);
-	list_init (&destruction_req);
+	cpu_init (&cpus[0], 0);
+	cpus[0].online = true;
+	sched_init ();
+	spinlock_init (&donation_lock);
+	spinlock_init (&sleep_lock);
+	spinlock_init (&all_lock);
+	list_init (&all_list);
+	spinlock_init (&thread_cache_lock);
+	list_init (&thread_cache);
+	lock_init_named (&tid_lock, "tid");
+	wheel_init (&sleep_wheel, 0);
 
 	/* Set up a thread structure for the running thread. */
 	initial_thread = running_thread ();
 	init_thread (initial_thread, "main", PRI_DEFAULT);
 	initial_thread->status = THREAD_RUNNING;
+	initial_thread->cpu = &cpus[0];
+	initial_thread->on_cpu = true;
+	cpus[0].curr = initial_thread;
 	initial_thread->tid = allocate_tid ();
 }
 
@@ -139,34 +194,253 @@ thread_start (void) {
 	sema_down (&idle_started);
 }
 
+/* CPU C가 처음 올라탈 idle 스레드를 만들어 반환합니다.  스택이
+   없으면 NULL을 반환합니다.  BSP가 smp_init()에서 AP를 깨우기 전에
+   호출하며, AP는 이 스레드의 페이지를 스택으로 삼아 cpu_ap_main()을
+   실행하다가 thread_start_ap()에서 그대로 idle 루프로 들어갑니다. */
+struct thread *
+thread_create_ap_idle (struct cpu *c) {
+	struct thread *t;
+	char name[16];
+
+	t = thread_page_alloc ();
+	if (t == NULL)
+		return NULL;
+
+	snprintf (name, sizeof name, "idle%d", c->id);
+	init_thread (t, name, PRI_MIN);
+	t->tid = allocate_tid ();
+	t->status = THREAD_RUNNING;
+	t->cpu = c;
+	t->on_cpu = true;
+	c->idle_thread = t;
+	c->curr = t;
+	return t;
+}
+
+/* thread_create_ap_idle()로 만든 C의 idle 스레드를 없애고 페이지를
+   돌려줍니다.  C가 켜지지 못했고 다시는 그 페이지를 건드리지 않을
+   때만 부릅니다. */
+void
+thread_destroy_ap_idle (struct cpu *c) {
+	struct thread *t = c->idle_thread;
+	enum intr_level old_level;
+
+	ASSERT (!c->online);
+	ASSERT (t != NULL && t->cpu == c);
+
+	old_level = intr_disable ();
+	spinlock_acquire (&all_lock);
+	list_remove (&t->all_elem);
+	spinlock_release (&all_lock);
+	intr_set_level (old_level);
+
+	c->idle_thread = NULL;
+	c->curr = NULL;
+	palloc_free_page (t);
+}
+
+/* AP에서 스케줄링을 시작합니다.  인터럽트가 꺼진 채로 AP의 idle
+   스레드에서 호출되며, 반환하지 않습니다. */
+void
+thread_start_ap (void) {
+	/* The boot GDT that start.S loaded lives at a physical address
+	 * that base_pml4 does not map, so switch to the temporal gdt
+	 * before anything reloads a segment register.  APs never run
+	 * user code, so they do not need the full gdt_init() one. */
+	struct desc_ptr gdt_ds = {
+		.size = sizeof (gdt) - 1,
+		.address = (uint64_t) gdt
+	};
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (is_idle_thread (running_thread ()));
+
+	lgdt (&gdt_ds);
+	idle_loop ();
+}
+
 /* 타이머 인터럽트 핸들러에 의해 각 타이머 틱마다 호출됩니다.
    Thus, this function runs in an external interrupt context. */
 void
 thread_tick (void) {
 	struct thread *t = thread_current ();
-
-	thread_awake(timer_ticks());
+	struct cpu *c = t->cpu;
 
 	/* Update statistics. */
-	if (t == idle_thread)
-		idle_ticks++;
+	if (t == c->idle_thread)
+		c->idle_ticks++;
 #ifdef USERPROG
 	else if (t->pml4 != NULL)
-		user_ticks++;
+		c->user_ticks++;
 #endif
 	else
-		kernel_ticks++;
+		c->kernel_ticks++;
+
+	if (thread_mlfqs) {
+		uint64_t start = rdtsc ();
+
+		if (t != c->idle_thread)
+			mlfqs_tick (t);
+		if (c == &cpus[0] && timer_ticks () % TIMER_FREQ == 0)
+			mlfqs_second ();
+		c->mlfqs_ticks++;
+		c->mlfqs_tick_cycles += rdtsc () - start;
+	}
 
 	/* Enforce preemption. */
-	if (++thread_ticks >= TIME_SLICE)
+	if (sched_tick (&c->rq, t))
 		intr_yield_on_return ();
 }
 
-/* 스레드 통계를 출력합니다. */
+/* 틱 없는 유휴 상태(-tickless)에서 타이머 인터럽트 없이 지나간
+   TICKS 틱을 idle 통계에 더합니다. 인터럽트가 꺼진 상태에서 호출됩니다. */
+void
+thread_account_idle (int64_t ticks) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	this_cpu ()->idle_ticks += ticks;
+}
+
+/* 스레드 통계를 출력합니다.  CPU가 여럿이면 모든 CPU의 합입니다. */
 void
 thread_print_stats (void) {
+	long long idle_ticks = 0, kernel_ticks = 0, user_ticks = 0;
+	int i;
+
+	for (i = 0; i < cpu_cnt; i++) {
+		idle_ticks += cpus[i].idle_ticks;
+		kernel_ticks += cpus[i].kernel_ticks;
+		user_ticks += cpus[i].user_ticks;
+	}
 	printf ("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n",
 			idle_ticks, kernel_ticks, user_ticks);
+
+	/* Per-tick cost excludes the once-per-second sweeps, which are
+	   reported separately. */
+	if (thread_mlfqs) {
+		long long ticks = 0, cycles = -mlfqs_sweep_cycles;
+
+		for (i = 0; i < cpu_cnt; i++) {
+			ticks += cpus[i].mlfqs_ticks;
+			cycles += cpus[i].mlfqs_tick_cycles;
+		}
+		printf ("MLFQS: %lld ticks at %lld cycles/tick, "
+				"%lld sweeps at %lld cycles/sweep\n",
+				ticks, ticks > 0 ? cycles / ticks : 0,
+				mlfqs_sweeps,
+				mlfqs_sweeps > 0 ? mlfqs_sweep_cycles / mlfqs_sweeps : 0);
+	}
+	sched_print_stats ();
+	if (sleep_batches > 0)
+		printf ("Sleep: %lld wakeups in %lld batches\n",
+				sleep_wakeups, sleep_batches);
+
+	print_hist ("Run-queue latency", THREAD_HIST_READY);
+	print_hist ("Lock wait", THREAD_HIST_LOCK);
+}
+
+/* 히스토그램 WHICH의 모든 CPU 합을 NAME과 함께 출력합니다.  비어
+   있으면 아무것도 출력하지 않습니다. */
+static void
+print_hist (const char *name, enum thread_hist which) {
+	uint64_t counts[THREAD_HIST_BUCKETS];
+	int first, last, k;
+
+	thread_get_hist (which, counts);
+	for (first = 0; first < THREAD_HIST_BUCKETS && counts[first] == 0; first++)
+		continue;
+	if (first == THREAD_HIST_BUCKETS)
+		return;
+	for (last = THREAD_HIST_BUCKETS - 1; counts[last] == 0; last--)
+		continue;
+
+	printf ("%s (cycles):\n", name);
+	for (k = first; k <= last; k++)
+		printf ("  < 2^%-2d %llu\n", k, (unsigned long long) counts[k]);
+}
+
+/* 현재 스레드의 통계를 지금까지 센 값으로 *STATS에 복사합니다. */
+void
+thread_get_stats (struct thread_stats *stats) {
+	enum intr_level old_level = intr_disable ();
+	struct thread *t = thread_current ();
+
+	thread_account (t, rdtsc ());
+	*stats = t->stats;
+	intr_set_level (old_level);
+}
+
+/* 히스토그램 WHICH의 모든 CPU 합을 COUNTS에 복사합니다.  다른 CPU가
+   세는 중에 읽으므로 버킷 사이의 합이 정확히 맞지 않을 수 있습니다. */
+void
+thread_get_hist (enum thread_hist which, uint64_t counts[THREAD_HIST_BUCKETS]) {
+	int i, k;
+
+	ASSERT (which < THREAD_HIST_CNT);
+
+	for (k = 0; k < THREAD_HIST_BUCKETS; k++)
+		counts[k] = 0;
+	for (i = 0; i < cpu_cnt; i++)
+		for (k = 0; k < THREAD_HIST_BUCKETS; k++)
+			counts[k] += cpus[i].hist[which][k];
+}
+
+/* 사용자 모드에서 커널로 들어왔습니다.  지난 구간을 사용자 모드
+   시간으로 셉니다.  인터럽트와 시스템 콜의 진입 경로에서 호출됩니다. */
+void
+thread_enter_kernel (void) {
+	enum intr_level old_level = intr_disable ();
+	struct thread *t = thread_current ();
+
+	thread_account (t, rdtsc ());
+	t->in_user = false;
+	intr_set_level (old_level);
+}
+
+/* 커널에서 사용자 모드로 돌아갑니다.  지난 구간을 커널 모드 시간으로
+   셉니다. */
+void
+thread_enter_user (void) {
+	enum intr_level old_level = intr_disable ();
+	struct thread *t = thread_current ();
+
+	thread_account (t, rdtsc ());
+	t->in_user = true;
+	intr_set_level (old_level);
+}
+
+/* 현재 스레드가 락을 얻으려고 CYCLES 사이클 동안 블록되었습니다.
+   인터럽트가 꺼진 상태에서 호출해야 합니다. */
+void
+thread_account_lock_wait (uint64_t cycles) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	thread_current ()->stats.lock_cycles += cycles;
+	hist_add (this_cpu (), THREAD_HIST_LOCK, cycles);
+}
+
+/* T의 acct_stamp부터 NOW까지를 T가 있던 모드의 사용 시간에 더합니다.
+   CPU마다 TSC가 조금 어긋날 수 있으므로 거꾸로 간 시간은 버립니다. */
+static void
+thread_account (struct thread *t, uint64_t now) {
+	uint64_t delta = now > t->acct_stamp ? now - t->acct_stamp : 0;
+
+	if (t->in_user)
+		t->stats.user_cycles += delta;
+	else
+		t->stats.kernel_cycles += delta;
+	t->acct_stamp = now;
+}
+
+/* C의 히스토그램 WHICH에 CYCLES를 셉니다.  C는 현재 CPU여야 하고
+   인터럽트가 꺼져 있어야 합니다. */
+static void
+hist_add (struct cpu *c, enum thread_hist which, uint64_t cycles) {
+	int k = cycles == 0 ? 0 : 64 - __builtin_clzll (cycles);
+
+	if (k >= THREAD_HIST_BUCKETS)
+		k = THREAD_HIST_BUCKETS - 1;
+	c->hist[which][k]++;
 }
 
 /* 이름이 NAME인 새 커널 스레드를 생성합니다. with the given initial
@@ -187,13 +461,15 @@ thread_print_stats (void) {
 tid_t
 thread_create (const char *name, int priority,
 		thread_func *function, void *aux) {
+	struct switch_threads_frame *sf;
 	struct thread *t;
 	tid_t tid;
 
 	ASSERT (function != NULL);
 
 	/* Allocate thread. */
-	t = palloc_get_page (PAL_ZERO);
+	thread_reap ();
+	t = thread_page_alloc ();
 	if (t == NULL)
 		return TID_ERROR;
 
@@ -201,16 +477,33 @@ thread_create (const char *name, int priority,
 	init_thread (t, name, priority);
 	tid = t->tid = allocate_tid ();
 
-	/* Call the kernel_thread if it scheduled.
-	 * Note) rdi is 1st argument, and rsi is 2nd argument. */
-	t->tf.rip = (uintptr_t) kernel_thread;
-	t->tf.R.rdi = (uint64_t) function;
-	t->tf.R.rsi = (uint64_t) aux;
-	t->tf.ds = SEL_KDSEG;
-	t->tf.es = SEL_KDSEG;
-	t->tf.ss = SEL_KDSEG;
-	t->tf.cs = SEL_KCSEG;
-	t->tf.eflags = FLAG_IF;
+	/* Under MLFQS the new thread inherits its creator's nice and
+	   recent_cpu, and its priority follows from them.  The idle
+	   thread keeps PRI_MIN. */
+	if (thread_mlfqs && function != idle) {
+		struct thread *parent = thread_current ();
+
+		t->nice = parent->nice;
+		t->recent_cpu = parent->recent_cpu;
+		t->priority = t->init_priority = mlfqs_priority (t);
+	}
+
+	/* The new thread inherits its creator's scheduling policy,
+	   except for EDF, whose bandwidth was admitted for the creator
+	   alone. */
+	if (function != idle && thread_current ()->policy != SCHED_DEADLINE)
+		t->policy = thread_current ()->policy;
+
+	/* Build a frame for switch_threads() to "return" through into
+	 * switch_entry(), which calls kernel_thread (FUNCTION, AUX).
+	 * kernel_thread() turns interrupts on. */
+	sf = (struct switch_threads_frame *) ((uint8_t *) t + PGSIZE - 16) - 1;
+	memset (sf, 0, sizeof *sf);
+	sf->rbx = (uint64_t) kernel_thread;
+	sf->r12 = (uint64_t) function;
+	sf->r13 = (uint64_t) aux;
+	sf->rip = switch_entry;
+	t->stack = (uint8_t *) sf;
 
 	/* Add to run queue. */
 	thread_unblock (t);
@@ -233,10 +526,32 @@ thread_block (void) {
 	schedule ();
 }
 
+/* 스핀락 LOCK을 놓으면서 현재 스레드를 수면 상태로 전환하고,
+   깨어나면 LOCK을 다시 잡고 반환합니다.
+
+   상태를 BLOCKED로 바꾼 뒤에 LOCK을 놓으므로, LOCK을 잡고 깨우는 쪽이
+   그 사이의 깨우기를 놓치는 일이 없습니다.  다른 CPU가 schedule()
+   이전에 이미 깨웠다면 schedule()이 곧바로 이 스레드를 다시 고릅니다.
+   인터럽트가 꺼진 상태에서 호출해야 합니다. */
+void
+thread_block_locked (struct spinlock *lock) {
+	ASSERT (!intr_context ());
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (spinlock_held (lock));
+
+	thread_current ()->status = THREAD_BLOCKED;
+	spinlock_release (lock);
+	schedule ();
+	spinlock_acquire (lock);
+}
+
 /* 블록된 스레드 T를 실행 준비 상태로 전환합니다.
    This is an error if T is not blocked.  (Use thread_yield() to
    make the running thread ready.)
 
+   T가 thread_block_timeout()으로 잠들었고 타임아웃이 이미 T를
+   깨웠다면 아무것도 하지 않습니다.
+
    This function does not preempt the running thread.  This can
    be important: if the caller had disabled interrupts itself,
    it may expect that it can atomically unblock a thread and
@@ -247,13 +562,46 @@ thread_unblock (struct thread *t) {
 
 	ASSERT (is_thread (t));
 
+	/* 타임아웃이 먼저 깨웠다면 그쪽이 실행 큐에 넣습니다. */
+	if (!wait_claim (t, WAIT_SIGNALED))
+		return;
+
 	old_level = intr_disable ();
 	ASSERT (t->status == THREAD_BLOCKED);
-    list_insert_ordered (&ready_list, &t->elem, compare_thread_priority, 0); 
 	t->status = THREAD_READY;
+	ready_queue_push (t);
+	intr_set_level (old_level);
+}
+
+/* LIST에 elem으로 연결된 블록된 스레드들을 모두 실행 준비 상태로
+   만들고 LIST를 비웁니다.  thread_unblock()을 스레드마다 부르는 것과
+   같지만 실행 큐 락은 큐마다 한 번만 잡습니다.  스레드를 깨울 권리는
+   호출한 쪽이 이미 thread_claim_wakeup()으로 가져왔어야 합니다.
+
+   thread_unblock()처럼 현재 스레드를 선점하지 않습니다.  필요하면
+   호출한 쪽이 thread_preemption()을 한 번 부릅니다. */
+void
+thread_unblock_list (struct list *list) {
+	enum intr_level old_level;
+
+	if (list_empty (list))
+		return;
+	old_level = intr_disable ();
+	ready_queue_push_list (list);
 	intr_set_level (old_level);
 }
 
+/* 블록된 T를 깨울 권리를 가져옵니다.  T가 thread_block_timeout()으로
+   잠들었고 타임아웃이 이미 T를 깨웠다면 false를 반환하며, 그때는
+   T를 깨우지 말아야 합니다.  T가 기다리는 대기 목록의 락을 잡은
+   채로 불러야 합니다. */
+bool
+thread_claim_wakeup (struct thread *t) {
+	ASSERT (is_thread (t));
+
+	return wait_claim (t, WAIT_SIGNALED);
+}
+
 /* 현재 실행 중인 스레드의 이름을 반환합니다. */
 const char *
 thread_name (void) {
@@ -293,10 +641,16 @@ thread_exit (void) {
 #ifdef USERPROG
 	process_exit ();
 #endif
+	thread_reap ();
+	sched_dl_release (thread_current ());
 
 	/* Just set our status to dying and schedule another process.
-	   We will be destroyed during the call to schedule_tail(). */
+	   Our page goes on this CPU's destruction_req in schedule(),
+	   and the next thread_reap() here recycles it. */
 	intr_disable ();
+	spinlock_acquire (&all_lock);
+	list_remove (&thread_current ()->all_elem);
+	spinlock_release (&all_lock);
 	do_schedule (THREAD_DYING);
 	NOT_REACHED ();
 }
@@ -310,9 +664,15 @@ thread_yield (void) {
 
 	ASSERT (!intr_context ()); //인터럽트 컥텍스트에서 이 함수가 호출되지 않았는 지확인 
 
+	/* EDF 스레드가 이번 주기의 예산을 다 썼으면 다음 주기까지 잡니다. */
+	if (curr->dl_wakeup != 0) {
+		thread_sleep (curr->dl_wakeup);
+		return;
+	}
+
 	old_level = intr_disable (); // 인터럽트 끄고 이전 상태에 저장 
-	if (curr != idle_thread) //idle = 놀고 있는 스ㅡ레드 
-		list_insert_ordered(&ready_list, &curr->elem, compare_thread_priority, NULL); 
+	if (!is_idle_thread (curr)) //idle = 놀고 있는 스ㅡ레드 
+		ready_queue_push (curr);
 	do_schedule (THREAD_READY);
 	intr_set_level (old_level);
 }
@@ -320,12 +680,20 @@ thread_yield (void) {
 /* 현재 스레드의 우선순위를 NEW_PRIORITY로 설정합니다. */
 void
 thread_set_priority (int new_priority) {
-	thread_current ()->priority = new_priority;
+	enum intr_level old_level;
+
+	/* MLFQS가 우선순위를 정하므로 무시합니다. */
+	if (thread_mlfqs)
+		return;
+
+	old_level = intr_disable ();
+
+	spinlock_acquire (&donation_lock);
 	thread_current()->init_priority = new_priority;
 	refresh_priority();
+	spinlock_release (&donation_lock);
+	intr_set_level (old_level);
 	thread_preemption ();
-
-
 }
 
 /* 현재 스레드의 우선순위를 반환합니다. */
@@ -334,31 +702,191 @@ thread_get_priority (void) {
 	return thread_current ()->priority;
 }
 
-/* Sets the current thread's nice value to NICE. */
+/* Sets the current thread's nice value to NICE, recalculates
+   its priority under the MLFQS, and yields if it should no longer
+   run.  Outside the MLFQS, NICE only sets the thread's weight in
+   the fair scheduling class. */
 void
-thread_set_nice (int nice UNUSED) {
-	/* TODO: Your implementation goes here */
+thread_set_nice (int nice) {
+	enum intr_level old_level;
+
+	if (nice < NICE_MIN)
+		nice = NICE_MIN;
+	if (nice > NICE_MAX)
+		nice = NICE_MAX;
+
+	old_level = intr_disable ();
+	thread_current ()->nice = nice;
+	if (thread_mlfqs)
+		mlfqs_update_priority (thread_current ());
+	intr_set_level (old_level);
+	thread_preemption ();
 }
 
 /* Returns the current thread's nice value. */
 int
 thread_get_nice (void) {
-	/* TODO: Your implementation goes here */
-	return 0;
+	return thread_current ()->nice;
+}
+
+/* 현재 스레드의 스케줄링 정책을 반환합니다. */
+enum sched_policy
+thread_get_policy (void) {
+	return thread_current ()->policy;
+}
+
+/* 현재 스레드의 스케줄링 정책을 POLICY로 바꿉니다.  공정 정책으로
+   들어가는 스레드는 vruntime을 실행 큐의 min_vruntime에서 새로
+   시작하므로, 예전에 쓴 시간 때문에 밀리지 않습니다.  EDF 정책은
+   thread_set_deadline()으로 들어가며, EDF를 떠나는 스레드는 승인받은
+   대역폭을 돌려줍니다. */
+void
+thread_set_policy (enum sched_policy policy) {
+	struct thread *cur = thread_current ();
+	enum intr_level old_level;
+
+	ASSERT (policy == SCHED_PRIO || policy == SCHED_FAIR);
+
+	sched_dl_release (cur);
+	old_level = intr_disable ();
+	if (policy == SCHED_FAIR && cur->policy != SCHED_FAIR)
+		cur->vruntime_rq = NULL;
+	cur->policy = policy;
+	intr_set_level (old_level);
+	thread_preemption ();
+}
+
+/* 현재 스레드를 PERIOD 틱마다 RUNTIME 틱을 쓰고, 각 주기가 시작된 뒤
+   DEADLINE 틱 안에 끝내야 하는 EDF 스레드로 만듭니다.
+   0 < RUNTIME <= DEADLINE <= PERIOD여야 합니다.
+
+   EDF 스레드는 다른 모든 정책의 스레드를 선점하고, 절대 마감이 이른
+   순서로 실행됩니다.  주기마다 RUNTIME을 다 쓰면 다음 주기까지
+   실행되지 않습니다.  EDF 스레드는 CPU 하나에 묶여 그 CPU에서만
+   실행되는데, RUNTIME / PERIOD를 더해도 한도를 넘지 않는 CPU가 없으면
+   요청을 거절하고 false를 반환하며, 이때 정책은 바뀌지 않습니다.
+   승인되면 묶인 CPU로 옮긴 뒤 반환합니다.  이미 EDF 스레드라면
+   인자를 바꿉니다. */
+bool
+thread_set_deadline (int64_t runtime, int64_t deadline, int64_t period) {
+	struct thread *cur = thread_current ();
+	enum intr_level old_level;
+
+	if (!sched_dl_admit (cur, runtime, deadline, period,
+				thread_bsp_only (cur) ? &cpus[0] : NULL))
+		return false;
+
+	old_level = intr_disable ();
+	cur->policy = SCHED_DEADLINE;
+	intr_set_level (old_level);
+	while (this_cpu () != cur->dl_cpu)
+		thread_yield ();
+	thread_preemption ();
+	return true;
 }
 
 /* Returns 100 times the system load average. */
 int
 thread_get_load_avg (void) {
-	/* TODO: Your implementation goes here */
-	return 0;
+	return fp_round (fp_mul_int (load_avg, 100));
 }
 
 /* Returns 100 times the current thread's recent_cpu value. */
 int
 thread_get_recent_cpu (void) {
-	/* TODO: Your implementation goes here */
-	return 0;
+	return fp_round (fp_mul_int (thread_current ()->recent_cpu, 100));
+}
+
+/* MLFQS: T의 nice와 recent_cpu로 정해지는 우선순위를 반환합니다.
+   priority = PRI_MAX - (recent_cpu / 4) - (nice * 2) */
+static int
+mlfqs_priority (const struct thread *t) {
+	int priority = PRI_MAX - fp_to_int (fp_div_int (t->recent_cpu, 4))
+		- t->nice * 2;
+
+	if (priority < PRI_MIN)
+		return PRI_MIN;
+	if (priority > PRI_MAX)
+		return PRI_MAX;
+	return priority;
+}
+
+/* MLFQS: T의 우선순위를 다시 계산합니다.  값이 바뀔 때만 실행 큐를
+   옮깁니다. */
+static void
+mlfqs_update_priority (struct thread *t) {
+	int priority = mlfqs_priority (t);
+
+	if (priority != t->priority) {
+		spinlock_acquire (&donation_lock);
+		thread_change_priority (t, priority);
+		spinlock_release (&donation_lock);
+	}
+}
+
+/* MLFQS: 실행 중인 스레드 T가 틱 하나를 썼습니다.
+
+   틱마다 recent_cpu가 바뀌는 스레드는 T 하나뿐이므로, 이 일은 스레드
+   수와 무관하게 O(1)입니다.  우선순위는 recent_cpu / 4의 정수부가
+   바뀔 때, 즉 대략 4틱에 한 번만 다시 계산합니다.  (정수로 먼저
+   버린 뒤 4로 나눠 버려도 값이 같습니다.)  T보다 높은 우선순위가 실행
+   큐에 있게 되면 인터럽트가 끝날 때 양보합니다. */
+static void
+mlfqs_tick (struct thread *t) {
+	int old_bucket = fp_to_int (t->recent_cpu) / 4;
+
+	t->recent_cpu = fp_add_int (t->recent_cpu, 1);
+	if (fp_to_int (t->recent_cpu) / 4 == old_bucket)
+		return;
+
+	mlfqs_update_priority (t);
+	if (rq_should_preempt (t->cpu, t))
+		intr_yield_on_return ();
+}
+
+/* MLFQS: 1초마다 BSP의 타이머 인터럽트에서 호출됩니다.  load_avg를
+   갱신한 뒤, 모든 스레드 목록을 한 번 훑으며 recent_cpu를 감쇠시키고
+   우선순위를 다시 계산합니다.
+
+   load_avg = (59/60) * load_avg + (1/60) * ready_threads
+   recent_cpu = (2*load_avg)/(2*load_avg + 1) * recent_cpu + nice
+
+   AP의 틱이 이 재계산과 겹치면 그 틱의 recent_cpu 증가분 하나를 잃을
+   수 있지만, 곧바로 감쇠되는 값이라 무시할 만합니다. */
+static void
+mlfqs_second (void) {
+	uint64_t start = rdtsc ();
+	int ready_threads = 0;
+	fixed_t decay;
+	struct list_elem *e;
+	int i;
+
+	ASSERT (intr_context ());
+
+	for (i = 0; i < cpu_cnt; i++) {
+		ready_threads += cpus[i].rq.nr_ready;
+		if (cpus[i].curr != cpus[i].idle_thread)
+			ready_threads++;
+	}
+	load_avg = fp_add (fp_mul (fp_div_int (fp_from_int (59), 60), load_avg),
+			fp_div_int (fp_from_int (ready_threads), 60));
+	decay = fp_div (fp_mul_int (load_avg, 2),
+			fp_add_int (fp_mul_int (load_avg, 2), 1));
+
+	spinlock_acquire (&all_lock);
+	for (e = list_begin (&all_list); e != list_end (&all_list);
+			e = list_next (e)) {
+		struct thread *t = list_entry (e, struct thread, all_elem);
+
+		if (is_idle_thread (t))
+			continue;
+		t->recent_cpu = fp_add_int (fp_mul (decay, t->recent_cpu), t->nice);
+		mlfqs_update_priority (t);
+	}
+	spinlock_release (&all_lock);
+
+	mlfqs_sweeps++;
+	mlfqs_sweep_cycles += rdtsc () - start;
 }
 
 /* Idle(유휴) 스레드입니다.  Executes when no other thread is ready to run.
@@ -374,14 +902,32 @@ static void
 idle (void *idle_started_ UNUSED) {
 	struct semaphore *idle_started = idle_started_;
 
-	idle_thread = thread_current ();
+	this_cpu ()->idle_thread = thread_current ();
 	sema_up (idle_started);
+	idle_loop ();
+}
 
+/* idle 스레드의 본체입니다.  BSP의 idle()과 AP의 thread_start_ap()가
+   함께 씁니다. */
+static void
+idle_loop (void) {
 	for (;;) {
 		/* Let someone else run. */
 		intr_disable ();
 		thread_block ();
 
+		/* Nothing else wants this CPU, so zero pages ahead of time
+		   for palloc.  A thread that becomes ready preempts us as
+		   usual. */
+		intr_enable ();
+		while (palloc_zero_idle ())
+			continue;
+		intr_disable ();
+
+		/* Nothing else can run.  In tickless mode, stop the periodic
+		   tick until the next sleeper is due. */
+		timer_idle_enter ();
+
 		/* Re-enable interrupts and wait for the next one.
 
 		   The `sti' instruction disables interrupts until the
@@ -403,6 +949,7 @@ static void
 kernel_thread (thread_func *function, void *aux) {
 	ASSERT (function != NULL);
 
+	schedule_tail ();     /* Finish the switch that brought us here. */
 	intr_enable ();       /* The scheduler runs with interrupts off. */
 	function (aux);       /* Execute the thread function. */
 	thread_exit ();       /* If function() returns, kill the thread. */
@@ -413,6 +960,8 @@ kernel_thread (thread_func *function, void *aux) {
    NAME. */
 static void
 init_thread (struct thread *t, const char *name, int priority) {
+	enum intr_level old_level;
+
 	ASSERT (t != NULL);
 	ASSERT (PRI_MIN <= priority && priority <= PRI_MAX);
 	ASSERT (name != NULL);
@@ -420,32 +969,246 @@ init_thread (struct thread *t, const char *name, int priority) {
 	memset (t, 0, sizeof *t);
 	t->status = THREAD_BLOCKED;
 	strlcpy (t->name, name, sizeof t->name);
-	t->tf.rsp = (uint64_t) t + PGSIZE - sizeof (void *);
 	t->priority = priority;
 	t->magic = THREAD_MAGIC;
 
 	/*donation*/
 	t ->init_priority = priority;
 	t ->wait_on_lock = NULL;
-	list_init(&t->donations);
+	heap_init (&t->donors, donor_less, NULL);
+	heap_elem_init (&t->wait_elem);
+	t->wait_heap = NULL;
+
+	wheel_elem_init (&t->sleep_elem);
+
+	t->nice = NICE_DEFAULT;
+	t->recent_cpu = 0;
+	t->acct_stamp = rdtsc ();
+	old_level = intr_disable ();
+	spinlock_acquire (&all_lock);
+	list_push_back (&all_list, &t->all_elem);
+	spinlock_release (&all_lock);
+	intr_set_level (old_level);
 }
 
 /* 스케줄링될 다음 스레드를 선택하여 반환합니다.  Should
    return a thread from the run queue, unless the run queue is
    empty.  (If the running thread can continue running, then it
-   will be in the run queue.)  If the run queue is empty, return
-   idle_thread. */
+   will be in the run queue.)  If the run queue is empty, try to
+   steal a thread from another CPU's run queue, and failing that
+   return this CPU's idle thread. */
 static struct thread *
 next_thread_to_run (void) {
-	if (list_empty (&ready_list))
-		return idle_thread;
-	else
-		return list_entry (list_pop_front (&ready_list), struct thread, elem);
+	struct cpu *c = this_cpu ();
+	struct runqueue *rq = &c->rq;
+	struct thread *next = NULL;
+
+	spinlock_acquire (&rq->lock);
+	next = sched_pick_next (rq);
+	if (next != NULL)
+		sched_dequeue (rq, next);
+	spinlock_release (&rq->lock);
+
+	if (next == NULL && cpu_cnt > 1)
+		next = steal_thread (c);
+	return next != NULL ? next : c->idle_thread;
+}
+
+/* SELF가 아닌 CPU의 실행 큐에서 SELF가 실행할 수 있는 스레드 중
+   가장 먼저 실행될 것을 꺼내 반환합니다.  없으면 NULL을 반환합니다.
+
+   다른 CPU가 자기 큐를 오래 잡고 있으면 기다리지 않고 넘어갑니다. */
+static struct thread *
+steal_thread (struct cpu *self) {
+	int i;
+
+	for (i = 1; i < cpu_cnt; i++) {
+		struct cpu *c = &cpus[(self->id + i) % cpu_cnt];
+		struct runqueue *rq = &c->rq;
+		struct thread *found;
+
+		if (rq->nr_ready == 0 || !spinlock_try_acquire (&rq->lock))
+			continue;
+		found = sched_pick_steal (rq, thread_stealable, self);
+		if (found != NULL)
+			sched_dequeue (rq, found);
+		spinlock_release (&rq->lock);
+		if (found != NULL)
+			return found;
+	}
+	return NULL;
+}
+
+/* CPU SELF가 다른 CPU의 실행 큐에서 T를 가져가도 되면 true를
+   반환합니다.  아직 다른 CPU가 빠져나오는 중인 스레드(on_cpu)와 CPU에
+   묶인 EDF 스레드는 가져오지 않고, USERPROG에서 사용자 프로세스는
+   BSP가 아니면 가져오지 않습니다. */
+static bool
+thread_stealable (struct thread *t, void *self) {
+	return !t->on_cpu && t->policy != SCHED_DEADLINE
+		&& (!thread_bsp_only (t) || self == &cpus[0]);
+}
+
+/* T가 BSP에서만 실행될 수 있으면 true를 반환합니다.  syscall
+   진입 경로와 TSS가 하나뿐이므로 사용자 프로세스는 BSP에서만
+   실행됩니다. */
+static bool
+thread_bsp_only (struct thread *t UNUSED) {
+#ifdef USERPROG
+	return t->pml4 != NULL;
+#else
+	return false;
+#endif
+}
+
+/* T가 돌아갈 CPU를 반환합니다.  EDF 스레드는 승인받아 묶인 CPU로,
+   BSP에서만 실행될 수 있는 스레드는 BSP로 갑니다.  나머지는
+   마지막으로 실행된 CPU로 돌아가 캐시를 재사용합니다.  처음 실행되는
+   스레드는 현재 CPU에 둡니다. */
+static struct cpu *
+thread_home_cpu (struct thread *t) {
+	if (t->policy == SCHED_DEADLINE && t->dl_cpu != NULL)
+		return t->dl_cpu;
+	if (thread_bsp_only (t))
+		return &cpus[0];
+	return t->cpu != NULL ? t->cpu : this_cpu ();
+}
+
+/* T를 자기 CPU의 실행 큐에 넣고, 그 CPU에서 지금 실행 중인 스레드를
+   T가 선점해야 하면 그 CPU를 깨워 다시 스케줄링하게 합니다.  그 CPU가
+   바쁘면 놀고 있는 CPU를 깨워 훔쳐 가게 합니다.
+   인터럽트가 꺼진 상태에서 호출해야 합니다. */
+static void
+ready_queue_push (struct thread *t) {
+	struct cpu *c = thread_home_cpu (t);
+	bool preempt = false;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	t->ready_stamp = rdtsc ();
+	spinlock_acquire (&c->rq.lock);
+	sched_enqueue (&c->rq, t);
+	if (c != this_cpu ()) {
+		struct thread *curr = c->curr;
+
+		preempt = curr == NULL || sched_preempts (&c->rq, curr, t);
+	}
+	spinlock_release (&c->rq.lock);
+
+	if (c != this_cpu ()) {
+		if (preempt)
+			cpu_kick (c);
+		else
+			cpu_kick_idle ();
+	} else if (cpu_cnt > 1 && c->rq.nr_ready > 1)
+		cpu_kick_idle ();
+}
+
+/* LIST에 elem으로 연결된 BLOCKED 스레드들을 모두 준비 상태로 만들어
+   각자의 실행 큐에 넣고, LIST를 비웁니다.  스레드마다
+   ready_queue_push()를 부르는 대신 실행 큐마다 락을 한 번만 잡고
+   선점 여부도 한 번만 판단합니다.  다른 CPU는 필요하면 깨우고, 현재
+   CPU에서 실행 중인 스레드를 선점해야 하면 true를 반환합니다.
+   인터럽트가 꺼진 상태에서 호출해야 합니다. */
+static bool
+ready_queue_push_list (struct list *list) {
+	struct cpu *self = this_cpu ();
+	uint64_t now = rdtsc ();
+	bool preempt_self = false;
+	bool kick_idle = false;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	while (!list_empty (list)) {
+		struct thread *first = list_entry (list_front (list), struct thread, elem);
+		struct cpu *c = thread_home_cpu (first);
+		struct list_elem *e, *next;
+		bool preempt;
+
+		/* C가 집인 스레드를 모두 넣습니다. */
+		spinlock_acquire (&c->rq.lock);
+		for (e = list_begin (list); e != list_end (list); e = next) {
+			struct thread *t = list_entry (e, struct thread, elem);
+
+			next = list_next (e);
+			if (thread_home_cpu (t) != c)
+				continue;
+			list_remove (e);
+			ASSERT (t->status == THREAD_BLOCKED);
+			t->status = THREAD_READY;
+			t->ready_stamp = now;
+			sched_enqueue (&c->rq, t);
+		}
+		preempt = c->curr == NULL || sched_preempts (&c->rq, c->curr, NULL);
+		spinlock_release (&c->rq.lock);
+
+		if (c == self) {
+			preempt_self = preempt;
+			if (cpu_cnt > 1 && c->rq.nr_ready > 1)
+				kick_idle = true;
+		} else if (preempt)
+			cpu_kick (c);
+		else
+			kick_idle = true;
+	}
+	if (kick_idle)
+		cpu_kick_idle ();
+	return preempt_self;
+}
+
+/* C의 실행 큐에 C에서 실행 중인 CURR을 선점해야 할 스레드가 있으면
+   true를 반환합니다.  인터럽트가 꺼진 상태에서 호출해야 합니다. */
+static bool
+rq_should_preempt (struct cpu *c, struct thread *curr) {
+	bool preempt;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (c->rq.nr_ready == 0)
+		return false;
+	spinlock_acquire (&c->rq.lock);
+	preempt = sched_preempts (&c->rq, curr, NULL);
+	spinlock_release (&c->rq.lock);
+	return preempt;
+}
+
+/* T의 (유효) 우선순위를 PRIORITY로 바꿉니다.  T가 실행 큐나 대기
+   힙에 들어 있다면 그 안의 위치도 옮겨서, 위치와 우선순위가 어긋나지
+   않도록 합니다.  대기 힙 때문에 donation_lock을 잡고 있어야 합니다. */
+static void
+thread_change_priority (struct thread *t, int priority) {
+	enum intr_level old_level = intr_disable ();
+	struct runqueue *rq = t->rq;
+
+	ASSERT (spinlock_held (&donation_lock));
+
+	if (t->wait_heap != NULL) {
+		t->priority = priority;
+		heap_update (t->wait_heap, &t->wait_elem);
+		intr_set_level (old_level);
+		return;
+	}
+
+	if (rq != NULL) {
+		spinlock_acquire (&rq->lock);
+		if (t->rq == rq) {
+			sched_dequeue (rq, t);
+			t->priority = priority;
+			sched_enqueue (rq, t);
+			spinlock_release (&rq->lock);
+			intr_set_level (old_level);
+			return;
+		}
+		spinlock_release (&rq->lock);
+	}
+	t->priority = priority;
+	intr_set_level (old_level);
 }
 
 /* iretq를 사용하여 스레드를 시작합니다. */
 void
 do_iret (struct intr_frame *tf) {
+	thread_enter_user ();
 	__asm __volatile(
 			"movq %0, %%rsp\n"
 			"movq 0(%%rsp),%%r15\n"
@@ -471,75 +1234,6 @@ do_iret (struct intr_frame *tf) {
 			: : "g" ((uint64_t) tf) : "memory");
 }
 
-/* 새 스레드의 페이지를 활성화하여 스레드를 전환합니다.
-   tables, and, if the previous thread is dying, destroying it.
-
-   At this function's invocation, we just switched from thread
-   PREV, the new thread is already running, and interrupts are
-   still disabled.
-
-   It's not safe to call printf() until the thread switch is
-   complete.  In practice that means that printf()s should be
-   added at the end of the function. */
-static void
-thread_launch (struct thread *th) {
-	uint64_t tf_cur = (uint64_t) &running_thread ()->tf;
-	uint64_t tf = (uint64_t) &th->tf;
-	ASSERT (intr_get_level () == INTR_OFF);
-
-	/* The main switching logic.
-	 * We first restore the whole execution context into the intr_frame
-	 * and then switching to the next thread by calling do_iret.
-	 * Note that, we SHOULD NOT use any stack from here
-	 * until switching is done. */
-	__asm __volatile (
-			/* Store registers that will be used. */
-			"push %%rax\n"
-			"push %%rbx\n"
-			"push %%rcx\n"
-			/* Fetch input once */
-			"movq %0, %%rax\n"
-			"movq %1, %%rcx\n"
-			"movq %%r15, 0(%%rax)\n"
-			"movq %%r14, 8(%%rax)\n"
-			"movq %%r13, 16(%%rax)\n"
-			"movq %%r12, 24(%%rax)\n"
-			"movq %%r11, 32(%%rax)\n"
-			"movq %%r10, 40(%%rax)\n"
-			"movq %%r9, 48(%%rax)\n"
-			"movq %%r8, 56(%%rax)\n"
-			"movq %%rsi, 64(%%rax)\n"
-			"movq %%rdi, 72(%%rax)\n"
-			"movq %%rbp, 80(%%rax)\n"
-			"movq %%rdx, 88(%%rax)\n"
-			"pop %%rbx\n"              // Saved rcx
-			"movq %%rbx, 96(%%rax)\n"
-			"pop %%rbx\n"              // Saved rbx
-			"movq %%rbx, 104(%%rax)\n"
-			"pop %%rbx\n"              // Saved rax
-			"movq %%rbx, 112(%%rax)\n"
-			"addq $120, %%rax\n"
-			"movw %%es, (%%rax)\n"
-			"movw %%ds, 8(%%rax)\n"
-			"addq $32, %%rax\n"
-			"call __next\n"         // read the current rip.
-			"__next:\n"
-			"pop %%rbx\n"
-			"addq $(out_iret -  __next), %%rbx\n"
-			"movq %%rbx, 0(%%rax)\n" // rip
-			"movw %%cs, 8(%%rax)\n"  // cs
-			"pushfq\n"
-			"popq %%rbx\n"
-			"mov %%rbx, 16(%%rax)\n" // eflags
-			"mov %%rsp, 24(%%rax)\n" // rsp
-			"movw %%ss, 32(%%rax)\n"
-			"mov %%rcx, %%rdi\n"
-			"call do_iret\n"
-			"out_iret:\n"
-			: : "g"(tf_cur), "g" (tf) : "memory"
-			);
-}
-
 /* 새 프로세스를 스케줄합니다. 진입 시 인터럽트는 비활성화되어야 합니다.
  * This function modify current thread's status to status and then
  * finds another thread to run and switches to it.
@@ -548,28 +1242,110 @@ static void
 do_schedule(int status) {
 	ASSERT (intr_get_level () == INTR_OFF);
 	ASSERT (thread_current()->status == THREAD_RUNNING);
-	while (!list_empty (&destruction_req)) {
-		struct thread *victim =
-			list_entry (list_pop_front (&destruction_req), struct thread, elem);
-		palloc_free_page(victim);
-	}
 	thread_current ()->status = status;
 	schedule ();
 }
 
+/* 스레드 페이지를 하나 얻습니다.  캐시에 있으면 그것을, 없으면
+   palloc에서 새로 받습니다.  init_thread()가 struct thread 부분만
+   지우므로 페이지 전체를 0으로 채우지는 않습니다. */
+static struct thread *
+thread_page_alloc (void) {
+	struct thread *t = NULL;
+	enum intr_level old_level = intr_disable ();
+
+	spinlock_acquire (&thread_cache_lock);
+	if (!list_empty (&thread_cache)) {
+		t = list_entry (list_pop_front (&thread_cache), struct thread, elem);
+		thread_cache_cnt--;
+	}
+	spinlock_release (&thread_cache_lock);
+	intr_set_level (old_level);
+
+	if (t == NULL)
+		t = palloc_get_page (0);
+	return t;
+}
+
+/* 이 CPU에서 죽은 스레드들의 페이지를 거둡니다.  캐시에 자리가
+   있으면 넣고, 나머지는 palloc에 돌려줍니다.  인터럽트를 끈 채로는
+   목록을 떼어 오기만 하고, 페이지를 해제하는 일은 인터럽트를 켠
+   뒤에 합니다. */
+static void
+thread_reap (void) {
+	struct list *destruction_req;
+	struct list dead;
+	enum intr_level old_level;
+
+	ASSERT (!intr_context ());
+
+	list_init (&dead);
+	old_level = intr_disable ();
+	destruction_req = &this_cpu ()->destruction_req;
+	if (list_empty (destruction_req)) {
+		intr_set_level (old_level);
+		return;
+	}
+	list_splice (list_end (&dead), list_begin (destruction_req),
+			list_end (destruction_req));
+
+	spinlock_acquire (&thread_cache_lock);
+	while (!list_empty (&dead) && thread_cache_cnt < THREAD_CACHE_MAX) {
+		list_push_front (&thread_cache, list_pop_front (&dead));
+		thread_cache_cnt++;
+	}
+	spinlock_release (&thread_cache_lock);
+	intr_set_level (old_level);
+
+	while (!list_empty (&dead))
+		palloc_free_page (list_entry (list_pop_front (&dead),
+					struct thread, elem));
+}
+
 static void
 schedule (void) {
 	struct thread *curr = running_thread ();
 	struct thread *next = next_thread_to_run ();
+	struct cpu *c = curr->cpu;
+	uint64_t now = rdtsc ();
 
 	ASSERT (intr_get_level () == INTR_OFF);
 	ASSERT (curr->status != THREAD_RUNNING);
 	ASSERT (is_thread (next));
+	ASSERT (c == this_cpu ());
+
+	/* Charge CURR for its run, and NEXT for its wait on the run
+	   queue.  A thread that leaves the CPU while still READY was
+	   preempted; one that BLOCKs gave it up. */
+	thread_account (curr, now);
+	if (curr != next) {
+		if (curr->status == THREAD_READY)
+			curr->stats.involuntary_switches++;
+		else if (curr->status == THREAD_BLOCKED)
+			curr->stats.voluntary_switches++;
+	}
+	if (next->ready_stamp != 0) {
+		uint64_t wait = now > next->ready_stamp ? now - next->ready_stamp : 0;
+
+		next->stats.ready_cycles += wait;
+		hist_add (c, THREAD_HIST_READY, wait);
+		next->ready_stamp = 0;
+	}
+	next->acct_stamp = now;
+
+	/* NEXT was queued here by another CPU that may still be
+	   switching away from it.  Wait until that CPU is off NEXT's
+	   stack. */
+	while (next != curr && next->on_cpu)
+		asm volatile ("pause" : : : "memory");
+
 	/* Mark us as running. */
 	next->status = THREAD_RUNNING;
+	next->cpu = c;
+	c->curr = next;
 
 	/* Start new time slice. */
-	thread_ticks = 0;
+	c->thread_ticks = 0;
 
 #ifdef USERPROG
 	/* Activate the new address space. */
@@ -582,19 +1358,64 @@ schedule (void) {
 		   pull out the rug under itself.
 		   We just queuing the page free reqeust here because the page is
 		   currently used by the stack.
-		   The real destruction logic will be called at the beginning of the
-		   schedule(). */
+		   thread_reap() recycles it later, with interrupts on. */
 		if (curr && curr->status == THREAD_DYING && curr != initial_thread) {
 			ASSERT (curr != next);
-			list_push_back (&destruction_req, &curr->elem);
+			list_push_back (&c->destruction_req, &curr->elem);
 		}
 
 		/* Before switching the thread, we first save the information
 		 * of current running. */
-		thread_launch (next);
+		next->on_cpu = true;
+		c->prev = curr;
+		switch_threads (curr, next);
+
+		/* We are running again, possibly on another CPU. */
+		schedule_tail ();
+	}
+}
+
+/* 스레드 전환을 마무리합니다.  전환해 나온 스레드의 스택에서
+   완전히 벗어났으므로, 다른 CPU가 그 스레드를 실행해도 된다고
+   알립니다.  schedule()에서 돌아온 직후와, 새 스레드가 처음
+   시작할 때 kernel_thread()에서 호출됩니다. */
+static void
+schedule_tail (void) {
+	struct cpu *c = this_cpu ();
+	struct thread *prev = c->prev;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (prev != NULL) {
+		c->prev = NULL;
+		barrier ();
+		prev->on_cpu = false;
 	}
 }
 
+/* 현재 CPU의 struct cpu를 반환합니다.  실행 중인 스레드가 자신이
+   올라가 있는 CPU를 기억하므로, thread_init() 이전에는 BSP를
+   반환합니다.  인터럽트가 켜져 있으면 반환하는 순간 다른 CPU로
+   옮겨 갔을 수도 있습니다. */
+struct cpu *
+this_cpu (void) {
+	struct thread *t = running_thread ();
+
+	return is_thread (t) && t->cpu != NULL ? t->cpu : &cpus[0];
+}
+
+/* 현재 스레드를 BSP로 옮깁니다.  사용자 모드로 들어가기 전에
+   호출해서, 사용자 프로세스가 BSP에서만 실행되도록 합니다.
+   현재 스레드에는 이미 페이지 테이블이 있어야 합니다. */
+void
+thread_move_to_bsp (void) {
+	ASSERT (!intr_context ());
+	ASSERT (thread_bsp_only (thread_current ()));
+
+	while (this_cpu () != &cpus[0])
+		thread_yield ();
+}
+
 /* 새 스레드에 사용할 tid를 반환합니다. */
 static tid_t
 allocate_tid (void) {
@@ -608,45 +1429,145 @@ allocate_tid (void) {
 	return tid;
 }
 
-static bool cmp_wakeup_tick(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED) {
-    struct thread *ta = list_entry(a, struct thread, elem);
-    struct thread *tb = list_entry(b, struct thread, elem);
-    return ta->time_to_wakeup < tb->time_to_wakeup;  // 작은 값이 앞에 오도록
+/* 잠든 스레드를 깨우는 wheel_action_func입니다.  바로 깨우지 않고
+   AUX가 가리키는 리스트에 모아 두어, thread_awake()가 한꺼번에
+   실행 큐에 넣게 합니다.  타임아웃이 걸린 대기라면 깨우는 쪽이 먼저
+   깨우지 않았을 때만 넣습니다. */
+static void
+wake_sleeper (struct wheel_elem *e, void *aux) {
+	struct list *woken = aux;
+	struct thread *t = wheel_entry (e, struct thread, sleep_elem);
+
+	if (!wait_claim (t, WAIT_TIMEDOUT))
+		return;
+	list_push_back (woken, &t->elem);
+	sleep_wakeups++;
+}
+
+/* T를 깨울 권리를 RESULT로 가져갑니다.  T가 타임아웃 없이 잠들었으면
+   항상 성공하고, 타임아웃이 걸린 대기라면 WAIT_PENDING을 먼저 바꾼
+   쪽만 성공합니다.  실패한 쪽은 T를 깨우지 않습니다. */
+static bool
+wait_claim (struct thread *t, int result) {
+	int pending = WAIT_PENDING;
+
+	if (__atomic_load_n (&t->wait_result, __ATOMIC_ACQUIRE) == WAIT_NONE)
+		return true;
+	return __atomic_compare_exchange_n (&t->wait_result, &pending, result,
+			false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+/* [TICKS, TICKS + SLACK] 안에서 실제로 깨울 틱을 고릅니다.  이미
+   예정된 깨움이 범위 안에 있으면 거기에 얹고, 아니면 범위 안에서
+   아래쪽 0 비트가 가장 많은 틱을 골라 범위가 겹치는 잠들이 같은
+   틱에 모이게 합니다.  sleep_lock을 잡은 상태에서 호출해야 합니다. */
+static int64_t
+sleep_apply_slack (int64_t ticks, int64_t slack) {
+	int64_t limit;
+
+	if (slack <= 0)
+		return ticks;
+	limit = ticks + slack;
+	if (MIN_alarm_time >= ticks && MIN_alarm_time <= limit)
+		return MIN_alarm_time;
+	return limit & ~((1LL << (63 - __builtin_clzll (ticks ^ limit))) - 1);
+}
+
+/* 현재 스레드를 TICKS 틱이 될 때까지 재웁니다.
+   타이머 휠 슬롯에 넣기만 하므로 잠든 스레드 수와 무관하게 O(1)입니다. */
+void thread_sleep(int64_t ticks) {
+    thread_sleep_slack(ticks, 0);
 }
 
-void thread_sleep(int64_t ticks) {                    // 깨어나야 할 시각(ticks)을 인자로 받음
+/* 현재 스레드를 TICKS 틱부터 TICKS + SLACK 틱 사이에 깨어나도록
+   재웁니다.  여유가 있으면 다른 스레드와 같은 틱에 깨워서 타이머
+   처리와 문맥 전환 횟수를 줄입니다. */
+void thread_sleep_slack(int64_t ticks, int64_t slack) {
     struct thread  *cur_thread;                        // 현재 스레드 포인터
     enum intr_level old_level;                        // 이전 인터럽트 상태 저장 변수
 
     old_level = intr_disable();                       // 인터럽트를 비활성화하고 상태 저장
     cur_thread = thread_current();                    // 현재 실행 중인 스레드 구함
 
-    ASSERT(cur_thread != idle_thread);                // idle 스레드는 재우면 안 됨
+    ASSERT(!is_idle_thread(cur_thread));              // idle 스레드는 재우면 안 됨
 
-    cur_thread->time_to_wakeup = ticks;               // 깨울 시각 저장
-    list_insert_ordered(&sleep_list, &cur_thread->elem, cmp_wakeup_tick, NULL); // 🔁 변경
-    thread_block();                                   // 현재 스레드를 BLOCKED 상태로 바꿈 (스케줄러에 의해 제거됨)
+    spinlock_acquire(&sleep_lock);
+    ticks = sleep_apply_slack(ticks, slack);           // 여유 안에서 깨울 틱을 고름
+    wheel_insert(&sleep_wheel, &cur_thread->sleep_elem, ticks); // 깨울 시각의 슬롯에 넣음
+    if (ticks < MIN_alarm_time) {                     // 다음 마감 시각 캐시 갱신
+        MIN_alarm_time = ticks;
+        cpu_kick(&cpus[0]);                           // BSP가 틱 없이 자고 있으면 깨움
+    }
+    thread_block_locked(&sleep_lock);                 // 현재 스레드를 BLOCKED 상태로 바꿈 (스케줄러에 의해 제거됨)
+    spinlock_release(&sleep_lock);
 
     intr_set_level(old_level);                        // 인터럽트 상태 원래대로 복원
 }
 
+/* thread_block_locked()처럼 스핀락 LOCK을 놓으면서 현재 스레드를
+   재우고, 깨어나면 LOCK을 다시 잡고 반환합니다.  다만 LOCK을 놓기
+   전에 스레드를 타이머 휠의 DEADLINE 틱에도 걸어 두어서, LOCK이
+   보호하는 대기 목록에서 깨우는 쪽과 타임아웃 중 먼저 온 쪽이
+   스레드를 깨웁니다 (wait_claim()).  폴링하지 않습니다.
+
+   깨어나면 휠에 남은 요소를 치우고, 타임아웃 때문에 깨어났으면
+   true를 반환합니다.  그때는 스레드가 아직 LOCK의 대기 목록에 남아
+   있을 수 있으므로 호출한 쪽이 LOCK을 잡은 채로 빼내야 합니다.
+   깨우는 쪽은 LOCK 아래에서, 타임아웃은 sleep_lock 아래에서만
+   wait_claim()을 부르므로, 두 락을 다시 잡은 뒤에는 늦게 오는
+   깨우기가 없습니다.  락 순서는 LOCK -> sleep_lock입니다.
+   인터럽트가 꺼진 상태에서 호출해야 합니다. */
+bool
+thread_block_timeout (struct spinlock *lock, int64_t deadline) {
+	struct thread *cur = thread_current ();
+	bool timed_out;
 
+	ASSERT (!intr_context ());
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (spinlock_held (lock));
+	ASSERT (!is_idle_thread (cur));
+
+	cur->status = THREAD_BLOCKED;
+	__atomic_store_n (&cur->wait_result, WAIT_PENDING, __ATOMIC_RELEASE);
+	spinlock_acquire (&sleep_lock);
+	wheel_insert (&sleep_wheel, &cur->sleep_elem, deadline);
+	if (deadline < MIN_alarm_time) {
+		MIN_alarm_time = deadline;
+		cpu_kick (&cpus[0]);
+	}
+	spinlock_release (&sleep_lock);
+	spinlock_release (lock);
+	schedule ();
+	spinlock_acquire (lock);
+
+	spinlock_acquire (&sleep_lock);
+	if (wheel_elem_pending (&cur->sleep_elem))
+		wheel_remove (&sleep_wheel, &cur->sleep_elem);
+	timed_out = cur->wait_result == WAIT_TIMEDOUT;
+	__atomic_store_n (&cur->wait_result, WAIT_NONE, __ATOMIC_RELEASE);
+	spinlock_release (&sleep_lock);
+	return timed_out;
+}
+
+/* TICKS 틱까지 깨어날 시간이 된 스레드를 모두 깨웁니다.
+   timer_interrupt()에서 틱마다 최대 한 번, 그것도 MIN_alarm_time에
+   도달했을 때만 호출됩니다. 비용은 깨어나는 스레드 수에 비례합니다.
+   깨어난 스레드들은 한꺼번에 실행 큐에 넣고, 선점 여부도 한 번만
+   판단합니다. */
 void thread_awake(int64_t ticks) {
     enum intr_level old_level = intr_disable();  // 인터럽트 비활성화
+    struct list woken;
 
-    struct list_elem *e = list_begin(&sleep_list);
+    list_init(&woken);
+    spinlock_acquire(&sleep_lock);
+    wheel_advance(&sleep_wheel, ticks, wake_sleeper, &woken);
+    MIN_alarm_time = wheel_next_deadline(&sleep_wheel);  // 다음에 할 일이 생기는 틱
+    if (!list_empty(&woken))
+        sleep_batches++;
+    spinlock_release(&sleep_lock);
 
-    // sleep_list는 wakeup_tick 오름차순으로 정렬되어 있음
-    while (e != list_end(&sleep_list)) {
-        struct thread *t = list_entry(e, struct thread, elem);
-
-        if (t->time_to_wakeup <= ticks) {
-            e = list_remove(e);            // 리스트에서 제거 후 다음 요소로 이동
-            thread_unblock(t);             // READY 상태로 전환
-        } else {
-            break;  // 정렬되어 있으므로, 더 이상 볼 필요 없음
-        }
-    }
+    if (ready_queue_push_list(&woken) && intr_context())
+        intr_yield_on_return();
 
     intr_set_level(old_level);  // 인터럽트 복원
 }
@@ -654,85 +1575,138 @@ void thread_awake(int64_t ticks) {
 
 /* threads/thread.c */
 
-bool compare_thread_priority(const struct list_elem *a_, const struct list_elem *b_, void *aux UNUSED) 
-{
-	struct thread *a = list_entry(a_, struct thread, elem)->priority;
-	struct thread *b = list_entry(b_, struct thread, elem)->priority;
-	return a > b;
+/* 대기 힙 비교 함수: A 스레드의 우선순위가 B보다 낮으면 true. */
+bool
+thread_priority_less (const struct heap_elem *a_, const struct heap_elem *b_,
+		void *aux UNUSED) {
+	int a = heap_entry (a_, struct thread, wait_elem)->priority;
+	int b = heap_entry (b_, struct thread, wait_elem)->priority;
+	return a < b;
 }
 
 // thread.h에 꼭 함수 선언을 해줍시다.
 
 
 
+/* 실행 큐에 현재 스레드를 선점해야 할 스레드가 있으면 양보합니다.
+   인터럽트 핸들러 안에서는 바로 양보할 수 없으므로 핸들러가
+   끝날 때 양보하도록 예약합니다. */
 void thread_preemption(void)
 {
-	if (!list_empty(&ready_list)) 
-	{
-		struct thread *top_priority_thread = list_begin(&ready_list);
-		if (compare_thread_priority(top_priority_thread, &thread_current()->elem, NULL))
-			thread_yield();
-	}
+	enum intr_level old_level = intr_disable ();
+	bool preempt = rq_should_preempt (this_cpu (), thread_current ());
+	intr_set_level (old_level);
+
+	if (!preempt)
+		return;
+	if (intr_context ())
+		intr_yield_on_return ();
+	else
+		thread_yield ();
 }
 
-/* threads/thread.c */
+/* LOCK이 기부하는 우선순위, 즉 LOCK을 기다리는 스레드 중 가장 높은
+   우선순위를 반환합니다.  기부 중인 락에는 대기자가 있어야 합니다. */
+static int
+lock_donation (const struct lock *lock) {
+	ASSERT (!heap_empty (&lock->waiters.exclusive));
+	return heap_entry (heap_top (&lock->waiters.exclusive), struct thread,
+			wait_elem)->priority;
+}
 
-void donate_priority(void)
-{
-	struct thread *holder = thread_current()->wait_on_lock->holder;
-	int count = 0;
-	while (holder != NULL)
-	{
-		holder->priority = thread_current()->priority;
-		count++;
-		if (count > 8 || holder->wait_on_lock == NULL)
-			break;
-		holder = holder->wait_on_lock->holder;
+/* donors 힙 비교 함수: A 락이 기부하는 우선순위가 B보다 낮으면 true. */
+static bool
+donor_less (const struct heap_elem *a, const struct heap_elem *b,
+		void *aux UNUSED) {
+	return lock_donation (heap_entry (a, struct lock, donor_elem))
+		< lock_donation (heap_entry (b, struct lock, donor_elem));
+}
+
+/* T가 받아야 할 유효 우선순위: 원래 우선순위와, T가 가진 락들이
+   기부하는 우선순위 중 큰 값.  donors 힙의 꼭대기만 보면 되므로 O(1). */
+static int
+donated_priority (const struct thread *t) {
+	int priority = t->init_priority;
+
+	if (!heap_empty (&t->donors)) {
+		int donation = lock_donation (heap_entry (heap_top (&t->donors),
+					struct lock, donor_elem));
+		if (donation > priority)
+			priority = donation;
 	}
+	return priority;
 }
 
+/* LOCK의 대기자가 바뀌었으니, LOCK을 받은 스레드부터 기부 사슬을
+   따라 올라가며 우선순위를 다시 계산합니다.  한 단계마다 힙 위치를
+   고치는 O(log n) 비용만 들고, 우선순위가 더 바뀌지 않는 곳에서
+   멈춥니다.  교착 상태가 없다면 사슬에 고리가 없으므로 깊이 제한은
+   두지 않습니다.  우선순위가 바뀐 스레드 수를 반환합니다. */
+static int
+donation_propagate (struct lock *lock) {
+	struct thread *t;
+	int changed = 0;
 
-void remove_with_lock(struct lock *lock)
-{
-	struct list_elem *curr_donation_elem = list_begin(&thread_current()->donations);
+	while (lock != NULL && (t = lock->donee) != NULL) {
+		int priority;
 
-	while (curr_donation_elem != list_tail(&thread_current()->donations))
-	{
-		struct thread *curr_donation_thread = list_entry(curr_donation_elem, struct thread, donations_elem);
-		if (curr_donation_thread->wait_on_lock == lock)
-			curr_donation_elem = list_remove(curr_donation_elem);
-		else
-			curr_donation_elem = list_next(curr_donation_elem);
+		heap_update (&t->donors, &lock->donor_elem);
+		priority = donated_priority (t);
+		if (priority == t->priority)
+			break;
+		thread_change_priority (t, priority);
+		changed++;
+
+		/* T도 다른 락을 기다리며 잠들어 있다면 그 락으로 이어집니다. */
+		lock = t->wait_on_lock;
+		if (lock != NULL && t->wait_heap != &lock->waiters.exclusive)
+			lock = NULL;
 	}
+	return changed;
 }
 
+/* HOLDER가 LOCK을 가지고 있고 LOCK에 대기자가 있습니다.  LOCK을
+   HOLDER의 donors 힙에 두고 (이미 락을 놓은 예전 소유자에게 남아
+   있었다면 옮겨 오고) 기부를 사슬 끝까지 전파합니다.  LOCK의 대기
+   힙에 스레드를 넣은 뒤에도 호출합니다.  기부로 우선순위가 바뀐
+   스레드 수, 즉 사슬에서 실제로 전파된 길이를 반환합니다. */
+int
+donate_priority (struct lock *lock, struct thread *holder) {
+	ASSERT (spinlock_held (&donation_lock));
+	ASSERT (holder != NULL);
+
+	if (lock->donee != holder) {
+		remove_with_lock (lock);
+		heap_push (&holder->donors, &lock->donor_elem);
+		lock->donee = holder;
+	}
+	return donation_propagate (lock);
+}
 
-
-void refresh_priority (void)
+/* LOCK이 하던 기부를 거둡니다.  LOCK을 donors 힙에 둔 스레드가
+   현재 스레드가 아니라면 (LOCK을 놓고 아직 정리하지 못한 예전
+   소유자) 그 스레드의 우선순위도 여기서 다시 계산합니다. */
+void
+remove_with_lock (struct lock *lock)
 {
-  struct thread *cur = thread_current ();
+	struct thread *donee = lock->donee;
+
+	ASSERT (spinlock_held (&donation_lock));
 
-  cur->priority = cur->init_priority;
-  
-  if (!list_empty (&cur->donations)) 
-  {
-    struct thread *front = list_entry(list_front (&cur->donations), struct thread, donations_elem);
-    if (front->priority > cur->priority)
-      cur->priority = front->priority;
-  }
+	if (donee == NULL)
+		return;
+	heap_remove (&donee->donors, &lock->donor_elem);
+	lock->donee = NULL;
+	if (donee != thread_current ())
+		thread_change_priority (donee, donated_priority (donee));
 }
 
-void donate_priority_thread(struct thread *t)
+/* 현재 스레드의 우선순위를 원래 값과 남은 기부로 다시 정합니다. */
+void
+refresh_priority (void)
 {
-	int depth = 0;
-	while (t->wait_on_lock != NULL && depth < 8)
-	{
-		struct thread *holder = t->wait_on_lock->holder;
-		if (holder == NULL) break;
-		if (holder->priority < t->priority)
-			holder->priority = t->priority;
-
-		t = holder;
-		depth++;
-	}
+	struct thread *cur = thread_current ();
+
+	ASSERT (spinlock_held (&donation_lock));
+	cur->priority = donated_priority (cur);
 }
@@ -0,0 +1,145 @@
+#include "threads/vmalloc.h"
+#include <bitmap.h>
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include "threads/cpu.h"
+#include "threads/init.h"
+#include "threads/mmu.h"
+#include "threads/palloc.h"
+#include "threads/pte.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
+
+/* vmalloc()입니다 (vmalloc.h).
+
+   VMALLOC_START부터 VMALLOC_END까지의 가상 페이지 중 쓰는 것을
+   vmalloc_map에 표시합니다.  영역은 매핑한 페이지들과 그 뒤의 보호
+   페이지 하나로 이루어지므로, vfree()는 매핑이 끊기는 곳까지 세어
+   크기를 알아냅니다.
+
+   매핑은 base_pml4에 pml4e_walk()로 넣습니다.  이 범위는 KERN_BASE와
+   같은 PML4 슬롯에 있어서, 새로 생기는 페이지 테이블 페이지도 모든
+   프로세스의 페이지 테이블이 함께 봅니다.  매핑을 지울 때는 다른
+   CPU의 TLB에 남은 변환도 cpu_flush_tlb()로 지운 다음에야 물리
+   페이지를 돌려줍니다.
+
+   vmalloc_lock이 비트맵과 페이지 테이블을 함께 보호하고, 한 번에
+   한 스레드만 cpu_flush_tlb()를 부르게 합니다. */
+
+static struct lock vmalloc_lock;
+static struct bitmap *vmalloc_map;      /* 쓰는 가상 페이지들. */
+static size_t vmalloc_hint;             /* 다음 탐색을 시작할 페이지. */
+
+static size_t vunmap (uint8_t *va);
+
+/* vmalloc()을 초기화합니다.  paging_init() 뒤에 불러야 합니다. */
+void
+vmalloc_init (void) {
+	ASSERT (PML4 (VMALLOC_START) == PML4 (KERN_BASE));
+	ASSERT (PML4 (VMALLOC_END - 1) == PML4 (KERN_BASE));
+
+	lock_init_named (&vmalloc_lock, "vmalloc");
+	vmalloc_map = bitmap_create ((VMALLOC_END - VMALLOC_START) / PGSIZE);
+	if (vmalloc_map == NULL)
+		PANIC ("vmalloc_init: out of memory");
+}
+
+/* SIZE 바이트 이상을 가상으로 연속인 페이지들로 할당해 반환합니다.
+   반환값은 페이지 경계에 맞춰져 있습니다.  주소 공간이나 메모리가
+   모자라면, 또는 vmalloc_init() 전이면 NULL을 반환합니다. */
+void *
+vmalloc (size_t size) {
+	size_t page_cnt = DIV_ROUND_UP (size, PGSIZE);
+	size_t idx, i;
+	uint8_t *va = NULL;
+
+	if (size == 0 || vmalloc_map == NULL)
+		return NULL;
+
+	lock_acquire (&vmalloc_lock);
+
+	/* 뒤에 보호 페이지를 하나 더 잡습니다. */
+	idx = bitmap_scan_and_flip (vmalloc_map, vmalloc_hint, page_cnt + 1, false);
+	if (idx == BITMAP_ERROR)
+		idx = bitmap_scan_and_flip (vmalloc_map, 0, page_cnt + 1, false);
+	if (idx == BITMAP_ERROR)
+		goto done;
+	vmalloc_hint = idx + page_cnt + 1;
+	va = (uint8_t *) VMALLOC_START + PGSIZE * idx;
+
+	for (i = 0; i < page_cnt; i++) {
+		void *page = palloc_get_page (0);
+		uint64_t *pte = NULL;
+
+		if (page != NULL)
+			pte = pml4e_walk (base_pml4, (uint64_t) va + PGSIZE * i, 1);
+		if (pte == NULL) {
+			palloc_free_page (page);
+			vunmap (va);
+			bitmap_set_multiple (vmalloc_map, idx, page_cnt + 1, false);
+			va = NULL;
+			goto done;
+		}
+		ASSERT (!(*pte & PTE_P));
+		*pte = vtop (page) | PTE_P | PTE_W;
+	}
+
+done:
+	lock_release (&vmalloc_lock);
+	return va;
+}
+
+/* vmalloc()으로 받은 P를 해제합니다.  P가 NULL이면 아무것도 하지
+   않습니다. */
+void
+vfree (void *p) {
+	size_t page_cnt;
+
+	if (p == NULL)
+		return;
+	ASSERT (is_vmalloc_vaddr (p));
+	ASSERT (pg_ofs (p) == 0);
+
+	lock_acquire (&vmalloc_lock);
+	page_cnt = vunmap (p);
+	ASSERT (page_cnt > 0);
+	bitmap_set_multiple (vmalloc_map, pg_no (p) - pg_no (VMALLOC_START),
+			page_cnt + 1, false);
+	lock_release (&vmalloc_lock);
+}
+
+/* VA부터 매핑이 끊기는 곳까지의 페이지들의 매핑을 지우고 물리
+   페이지를 palloc에 돌려준 뒤, 지운 페이지 수를 반환합니다.
+   vmalloc_lock을 잡고 불러야 합니다. */
+static size_t
+vunmap (uint8_t *va) {
+	void *pages = NULL;
+	size_t cnt = 0;
+	uint64_t *pte;
+
+	/* 다른 CPU가 아직 볼 수 있으므로 TLB를 비우기 전에는 물리
+	   페이지를 돌려주지 않고, 그 첫 워드로 엮어 둡니다. */
+	while ((pte = pml4e_walk (base_pml4, (uint64_t) va, 0)) != NULL
+			&& (*pte & PTE_P)) {
+		void *page = ptov (PTE_ADDR (*pte));
+
+		*pte = 0;
+		*(void **) page = pages;
+		pages = page;
+		va += PGSIZE;
+		cnt++;
+	}
+	if (cnt == 0)
+		return 0;
+
+	cpu_flush_tlb ();
+	while (pages != NULL) {
+		void *next = *(void **) pages;
+
+		palloc_free_page (pages);
+		pages = next;
+	}
+	return cnt;
+}
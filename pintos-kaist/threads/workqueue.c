@@ -0,0 +1,331 @@
+#include "threads/workqueue.h"
+#include <debug.h>
+#include <stdio.h>
+#include "threads/cpu.h"
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+/* 작업 큐입니다 (workqueue.h).
+
+   모든 작업 큐와 지연 작업의 타이머 휠은 work_lock 하나가
+   보호합니다.  작업을 넣고 빼는 일은 짧고 드물기 때문에 락을 나눌
+   이유가 없고, 하나로 두면 작업 항목이 타이머에서 큐로 옮겨 가는
+   동안에도 상태가 한 락 아래에서 바뀝니다.  타이머 인터럽트에서도
+   잡으므로 스핀락이며, 잠든 작업자와 flush 중인 스레드는
+   thread_block_locked()로 이 락을 놓으면서 잠듭니다.
+
+   잠든 스레드는 elem으로 idle 또는 waiters 리스트에 들어갑니다.
+   BLOCKED 상태인 스레드의 elem은 실행 큐에서 쓰이지 않습니다. */
+
+struct workqueue *system_wq;
+int64_t work_next_deadline = INT64_MAX;
+
+static struct spinlock work_lock;
+static struct wheel delay_wheel;
+
+/* 작업을 실행 중인 작업자.  작업자 스레드의 스택에 있습니다.
+   작업 함수가 항목을 해제할 수 있으므로, 실행 중인 작업은 항목이
+   아니라 이 기록으로 추적합니다. */
+struct worker_busy {
+	struct list_elem elem;      /* workqueue의 busy 리스트 원소. */
+	struct work *work;          /* 실행 중인 작업. */
+};
+
+static thread_func worker_main;
+static void enqueue (struct workqueue *, struct work *);
+static bool work_running (struct workqueue *, struct work *);
+static void wait_locked (struct workqueue *);
+static void wake_waiters (struct workqueue *);
+static void fire_delayed (struct wheel_elem *, void *aux);
+
+/* 작업 큐 시스템을 초기화하고 system_wq를 만듭니다.  smp_init()
+   뒤에, 스레드를 만들 수 있게 된 다음 호출해야 합니다. */
+void
+workqueue_init (void) {
+	spinlock_init (&work_lock);
+	wheel_init (&delay_wheel, timer_ticks ());
+
+	system_wq = workqueue_create ("events", PRI_DEFAULT, cpu_cnt);
+	if (system_wq == NULL)
+		PANIC ("can't create the system work queue");
+}
+
+/* 우선순위 PRIORITY의 작업자 스레드 NR_WORKERS개를 가진 작업 큐를
+   만들어 반환합니다.  메모리가 모자라거나 작업자를 하나도 만들지
+   못하면 NULL을 반환합니다.  작업 큐는 해제하지 않습니다. */
+struct workqueue *
+workqueue_create (const char *name, int priority, int nr_workers) {
+	struct workqueue *wq;
+	int i;
+
+	ASSERT (name != NULL);
+	ASSERT (PRI_MIN <= priority && priority <= PRI_MAX);
+	ASSERT (nr_workers > 0);
+
+	wq = malloc (sizeof *wq);
+	if (wq == NULL)
+		return NULL;
+	wq->name = name;
+	wq->priority = priority;
+	wq->nr_workers = 0;
+	list_init (&wq->pending);
+	list_init (&wq->idle);
+	list_init (&wq->busy);
+	list_init (&wq->waiters);
+
+	for (i = 0; i < nr_workers; i++) {
+		char thread_name[16];
+
+		snprintf (thread_name, sizeof thread_name, "%s/%d", name, i);
+		if (thread_create (thread_name, priority, worker_main, wq)
+				== TID_ERROR)
+			break;
+		wq->nr_workers++;
+	}
+	if (wq->nr_workers == 0) {
+		free (wq);
+		return NULL;
+	}
+	return wq;
+}
+
+/* WQ에 들어 있거나 실행 중인 작업이 하나도 없을 때까지 기다립니다.
+   기다리는 동안 새로 들어온 작업도 기다리며, 지연 중인 작업은
+   기다리지 않습니다. */
+void
+workqueue_flush (struct workqueue *wq) {
+	enum intr_level old_level;
+
+	ASSERT (!intr_context ());
+
+	old_level = intr_disable ();
+	spinlock_acquire (&work_lock);
+	while (!list_empty (&wq->pending) || !list_empty (&wq->busy))
+		wait_locked (wq);
+	spinlock_release (&work_lock);
+	intr_set_level (old_level);
+}
+
+/* W가 FUNC (AUX)를 실행하는 작업 항목이 되도록 초기화합니다. */
+void
+work_init (struct work *w, work_func *func, void *aux) {
+	ASSERT (w != NULL);
+	ASSERT (func != NULL);
+
+	w->func = func;
+	w->aux = aux;
+	w->state = WORK_IDLE;
+	w->wq = NULL;
+	wheel_elem_init (&w->timer);
+}
+
+/* W를 WQ에 넣습니다.  W가 이미 큐나 타이머에 들어 있으면 아무것도
+   하지 않고 false를, 넣었으면 true를 반환합니다.  W가 실행 중이어도
+   다시 넣을 수 있습니다.  인터럽트 핸들러에서도 부를 수 있습니다. */
+bool
+work_queue (struct workqueue *wq, struct work *w) {
+	enum intr_level old_level;
+	bool queued;
+
+	ASSERT (wq != NULL);
+
+	old_level = intr_disable ();
+	spinlock_acquire (&work_lock);
+	queued = w->state == WORK_IDLE;
+	if (queued)
+		enqueue (wq, w);
+	spinlock_release (&work_lock);
+	intr_set_level (old_level);
+
+	return queued;
+}
+
+/* TICKS 틱 뒤에 W를 WQ에 넣습니다.  반환값은 work_queue()와
+   같습니다.  인터럽트 핸들러에서도 부를 수 있습니다. */
+bool
+work_queue_delayed (struct workqueue *wq, struct work *w, int64_t ticks) {
+	enum intr_level old_level;
+	int64_t expires;
+	bool queued;
+
+	ASSERT (wq != NULL);
+
+	if (ticks <= 0)
+		return work_queue (wq, w);
+
+	expires = timer_ticks () + ticks;
+	old_level = intr_disable ();
+	spinlock_acquire (&work_lock);
+	queued = w->state == WORK_IDLE;
+	if (queued) {
+		w->state = WORK_DELAYED;
+		w->wq = wq;
+		wheel_insert (&delay_wheel, &w->timer, expires);
+		if (expires < work_next_deadline) {
+			work_next_deadline = expires;
+			cpu_kick (&cpus[0]);        /* BSP가 틱 없이 자고 있으면 깨움. */
+		}
+	}
+	spinlock_release (&work_lock);
+	intr_set_level (old_level);
+
+	return queued;
+}
+
+/* W가 큐나 타이머에 들어 있으면 빼내고 true를, 아니면 false를
+   반환합니다.  이미 실행 중인 작업은 멈추지 않으므로, 끝났음을
+   확인하려면 이어서 work_flush()를 부릅니다. */
+bool
+work_cancel (struct work *w) {
+	enum intr_level old_level;
+	bool cancelled = true;
+
+	old_level = intr_disable ();
+	spinlock_acquire (&work_lock);
+	if (w->state == WORK_DELAYED)
+		wheel_remove (&delay_wheel, &w->timer);
+	else if (w->state == WORK_QUEUED)
+		list_remove (&w->elem);
+	else
+		cancelled = false;
+	w->state = WORK_IDLE;
+	spinlock_release (&work_lock);
+	intr_set_level (old_level);
+
+	return cancelled;
+}
+
+/* W가 큐에 들어 있거나 실행 중이면 실행을 마칠 때까지 기다립니다.
+   지연 중인 작업은 바로 큐에 넣고 기다립니다.  기다렸으면 true를
+   반환합니다.  W의 함수가 W를 해제한다면 쓸 수 없습니다. */
+bool
+work_flush (struct work *w) {
+	enum intr_level old_level;
+	struct workqueue *wq;
+	bool waited = false;
+
+	ASSERT (!intr_context ());
+
+	old_level = intr_disable ();
+	spinlock_acquire (&work_lock);
+	wq = w->wq;
+	if (w->state == WORK_DELAYED) {
+		wheel_remove (&delay_wheel, &w->timer);
+		enqueue (wq, w);
+	}
+	while (wq != NULL && (w->state == WORK_QUEUED || work_running (wq, w))) {
+		wait_locked (wq);
+		waited = true;
+	}
+	spinlock_release (&work_lock);
+	intr_set_level (old_level);
+
+	return waited;
+}
+
+/* TICKS 틱까지 때가 된 지연 작업들을 각자의 큐에 넣습니다.
+   timer_interrupt()에서 work_next_deadline에 도달했을 때만
+   호출됩니다. */
+void
+workqueue_timer (int64_t ticks) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	spinlock_acquire (&work_lock);
+	wheel_advance (&delay_wheel, ticks, fire_delayed, NULL);
+	work_next_deadline = wheel_next_deadline (&delay_wheel);
+	spinlock_release (&work_lock);
+}
+
+/* 작업자 스레드.  WQ_에서 작업을 하나씩 꺼내 실행하고, 일감이
+   없으면 잠듭니다. */
+static void
+worker_main (void *wq_) {
+	struct workqueue *wq = wq_;
+	struct thread *cur = thread_current ();
+
+	for (;;) {
+		struct worker_busy busy;
+		work_func *func;
+		void *aux;
+
+		intr_disable ();
+		spinlock_acquire (&work_lock);
+		while (list_empty (&wq->pending)) {
+			list_push_back (&wq->idle, &cur->elem);
+			thread_block_locked (&work_lock);
+		}
+		busy.work = list_entry (list_pop_front (&wq->pending),
+				struct work, elem);
+		busy.work->state = WORK_IDLE;
+		func = busy.work->func;
+		aux = busy.work->aux;
+		list_push_back (&wq->busy, &busy.elem);
+		spinlock_release (&work_lock);
+		intr_enable ();
+
+		/* 이 뒤로는 항목이 해제되었을 수 있으므로 건드리지 않습니다. */
+		func (aux);
+
+		intr_disable ();
+		spinlock_acquire (&work_lock);
+		list_remove (&busy.elem);
+		wake_waiters (wq);
+		spinlock_release (&work_lock);
+		intr_enable ();
+	}
+}
+
+/* W를 WQ의 pending 리스트 끝에 넣고, 잠든 작업자가 있으면 하나
+   깨웁니다.  work_lock을 잡은 상태에서 호출해야 합니다. */
+static void
+enqueue (struct workqueue *wq, struct work *w) {
+	ASSERT (spinlock_held (&work_lock));
+
+	w->state = WORK_QUEUED;
+	w->wq = wq;
+	list_push_back (&wq->pending, &w->elem);
+	if (!list_empty (&wq->idle))
+		thread_unblock (list_entry (list_pop_front (&wq->idle),
+					struct thread, elem));
+}
+
+/* WQ의 작업자가 W를 실행 중이면 true.  work_lock을 잡은 상태에서
+   호출해야 합니다. */
+static bool
+work_running (struct workqueue *wq, struct work *w) {
+	struct list_elem *e;
+
+	for (e = list_begin (&wq->busy); e != list_end (&wq->busy);
+			e = list_next (e))
+		if (list_entry (e, struct worker_busy, elem)->work == w)
+			return true;
+	return false;
+}
+
+/* WQ에서 작업 하나가 끝날 때까지 잠듭니다.  work_lock을 잡은
+   상태에서 호출해야 하고, 돌아올 때도 잡고 있습니다. */
+static void
+wait_locked (struct workqueue *wq) {
+	list_push_back (&wq->waiters, &thread_current ()->elem);
+	thread_block_locked (&work_lock);
+}
+
+/* WQ의 flush를 기다리는 스레드를 모두 깨웁니다.  각자 조건을 다시
+   확인합니다.  work_lock을 잡은 상태에서 호출해야 합니다. */
+static void
+wake_waiters (struct workqueue *wq) {
+	while (!list_empty (&wq->waiters))
+		thread_unblock (list_entry (list_pop_front (&wq->waiters),
+					struct thread, elem));
+}
+
+/* 때가 된 지연 작업을 큐에 넣는 wheel_action_func입니다. */
+static void
+fire_delayed (struct wheel_elem *e, void *aux UNUSED) {
+	struct work *w = wheel_entry (e, struct work, timer);
+
+	enqueue (w->wq, w);
+}
@@ -13,10 +13,12 @@
 #include "threads/flags.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
 #include "threads/vaddr.h"
+#include "threads/workqueue.h"
 #include "intrinsic.h"
 #ifdef VM
 #include "vm/vm.h"
@@ -26,6 +28,7 @@ static void process_cleanup (void);
 static bool load (const char *file_name, struct intr_frame *if_);
 static void initd (void *f_name);
 static void __do_fork (void *);
+static void pml4_destroy_later (uint64_t *pml4);
 
 /* General process initializer for initd and other process. */
 static void
@@ -152,8 +155,10 @@ __do_fork (void *aux) {
 	process_init ();
 
 	/* Finally, switch to the newly created process. */
-	if (succ)
+	if (succ) {
+		thread_move_to_bsp ();
 		do_iret (&if_);
+	}
 error:
 	thread_exit ();
 }
@@ -185,6 +190,7 @@ process_exec (void *f_name) {
 		return -1;
 
 	/* Start switched process. */
+	thread_move_to_bsp ();
 	do_iret (&_if);
 	NOT_REACHED ();
 }
@@ -242,8 +248,41 @@ process_cleanup (void) {
 		 * that's been freed (and cleared). */
 		curr->pml4 = NULL;
 		pml4_activate (NULL);
+		pml4_destroy_later (pml4);
+	}
+}
+
+/* A page table handed to a worker thread to tear down. */
+struct pml4_teardown {
+	struct work work;
+	uint64_t *pml4;
+};
+
+/* Work function that destroys the page table in a struct
+   pml4_teardown and frees the structure. */
+static void
+pml4_teardown (void *td_) {
+	struct pml4_teardown *td = td_;
+
+	pml4_destroy (td->pml4);
+	free (td);
+}
+
+/* Destroys PML4, which must no longer be active anywhere, on
+   the system work queue so that an exiting process does not pay
+   for freeing every page it used.  Destroys it right away if
+   there is no memory to queue the work. */
+static void
+pml4_destroy_later (uint64_t *pml4) {
+	struct pml4_teardown *td = malloc (sizeof *td);
+
+	if (td == NULL) {
 		pml4_destroy (pml4);
+		return;
 	}
+	td->pml4 = pml4;
+	work_init (&td->work, pml4_teardown, td);
+	work_queue (system_wq, &td->work);
 }
 
 /* Sets up the CPU for running user code in the nest thread.
@@ -2,6 +2,7 @@
 #include <debug.h>
 #include <stddef.h>
 #include "userprog/gdt.h"
+#include "threads/cpu.h"
 #include "threads/thread.h"
 #include "threads/palloc.h"
 #include "threads/vaddr.h"
@@ -55,6 +56,7 @@ tss_init (void) {
 	 * few fields of it are ever referenced, and those are the only
 	 * ones we initialize. */
 	tss = palloc_get_page (PAL_ASSERT | PAL_ZERO);
+	cpus[0].tss = tss;
 	tss_update (thread_current ());
 }
 
@@ -66,9 +68,12 @@ tss_get (void) {
 }
 
 /* Sets the ring 0 stack pointer in the TSS to point to the end
- * of the thread stack. */
+ * of the thread stack.  Only the BSP has a TSS, since user
+ * processes run only there; on other CPUs this does nothing. */
 void
 tss_update (struct thread *next) {
-	ASSERT (tss != NULL);
-	tss->rsp0 = (uint64_t) next + PGSIZE;
+	struct task_state *cpu_tss = this_cpu ()->tss;
+
+	if (cpu_tss != NULL)
+		cpu_tss->rsp0 = (uint64_t) next + PGSIZE;
 }